@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//! \file
+
+#ifndef TNT_FILAMENT_BACKEND_PROGRAMBINARYARCHIVE_H
+#define TNT_FILAMENT_BACKEND_PROGRAMBINARYARCHIVE_H
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament::backend {
+
+class Platform;
+
+/**
+ * ProgramBinaryArchive is an in-memory implementation of the Platform blob cache, which can be
+ * saved to and loaded from a single buffer.
+ *
+ * Backends that support program binaries (currently OpenGL) store them through the blob cache
+ * the first time a program is compiled. By default, nothing is cached unless the application
+ * provides its own blob functions, so the first session on a device pays the full cost of
+ * compiling every program.
+ *
+ * An archive can be captured offline: attach an empty archive, exercise all the materials of
+ * the application (for instance with a scripted run), then serialize the archive. The archive is
+ * then shipped with the application, loaded at startup and attached to the Platform before the
+ * Engine is created, which warms up the cache in bulk.
+ *
+ * Binaries are keyed by the driver and GPU that produced them, so a single archive can hold the
+ * captures of several devices; entries captured on other devices are simply never used.
+ *
+ * All methods are thread-safe.
+ *
+ * @see Platform::setBlobFunc, Engine::Builder::programBinaryArchive
+ */
+class UTILS_PUBLIC ProgramBinaryArchive {
+public:
+    ProgramBinaryArchive() noexcept;
+    ~ProgramBinaryArchive() noexcept;
+
+    ProgramBinaryArchive(ProgramBinaryArchive const& rhs) = delete;
+    ProgramBinaryArchive& operator=(ProgramBinaryArchive const& rhs) = delete;
+
+    /**
+     * Adds the entries of a serialized archive to this archive.
+     *
+     * @param data  the archive, as produced by serialize()
+     * @param size  size of the archive in bytes
+     * @return false if the data is not a valid archive, in which case nothing is added
+     */
+    bool load(const void* UTILS_NONNULL data, size_t size) noexcept;
+
+    /**
+     * Sets the blob functions of the given platform so that the backend reads binaries from this
+     * archive and adds the ones it compiles to it. This replaces any previous blob function.
+     * The archive must outlive the platform.
+     */
+    void attach(Platform& platform) noexcept;
+
+    /**
+     * Adds or replaces an entry, see Platform::insertBlob.
+     */
+    void insert(const void* UTILS_NONNULL key, size_t keySize,
+            const void* UTILS_NONNULL value, size_t valueSize) noexcept;
+
+    /**
+     * Retrieves an entry, see Platform::retrieveBlob.
+     */
+    size_t retrieve(const void* UTILS_NONNULL key, size_t keySize,
+            void* UTILS_NONNULL value, size_t valueSize) const noexcept;
+
+    /**
+     * @return the number of entries in the archive.
+     */
+    size_t getEntryCount() const noexcept;
+
+    /**
+     * @return the size in bytes needed by serialize().
+     */
+    size_t getSerializedSize() const noexcept;
+
+    /**
+     * Writes the archive to the given buffer.
+     *
+     * @param buffer  a buffer of at least getSerializedSize() bytes
+     * @param size    size of the buffer in bytes
+     * @return the number of bytes written, or 0 if the buffer is too small
+     */
+    size_t serialize(void* UTILS_NONNULL buffer, size_t size) const noexcept;
+
+private:
+    struct Impl;
+    Impl* UTILS_NONNULL mImpl;
+};
+
+} // namespace filament::backend
+
+#endif // TNT_FILAMENT_BACKEND_PROGRAMBINARYARCHIVE_H
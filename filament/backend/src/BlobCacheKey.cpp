@@ -21,13 +21,14 @@
 namespace filament::backend {
 
 struct BlobCacheKey::Key {
+    uint64_t driverId;
     uint64_t id;
     Program::SpecializationConstant constants[];
 };
 
 BlobCacheKey::BlobCacheKey() noexcept = default;
 
-BlobCacheKey::BlobCacheKey(uint64_t id,
+BlobCacheKey::BlobCacheKey(uint64_t driverId, uint64_t id,
         BlobCacheKey::SpecializationConstants const& specConstants) {
     mSize = sizeof(Key) + sizeof(Key::constants[0]) * specConstants.size();
 
@@ -35,6 +36,7 @@ BlobCacheKey::BlobCacheKey(uint64_t id,
     memset(pKey, 0, mSize);
     mData.reset(pKey, ::free);
 
+    mData->driverId = driverId;
     mData->id = id;
     for (size_t i = 0; i < specConstants.size(); i++) {
         mData->constants[i] = specConstants[i];
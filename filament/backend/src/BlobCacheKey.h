@@ -26,7 +26,10 @@ public:
     using SpecializationConstants = utils::FixedCapacityVector<Program::SpecializationConstant>;
 
     BlobCacheKey() noexcept;
-    BlobCacheKey(uint64_t id, SpecializationConstants const& specConstants);
+
+    // driverId identifies the driver and GPU, so that the binaries of different devices can be
+    // stored together.
+    BlobCacheKey(uint64_t driverId, uint64_t id, SpecializationConstants const& specConstants);
 
     BlobCacheKey(BlobCacheKey const& rhs) = default;
     BlobCacheKey& operator=(BlobCacheKey const& rhs) = default;
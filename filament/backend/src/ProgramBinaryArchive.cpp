@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//! \file
+
+#include <backend/ProgramBinaryArchive.h>
+
+#include <backend/Platform.h>
+
+#include <utils/Mutex.h>
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace filament::backend {
+
+/*
+ * Archive layout, in native byte order:
+ *
+ *   uint32_t magic
+ *   uint32_t version
+ *   uint32_t entryCount
+ *   entryCount times:
+ *      uint32_t keySize
+ *      uint32_t valueSize
+ *      uint8_t  key[keySize]
+ *      uint8_t  value[valueSize]
+ */
+static constexpr uint32_t ARCHIVE_MAGIC = 0x41425046; // 'FPBA'
+static constexpr uint32_t ARCHIVE_VERSION = 1;
+
+struct ProgramBinaryArchive::Impl {
+    mutable utils::Mutex lock;
+    // keys and values are opaque binary strings
+    std::unordered_map<std::string, std::string> entries;
+
+    // must be called with the lock held
+    size_t getSerializedSize() const noexcept {
+        size_t size = 3 * sizeof(uint32_t);
+        for (auto const& [key, value] : entries) {
+            size += 2 * sizeof(uint32_t) + key.size() + value.size();
+        }
+        return size;
+    }
+};
+
+namespace {
+
+class Reader {
+public:
+    Reader(const void* data, size_t size) noexcept
+            : mCurrent(static_cast<const uint8_t*>(data)), mEnd(mCurrent + size) {
+    }
+
+    bool read(uint32_t* value) noexcept {
+        if (size_t(mEnd - mCurrent) < sizeof(uint32_t)) {
+            return false;
+        }
+        memcpy(value, mCurrent, sizeof(uint32_t));
+        mCurrent += sizeof(uint32_t);
+        return true;
+    }
+
+    bool read(std::string_view* value, size_t size) noexcept {
+        if (size_t(mEnd - mCurrent) < size) {
+            return false;
+        }
+        *value = { reinterpret_cast<const char*>(mCurrent), size };
+        mCurrent += size;
+        return true;
+    }
+
+private:
+    const uint8_t* mCurrent;
+    const uint8_t* const mEnd;
+};
+
+void write(uint8_t*& out, void const* data, size_t size) noexcept {
+    memcpy(out, data, size);
+    out += size;
+}
+
+void write(uint8_t*& out, uint32_t value) noexcept {
+    write(out, &value, sizeof(value));
+}
+
+} // anonymous namespace
+
+ProgramBinaryArchive::ProgramBinaryArchive() noexcept : mImpl(new Impl) {
+}
+
+ProgramBinaryArchive::~ProgramBinaryArchive() noexcept {
+    delete mImpl;
+}
+
+bool ProgramBinaryArchive::load(const void* data, size_t size) noexcept {
+    Reader reader(data, size);
+    uint32_t magic = 0, version = 0, count = 0;
+    if (!reader.read(&magic) || !reader.read(&version) || !reader.read(&count) ||
+            magic != ARCHIVE_MAGIC || version != ARCHIVE_VERSION) {
+        return false;
+    }
+
+    // validate the whole archive before adding anything to it
+    std::unordered_map<std::string, std::string> entries;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t keySize = 0, valueSize = 0;
+        std::string_view key, value;
+        if (!reader.read(&keySize) || !reader.read(&valueSize) ||
+                !reader.read(&key, keySize) || !reader.read(&value, valueSize)) {
+            return false;
+        }
+        entries.insert_or_assign(std::string(key), std::string(value));
+    }
+
+    std::lock_guard const guard(mImpl->lock);
+    if (mImpl->entries.empty()) {
+        mImpl->entries = std::move(entries);
+    } else {
+        for (auto& entry : entries) {
+            mImpl->entries.insert_or_assign(entry.first, std::move(entry.second));
+        }
+    }
+    return true;
+}
+
+void ProgramBinaryArchive::attach(Platform& platform) noexcept {
+    platform.setBlobFunc(
+            [this](const void* key, size_t keySize, const void* value, size_t valueSize) {
+                insert(key, keySize, value, valueSize);
+            },
+            [this](const void* key, size_t keySize, void* value, size_t valueSize) {
+                return retrieve(key, keySize, value, valueSize);
+            });
+}
+
+void ProgramBinaryArchive::insert(const void* key, size_t keySize,
+        const void* value, size_t valueSize) noexcept {
+    std::string k(static_cast<const char*>(key), keySize);
+    std::string v(static_cast<const char*>(value), valueSize);
+    std::lock_guard const guard(mImpl->lock);
+    mImpl->entries.insert_or_assign(std::move(k), std::move(v));
+}
+
+size_t ProgramBinaryArchive::retrieve(const void* key, size_t keySize,
+        void* value, size_t valueSize) const noexcept {
+    std::string const k(static_cast<const char*>(key), keySize);
+    std::lock_guard const guard(mImpl->lock);
+    auto const pos = mImpl->entries.find(k);
+    if (pos == mImpl->entries.end()) {
+        return 0;
+    }
+    std::string const& v = pos->second;
+    if (v.size() <= valueSize) {
+        memcpy(value, v.data(), v.size());
+    }
+    return v.size();
+}
+
+size_t ProgramBinaryArchive::getEntryCount() const noexcept {
+    std::lock_guard const guard(mImpl->lock);
+    return mImpl->entries.size();
+}
+
+size_t ProgramBinaryArchive::getSerializedSize() const noexcept {
+    std::lock_guard const guard(mImpl->lock);
+    return mImpl->getSerializedSize();
+}
+
+size_t ProgramBinaryArchive::serialize(void* buffer, size_t size) const noexcept {
+    std::lock_guard const guard(mImpl->lock);
+    // entries may have been added since getSerializedSize() was called
+    size_t const serializedSize = mImpl->getSerializedSize();
+    if (serializedSize > size) {
+        return 0;
+    }
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    write(out, ARCHIVE_MAGIC);
+    write(out, ARCHIVE_VERSION);
+    write(out, uint32_t(mImpl->entries.size()));
+    for (auto const& [key, value] : mImpl->entries) {
+        write(out, uint32_t(key.size()));
+        write(out, uint32_t(value.size()));
+        write(out, key.data(), key.size());
+        write(out, value.data(), value.size());
+    }
+    return serializedSize;
+}
+
+} // namespace filament::backend
@@ -21,8 +21,11 @@
 #include <backend/Platform.h>
 #include <backend/Program.h>
 
+#include <utils/Hash.h>
 #include <utils/Systrace.h>
 
+#include <string_view>
+
 namespace filament::backend {
 
 struct OpenGLBlobCache::Blob {
@@ -30,8 +33,21 @@ struct OpenGLBlobCache::Blob {
     char data[];
 };
 
+// Program binaries are only valid for the driver and GPU that produced them.
+static uint64_t getDriverId(OpenGLContext const& gl) noexcept {
+    auto hash = [](const char* s, uint32_t seed) -> uint32_t {
+        std::string_view const str{ s ? s : "" };
+        return str.empty() ? seed : utils::hash::murmurSlow(
+                reinterpret_cast<uint8_t const*>(str.data()), str.size(), seed);
+    };
+    uint32_t const device = hash(gl.state.renderer, hash(gl.state.vendor, 0));
+    uint32_t const driver = hash(gl.state.version, device);
+    return (uint64_t(device) << 32u) | driver;
+}
+
 OpenGLBlobCache::OpenGLBlobCache(OpenGLContext& gl) noexcept
-    : mCachingSupported(gl.gets.num_program_binary_formats >= 1) {
+    : mDriverId(getDriverId(gl)),
+      mCachingSupported(gl.gets.num_program_binary_formats >= 1) {
 }
 
 GLuint OpenGLBlobCache::retrieve(BlobCacheKey* outKey, Platform& platform,
@@ -45,7 +61,7 @@ GLuint OpenGLBlobCache::retrieve(BlobCacheKey* outKey, Platform& platform,
     GLuint programId = 0;
 
 #ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
-    BlobCacheKey key{ program.getCacheId(), program.getSpecializationConstants() };
+    BlobCacheKey key{ mDriverId, program.getCacheId(), program.getSpecializationConstants() };
 
     // FIXME: use a static buffer to avoid systematic allocation
     // always attempt with 64 KiB
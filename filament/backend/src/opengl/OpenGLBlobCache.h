@@ -39,6 +39,7 @@ public:
 
 private:
     struct Blob;
+    uint64_t mDriverId = 0;
     bool mCachingSupported = false;
 };
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <backend/ProgramBinaryArchive.h>
+#include <backend/Program.h>
+
+#include "BlobCacheKey.h"
+
+#include <utils/FixedCapacityVector.h>
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace filament::backend;
+
+class ProgramBinaryArchiveTest : public testing::Test {};
+
+static constexpr uint64_t kDriverId = 0x1234567800000001;
+static constexpr uint64_t kOtherDriverId = 0x1234567800000002;
+
+static BlobCacheKey createKey(uint64_t driverId, uint64_t cacheId, bool useConstant) {
+    BlobCacheKey::SpecializationConstants constants;
+    if (useConstant) {
+        constants = BlobCacheKey::SpecializationConstants::with_capacity(1);
+        constants.push_back({ 0, int32_t(42) });
+    }
+    return { driverId, cacheId, constants };
+}
+
+static std::string retrieve(ProgramBinaryArchive const& archive, BlobCacheKey const& key) {
+    // the first call only queries the size of the entry
+    char probe;
+    size_t const size = archive.retrieve(key.data(), key.size(), &probe, 0);
+    std::string value(size, '\0');
+    if (size) {
+        archive.retrieve(key.data(), key.size(), value.data(), value.size());
+    }
+    return value;
+}
+
+static std::vector<uint8_t> serialize(ProgramBinaryArchive const& archive) {
+    std::vector<uint8_t> data(archive.getSerializedSize());
+    size_t const size = archive.serialize(data.data(), data.size());
+    EXPECT_EQ(size, data.size());
+    return data;
+}
+
+TEST_F(ProgramBinaryArchiveTest, RoundTrip) { // NOLINT
+    BlobCacheKey const key0 = createKey(kDriverId, 1, false);
+    BlobCacheKey const key1 = createKey(kDriverId, 2, true);
+    std::string const value0 = "first program binary";
+    std::string const value1(100000, 'x');
+
+    ProgramBinaryArchive archive;
+    archive.insert(key0.data(), key0.size(), value0.data(), value0.size());
+    archive.insert(key1.data(), key1.size(), value1.data(), value1.size());
+    ASSERT_EQ(archive.getEntryCount(), 2);
+    std::vector<uint8_t> const data = serialize(archive);
+
+    ProgramBinaryArchive copy;
+    ASSERT_TRUE(copy.load(data.data(), data.size()));
+    EXPECT_EQ(copy.getEntryCount(), 2);
+    EXPECT_EQ(retrieve(copy, key0), value0);
+    EXPECT_EQ(retrieve(copy, key1), value1);
+    // entries are not serialized in any particular order
+    EXPECT_EQ(copy.getSerializedSize(), data.size());
+
+    // A buffer that is too small is not written to.
+    std::vector<uint8_t> small(data.size() - 1);
+    EXPECT_EQ(archive.serialize(small.data(), small.size()), 0);
+}
+
+TEST_F(ProgramBinaryArchiveTest, RejectsOtherDrivers) { // NOLINT
+    BlobCacheKey const key = createKey(kDriverId, 1, false);
+    std::string const value = "program binary";
+
+    ProgramBinaryArchive archive;
+    archive.insert(key.data(), key.size(), value.data(), value.size());
+    std::vector<uint8_t> const data = serialize(archive);
+
+    ProgramBinaryArchive copy;
+    ASSERT_TRUE(copy.load(data.data(), data.size()));
+
+    // The same program built by another driver or GPU is never served from the archive.
+    BlobCacheKey const otherKey = createKey(kOtherDriverId, 1, false);
+    char buffer[64];
+    EXPECT_EQ(copy.retrieve(otherKey.data(), otherKey.size(), buffer, sizeof(buffer)), 0);
+    EXPECT_EQ(retrieve(copy, key), value);
+
+    // Other specialization constants make another program too.
+    BlobCacheKey const constantKey = createKey(kDriverId, 1, true);
+    EXPECT_EQ(copy.retrieve(constantKey.data(), constantKey.size(), buffer, sizeof(buffer)), 0);
+}
+
+TEST_F(ProgramBinaryArchiveTest, RejectsInvalidArchives) { // NOLINT
+    BlobCacheKey const key = createKey(kDriverId, 1, false);
+    std::string const value = "program binary";
+
+    ProgramBinaryArchive archive;
+    archive.insert(key.data(), key.size(), value.data(), value.size());
+    std::vector<uint8_t> const data = serialize(archive);
+
+    // Truncated archives are rejected as a whole.
+    ProgramBinaryArchive copy;
+    EXPECT_FALSE(copy.load(data.data(), data.size() - 1));
+    EXPECT_FALSE(copy.load(data.data(), 4));
+    EXPECT_EQ(copy.getEntryCount(), 0);
+
+    // So are archives with another magic number or version.
+    for (size_t offset : { 0, 4 }) {
+        std::vector<uint8_t> other = data;
+        other[offset] ^= 0xFF;
+        EXPECT_FALSE(copy.load(other.data(), other.size()));
+    }
+    EXPECT_EQ(copy.getEntryCount(), 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -21,6 +21,7 @@
 
 #include <backend/DriverEnums.h>
 #include <backend/Platform.h>
+#include <backend/ProgramBinaryArchive.h>
 
 #include <utils/compiler.h>
 #include <utils/Invocable.h>
@@ -61,6 +62,7 @@ class Texture;
 class VertexBuffer;
 class View;
 class InstanceBuffer;
+class MaterialLibrary;
 
 class LightManager;
 class RenderableManager;
@@ -179,6 +181,7 @@ class UTILS_PUBLIC Engine {
     struct BuilderDetails;
 public:
     using Platform = backend::Platform;
+    using ProgramBinaryArchive = backend::ProgramBinaryArchive;
     using Backend = backend::Backend;
     using DriverConfig = backend::Platform::DriverConfig;
     using FeatureLevel = backend::FeatureLevel;
@@ -489,6 +492,22 @@ public:
          */
         Builder& paused(bool paused) noexcept;
 
+        /**
+         * Warms up the program binary cache with an archive, typically captured offline and
+         * shipped with the application. The archive is attached to the Platform before the
+         * backend is initialized; programs compiled during the lifetime of the Engine are added
+         * to it, so it can also be used to capture an archive.
+         *
+         * This replaces the blob functions of the Platform, see Platform::setBlobFunc.
+         * Only the OpenGL backend uses program binaries.
+         *
+         * @param archive The archive to use, its lifetime must exceed the lifetime of the Engine.
+         * @return A reference to this Builder for chaining calls.
+         *
+         * @see ProgramBinaryArchive
+         */
+        Builder& programBinaryArchive(ProgramBinaryArchive* UTILS_NULLABLE archive) noexcept;
+
         /**
          * Set a feature flag value. This is the only way to set constant feature flags.
          * @param name feature name
@@ -887,6 +906,7 @@ public:
     bool destroy(const RenderTarget* UTILS_NULLABLE p);     //!< Destroys a RenderTarget object.
     bool destroy(const View* UTILS_NULLABLE p);             //!< Destroys a View object.
     bool destroy(const InstanceBuffer* UTILS_NULLABLE p);   //!< Destroys an InstanceBuffer object.
+    bool destroy(const MaterialLibrary* UTILS_NULLABLE p);  //!< Destroys a MaterialLibrary object.
     void destroy(utils::Entity e);    //!< Destroys all filament-known components from this entity
 
     /** Tells whether a BufferObject object is valid */
@@ -934,6 +954,8 @@ public:
     bool isValid(const View* UTILS_NULLABLE p) const;
     /** Tells whether an InstanceBuffer object is valid */
     bool isValid(const InstanceBuffer* UTILS_NULLABLE p) const;
+    /** Tells whether a MaterialLibrary object is valid */
+    bool isValid(const MaterialLibrary* UTILS_NULLABLE p) const;
 
     /**
      * Retrieve the count of each resource tracked by Engine.
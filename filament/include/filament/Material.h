@@ -48,6 +48,7 @@ class TextureSampler;
 
 class FEngine;
 class FMaterial;
+class MaterialLibrary;
 
 class Engine;
 
@@ -112,6 +113,31 @@ public:
          */
         Builder& package(const void* UTILS_NONNULL payload, size_t size);
 
+        /**
+         * Specifies the material data from a material library. The library must stay valid
+         * until build() is called.
+         *
+         * @param library The MaterialLibrary holding the material.
+         * @param name Name of the material in the library.
+         *
+         * @exception utils::PreConditionPanic if the library has no material with this name.
+         * @see MaterialLibrary
+         */
+        Builder& package(MaterialLibrary const& library, const char* UTILS_NONNULL name);
+
+        /**
+         * Tells the Material that the data passed to package() outlives it and is never modified,
+         * for instance because it is memory-mapped or embedded in the application. The Material
+         * then reads the data in place instead of taking a copy of it, which reduces its load time
+         * and memory footprint. The data must be 8-byte aligned, otherwise it is copied anyway.
+         * Materials created from a MaterialLibrary ignore this flag and always take a copy, since
+         * the library can be destroyed before them.
+         *
+         * @param persistent Whether the material data outlives the Material. Default is false.
+         * @return Reference to this Builder for chaining calls.
+         */
+        Builder& persistentPackage(bool persistent) noexcept;
+
         template<typename T>
         using is_supported_constant_parameter_t = typename std::enable_if<
                 std::is_same<int32_t, T>::value ||
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_MATERIALLIBRARY_H
+#define TNT_FILAMENT_MATERIALLIBRARY_H
+
+#include <filament/FilamentAPI.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+
+namespace filament {
+
+class Engine;
+
+/**
+ * A MaterialLibrary holds several compiled materials that share a single shader dictionary.
+ *
+ * Material libraries are produced by `matedit library` from materials compiled with matc. Shaders
+ * and shader lines that are identical across materials are stored only once, which makes a library
+ * much smaller than the materials it contains, and faster to load.
+ *
+ * The library is loaded once; materials are then created from it with
+ * Material::Builder::package(MaterialLibrary const&, const char*). Materials do not reference the
+ * library after they are built, so the library can be destroyed as soon as all the materials
+ * needed by the application have been created.
+ *
+ * @see Material::Builder::package
+ */
+class UTILS_PUBLIC MaterialLibrary : public FilamentAPI {
+    struct BuilderDetails;
+
+public:
+    class Builder : public BuilderBase<BuilderDetails> {
+        friend struct BuilderDetails;
+    public:
+        Builder() noexcept;
+        Builder(Builder const& rhs) noexcept;
+        Builder(Builder&& rhs) noexcept;
+        ~Builder() noexcept;
+        Builder& operator=(Builder const& rhs) noexcept;
+        Builder& operator=(Builder&& rhs) noexcept;
+
+        /**
+         * Specifies the library data, as produced by `matedit library`.
+         *
+         * @param payload Pointer to the library data, must stay valid until build() is called.
+         * @param size Size of the library data pointed to by "payload" in bytes.
+         */
+        Builder& package(const void* UTILS_NONNULL payload, size_t size);
+
+        /**
+         * Creates the MaterialLibrary object and returns a pointer to it.
+         *
+         * @param engine Reference to the filament::Engine to associate this MaterialLibrary with.
+         *
+         * @return pointer to the newly created object or nullptr if exceptions are disabled and
+         *         an error occurred.
+         *
+         * @exception utils::PreConditionPanic if the library data could not be parsed.
+         */
+        MaterialLibrary* UTILS_NULLABLE build(Engine& engine);
+
+    private:
+        friend class FMaterialLibrary;
+    };
+
+    /**
+     * Returns the number of materials in this library.
+     */
+    size_t getMaterialCount() const noexcept;
+
+    /**
+     * Returns the name of a material in this library.
+     *
+     * @param index Index of the material, must be smaller than getMaterialCount().
+     * @return The name of the material, which is the name of the file it was compiled to, without
+     *         the extension. The string is owned by the library.
+     */
+    const char* UTILS_NONNULL getMaterialName(size_t index) const noexcept;
+
+    /**
+     * Tells whether this library contains a material with the given name.
+     */
+    bool hasMaterial(const char* UTILS_NONNULL name) const noexcept;
+
+protected:
+    // prevent heap allocation
+    ~MaterialLibrary() = default;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_MATERIALLIBRARY_H
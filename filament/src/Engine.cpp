@@ -204,6 +204,10 @@ bool Engine::destroy(const InstanceBuffer* p) {
     return downcast(this)->destroy(downcast(p));
 }
 
+bool Engine::destroy(const MaterialLibrary* p) {
+    return downcast(this)->destroy(downcast(p));
+}
+
 void Engine::destroy(Entity e) {
     downcast(this)->destroy(e);
 }
@@ -268,6 +272,9 @@ bool Engine::isValid(const View* p) const {
 bool Engine::isValid(const InstanceBuffer* p) const {
     return downcast(this)->isValid(downcast(p));
 }
+bool Engine::isValid(const MaterialLibrary* p) const {
+    return downcast(this)->isValid(downcast(p));
+}
 
 size_t Engine::getBufferObjectCount() const noexcept {
     return downcast(this)->getBufferObjectCount();
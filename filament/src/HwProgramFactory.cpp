@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HwProgramFactory.h"
+
+#include <backend/DriverApiForward.h>
+#include <backend/Handle.h>
+#include <backend/Program.h>
+
+#include <private/backend/DriverApi.h>
+
+#include <utils/compiler.h>
+#include <utils/debug.h>
+#include <utils/Hash.h>
+
+#include <algorithm>
+#include <utility>
+#include <variant>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace filament {
+
+using namespace utils;
+using namespace backend;
+
+// Constants are compared bit-wise, so that equal keys always have the same hash.
+static uint32_t getConstantBits(Program::SpecializationConstant const& constant) noexcept {
+    return std::visit([](auto value) {
+        uint32_t bits = 0;
+        static_assert(sizeof(value) <= sizeof(bits));
+        memcpy(&bits, &value, sizeof(value));
+        return bits;
+    }, constant.value);
+}
+
+size_t HwProgramFactory::Parameters::hash() const noexcept {
+    size_t seed = packageId;
+    hash::combine(seed, variant.key);
+    for (auto const& constant : constants) {
+        hash::combine(seed, (uint64_t(constant.id) << 32u) | getConstantBits(constant));
+    }
+    return seed;
+}
+
+bool operator==(HwProgramFactory::Parameters const& lhs,
+        HwProgramFactory::Parameters const& rhs) noexcept {
+    return lhs.packageId == rhs.packageId &&
+           lhs.variant == rhs.variant &&
+           std::equal(lhs.constants.begin(), lhs.constants.end(),
+                   rhs.constants.begin(), rhs.constants.end(),
+                   [](auto const& a, auto const& b) {
+                       return a.id == b.id && a.value.index() == b.value.index() &&
+                              getConstantBits(a) == getConstantBits(b);
+                   });
+}
+
+// ------------------------------------------------------------------------------------------------
+
+HwProgramFactory::HwProgramFactory()
+        : mArena("HwProgramFactory::mArena", SET_ARENA_SIZE),
+          mBimap(mArena) {
+    mBimap.reserve(256);
+}
+
+HwProgramFactory::~HwProgramFactory() noexcept = default;
+
+void HwProgramFactory::terminate(DriverApi&) noexcept {
+    assert_invariant(mBimap.empty());
+    assert_invariant(mPackages.empty());
+}
+
+uint32_t HwProgramFactory::acquirePackage(uint64_t cacheId, const void* data, size_t size,
+        const void* dictionary) {
+    auto [first, last] = mPackages.equal_range(cacheId);
+    for (auto it = first; it != last; ++it) {
+        Package& package = it->second;
+        const void* const other = package.users.front();
+        if (package.size == size && package.dictionary == dictionary &&
+                (other == data || !memcmp(other, data, size))) {
+            package.users.push_back(data);
+            return package.id;
+        }
+    }
+    uint32_t const id = mNextPackageId++;
+    mPackages.emplace(cacheId, Package{ id, size, dictionary, { data } });
+    return id;
+}
+
+void HwProgramFactory::releasePackage(uint64_t cacheId, uint32_t packageId,
+        const void* data) noexcept {
+    auto [first, last] = mPackages.equal_range(cacheId);
+    for (auto it = first; it != last; ++it) {
+        auto& users = it->second.users;
+        if (it->second.id == packageId) {
+            auto pos = std::find(users.begin(), users.end(), data);
+            assert_invariant(pos != users.end());
+            users.erase(pos);
+            if (users.empty()) {
+                mPackages.erase(it);
+            }
+            return;
+        }
+    }
+    assert_invariant(false);
+}
+
+auto HwProgramFactory::acquire(Parameters const& params) noexcept -> Handle {
+    auto pos = mBimap.find(Key{ params });
+    if (pos == mBimap.end()) {
+        return {};
+    }
+    ++(pos->first.pKey->refs);
+    return pos->second.handle;
+}
+
+auto HwProgramFactory::create(DriverApi& driver, Parameters const& params,
+        Program&& program) noexcept -> Handle {
+    Key const key{ params };
+    assert_invariant(mBimap.find(key) == mBimap.end());
+    auto handle = driver.createProgram(std::move(program));
+    mBimap.insert(key, { handle });
+    return handle;
+}
+
+void HwProgramFactory::destroy(DriverApi& driver, Handle handle) noexcept {
+    // look for this handle in our map
+    auto pos = mBimap.find(Value{ handle });
+    if (--pos->second.pKey->refs == 0) {
+        mBimap.erase(pos);
+        driver.destroyProgram(std::move(handle));
+    }
+}
+
+} // namespace filament
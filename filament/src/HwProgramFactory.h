@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_HWPROGRAMFACTORY_H
+#define TNT_FILAMENT_HWPROGRAMFACTORY_H
+
+#include "Bimap.h"
+
+#include <private/filament/Variant.h>
+
+#include <backend/DriverApiForward.h>
+#include <backend/Handle.h>
+#include <backend/Program.h>
+
+#include <utils/Allocator.h>
+#include <utils/FixedCapacityVector.h>
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * HwProgramFactory shares backend programs between materials. Materials built from the same
+ * package, with the same specialization constants, end up with identical programs; these are
+ * compiled only once and are reference-counted.
+ */
+class HwProgramFactory {
+public:
+    using Handle = backend::ProgramHandle;
+
+    HwProgramFactory();
+    ~HwProgramFactory() noexcept;
+
+    HwProgramFactory(HwProgramFactory const& rhs) = delete;
+    HwProgramFactory(HwProgramFactory&& rhs) noexcept = delete;
+    HwProgramFactory& operator=(HwProgramFactory const& rhs) = delete;
+    HwProgramFactory& operator=(HwProgramFactory&& rhs) noexcept = delete;
+
+    void terminate(backend::DriverApi& driver) noexcept;
+
+    // Returns the id shared by all the materials with identical package bytes and dictionary.
+    // Packages are told apart by their cache id, and are only compared byte-wise when these
+    // match. The package data must stay valid until releasePackage() is called.
+    uint32_t acquirePackage(uint64_t cacheId, const void* data, size_t size,
+            const void* dictionary);
+
+    void releasePackage(uint64_t cacheId, uint32_t packageId, const void* data) noexcept;
+
+    struct Parameters {
+        // identifies the shaders of the material, see acquirePackage()
+        uint32_t packageId;
+        // specialization constants, sorted by id
+        utils::FixedCapacityVector<backend::Program::SpecializationConstant> constants;
+        Variant variant;
+        size_t hash() const noexcept;
+    };
+
+    friend bool operator==(Parameters const& lhs, Parameters const& rhs) noexcept;
+
+    // Returns the program matching these parameters and takes a reference to it, or a null
+    // handle if there is no such program yet.
+    Handle acquire(Parameters const& params) noexcept;
+
+    // Creates the program for these parameters, which must not have one already.
+    Handle create(backend::DriverApi& driver, Parameters const& params,
+            backend::Program&& program) noexcept;
+
+    void destroy(backend::DriverApi& driver, Handle handle) noexcept;
+
+private:
+    struct Key {
+        // The key should not be copyable, unfortunately due to how the Bimap works we have
+        // to copy-construct it once.
+        Key(Key const&) = default;
+        Key& operator=(Key const&) = delete;
+        Key& operator=(Key&&) noexcept = delete;
+        explicit Key(Parameters const& params) : params(params), refs(1) { }
+        Parameters params;
+        mutable uint32_t refs;  // 4 bytes
+        bool operator==(Key const& rhs) const noexcept {
+            return params == rhs.params;
+        }
+    };
+
+    struct KeyHasher {
+        size_t operator()(Key const& p) const noexcept {
+            return p.params.hash();
+        }
+    };
+
+    struct Value { // 4 bytes
+        Handle handle;
+    };
+
+    struct ValueHasher {
+        size_t operator()(Value const v) const noexcept {
+            return std::hash<Handle::HandleId>()(v.handle.getId());
+        }
+    };
+
+    friend bool operator==(Value const lhs, Value const rhs) noexcept {
+        return lhs.handle == rhs.handle;
+    }
+
+    struct Package {
+        uint32_t id;
+        size_t size;
+        const void* dictionary;
+        // the data of each material using this package, any of which can be compared against
+        std::vector<const void*> users;
+    };
+
+    // packages by cache id
+    std::unordered_multimap<uint64_t, Package> mPackages;
+    uint32_t mNextPackageId = 0;
+
+    // Size of the arena used for the "set" part of the bimap
+    // about ~1K entries before fall back to heap
+    static constexpr size_t SET_ARENA_SIZE = 48 * 1024;
+
+    // Arena for the set<>, using a pool allocator inside a heap area.
+    using PoolAllocatorArena = utils::Arena<
+            utils::PoolAllocatorWithFallback<sizeof(Key)>,
+            utils::LockingPolicy::NoLock,
+            utils::TrackingPolicy::Untracked,
+            utils::AreaPolicy::HeapArea>;
+
+
+    // Arena where the set memory is allocated
+    PoolAllocatorArena mArena;
+
+    // The special Bimap
+    Bimap<Key, Value, KeyHasher, ValueHasher,
+            utils::STLAllocator<Key, PoolAllocatorArena>> mBimap;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_HWPROGRAMFACTORY_H
@@ -17,9 +17,11 @@
 
 #include "MaterialParser.h"
 
+#include "details/MaterialLibrary.h"
+
 #include <filaflat/ChunkContainer.h>
 #include <filaflat/MaterialChunk.h>
-#include <filaflat/DictionaryReader.h>
+#include <filaflat/DictionaryView.h>
 #include <filaflat/Unflattener.h>
 
 #include <filament/MaterialChunkType.h>
@@ -73,11 +75,12 @@ constexpr std::pair<ChunkType, ChunkType> shaderLanguageToTags(ShaderLanguage la
 
 MaterialParser::MaterialParserDetails::MaterialParserDetails(
         utils::FixedCapacityVector<ShaderLanguage> preferredLanguages, const void* data,
-        size_t size)
-    : mManagedBuffer(data, size),
+        size_t size, FMaterialLibrary const* library, bool persistent)
+    : mManagedBuffer(data, size, persistent),
       mChunkContainer(mManagedBuffer.data(), mManagedBuffer.size()),
       mPreferredLanguages(std::move(preferredLanguages)),
-      mMaterialChunk(mChunkContainer) {
+      mMaterialChunk(mChunkContainer),
+      mLibrary(library) {
 }
 
 template<typename T>
@@ -93,13 +96,23 @@ bool MaterialParser::MaterialParserDetails::getFromSimpleChunk(
     return false;
 }
 
-MaterialParser::MaterialParserDetails::ManagedBuffer::ManagedBuffer(const void* start, size_t size)
-        : mStart(malloc(size)), mSize(size) {
-    memcpy(mStart, start, size);
+MaterialParser::MaterialParserDetails::ManagedBuffer::ManagedBuffer(const void* start, size_t size,
+        bool persistent) : mSize(size) {
+    // Dictionary blobs are aligned relative to the start of the package, so it can only be used
+    // in place if it is itself suitably aligned.
+    mOwned = !persistent || (uintptr_t(start) % 8) != 0;
+    if (mOwned) {
+        mStart = malloc(size);
+        memcpy(mStart, start, size);
+    } else {
+        mStart = const_cast<void*>(start);
+    }
 }
 
 MaterialParser::MaterialParserDetails::ManagedBuffer::~ManagedBuffer() noexcept {
-    free(mStart);
+    if (mOwned) {
+        free(mStart);
+    }
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -113,8 +126,8 @@ bool MaterialParser::get(typename T::Container* container) const noexcept {
 }
 
 MaterialParser::MaterialParser(utils::FixedCapacityVector<ShaderLanguage> preferredLanguages,
-        const void* data, size_t size)
-    : mImpl(std::move(preferredLanguages), data, size) {
+        const void* data, size_t size, FMaterialLibrary const* library, bool persistent)
+    : mImpl(std::move(preferredLanguages), data, size, library, persistent) {
 }
 
 ChunkContainer& MaterialParser::getChunkContainer() noexcept {
@@ -133,10 +146,12 @@ MaterialParser::ParseResult MaterialParser::parse() noexcept {
 
     using MaybeShaderLanguageAndChunks =
             std::optional<std::tuple<ShaderLanguage, ChunkType, ChunkType>>;
-    auto chooseLanguage = [this, &cc]() -> MaybeShaderLanguageAndChunks {
+    FMaterialLibrary const* const library = mImpl.mLibrary;
+    auto chooseLanguage = [this, &cc, library]() -> MaybeShaderLanguageAndChunks {
         for (auto language : mImpl.mPreferredLanguages) {
             const auto [matTag, dictTag] = shaderLanguageToTags(language);
-            if (cc.hasChunk(matTag) && cc.hasChunk(dictTag)) {
+            if (cc.hasChunk(matTag) &&
+                    (cc.hasChunk(dictTag) || (library && library->hasDictionary(dictTag)))) {
                 return std::make_tuple(language, matTag, dictTag);
             }
         }
@@ -149,9 +164,17 @@ MaterialParser::ParseResult MaterialParser::parse() noexcept {
     }
 
     const auto [chosenLanguage, matTag, dictTag] = result.value();
-    if (UTILS_UNLIKELY(!DictionaryReader::unflatten(cc, dictTag, mImpl.mBlobDictionary))) {
-        return ParseResult::ERROR_OTHER;
+    if (cc.hasChunk(dictTag)) {
+        if (UTILS_UNLIKELY(!mImpl.mDictionary.initialize(cc, dictTag))) {
+            return ParseResult::ERROR_OTHER;
+        }
+    } else {
+        mImpl.mSharedBlobDictionary = library->getDictionary(dictTag);
+        if (UTILS_UNLIKELY(!mImpl.mSharedBlobDictionary)) {
+            return ParseResult::ERROR_OTHER;
+        }
     }
+    mImpl.mLibrary = nullptr;
     if (UTILS_UNLIKELY(!mImpl.mMaterialChunk.initialize(matTag))) {
         return ParseResult::ERROR_OTHER;
     }
@@ -391,8 +414,12 @@ bool MaterialParser::getReflectionMode(ReflectionMode* value) const noexcept {
 
 bool MaterialParser::getShader(ShaderContent& shader,
         ShaderModel shaderModel, Variant variant, ShaderStage stage) noexcept {
+    if (mImpl.mSharedBlobDictionary) {
+        return mImpl.mMaterialChunk.getShader(shader,
+                *mImpl.mSharedBlobDictionary, shaderModel, variant, stage);
+    }
     return mImpl.mMaterialChunk.getShader(shader,
-            mImpl.mBlobDictionary, shaderModel, variant, stage);
+            mImpl.mDictionary, shaderModel, variant, stage);
 }
 
 // ------------------------------------------------------------------------------------------------
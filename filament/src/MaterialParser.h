@@ -18,6 +18,7 @@
 #define TNT_FILAMENT_MATERIALPARSER_H
 
 #include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryView.h>
 #include <filaflat/MaterialChunk.h>
 
 #include <filament/MaterialEnums.h>
@@ -32,6 +33,7 @@
 #include <utils/FixedCapacityVector.h>
 
 #include <array>
+#include <memory>
 #include <tuple>
 #include <utility>
 
@@ -46,6 +48,7 @@ class Unflattener;
 namespace filament {
 
 class BufferInterfaceBlock;
+class FMaterialLibrary;
 class SamplerInterfaceBlock;
 struct SubpassInfo;
 struct MaterialConstant;
@@ -53,8 +56,13 @@ struct MaterialPushConstant;
 
 class MaterialParser {
 public:
+    // When a library is given, the shaders of the material can come from the library's shared
+    // dictionaries instead of the package's own.
+    // When persistent is true, the caller guarantees that the package outlives the parser, which
+    // then uses it in place instead of taking a copy.
     MaterialParser(utils::FixedCapacityVector<backend::ShaderLanguage> preferredLanguages,
-            const void* data, size_t size);
+            const void* data, size_t size, FMaterialLibrary const* library = nullptr,
+            bool persistent = false);
 
     MaterialParser(MaterialParser const& rhs) noexcept = delete;
     MaterialParser& operator=(MaterialParser const& rhs) noexcept = delete;
@@ -130,6 +138,15 @@ public:
     bool getShader(filaflat::ShaderContent& shader, backend::ShaderModel shaderModel,
             Variant variant, backend::ShaderStage stage) noexcept;
 
+    // Returns the package being parsed, which stays valid for the lifetime of the parser.
+    const void* getPackageData() const noexcept { return mImpl.mManagedBuffer.data(); }
+    size_t getPackageSize() const noexcept { return mImpl.mManagedBuffer.size(); }
+
+    // Returns the dictionary shared with the other materials of a library, or null.
+    filaflat::BlobDictionary const* getSharedDictionary() const noexcept {
+        return mImpl.mSharedBlobDictionary.get();
+    }
+
     bool hasShader(backend::ShaderModel model,
             Variant variant, backend::ShaderStage stage) const noexcept {
         return getMaterialChunk().hasShader(model, variant, stage);
@@ -147,7 +164,7 @@ private:
     struct MaterialParserDetails {
         MaterialParserDetails(
                 utils::FixedCapacityVector<backend::ShaderLanguage> preferredLanguages,
-                const void* data, size_t size);
+                const void* data, size_t size, FMaterialLibrary const* library, bool persistent);
 
         template<typename T>
         bool getFromSimpleChunk(filamat::ChunkType type, T* value) const noexcept;
@@ -158,8 +175,9 @@ private:
         class ManagedBuffer {
             void* mStart = nullptr;
             size_t mSize = 0;
+            bool mOwned = true;
         public:
-            explicit ManagedBuffer(const void* start, size_t size);
+            ManagedBuffer(const void* start, size_t size, bool persistent);
             ~ManagedBuffer() noexcept;
             ManagedBuffer(ManagedBuffer const& rhs) = delete;
             ManagedBuffer& operator=(ManagedBuffer const& rhs) = delete;
@@ -176,7 +194,13 @@ private:
 
         // Keep MaterialChunk alive between calls to getShader to avoid reload the shader index.
         filaflat::MaterialChunk mMaterialChunk;
-        filaflat::BlobDictionary mBlobDictionary;
+        // The package's dictionary is read in place, only the lines or blobs needed by a shader
+        // are copied out of it, in getShader().
+        filaflat::DictionaryView mDictionary;
+
+        // Set when the material comes from a library, which is only needed during parse().
+        FMaterialLibrary const* mLibrary;
+        std::shared_ptr<filaflat::BlobDictionary const> mSharedBlobDictionary;
     };
 
     filaflat::ChunkContainer& getChunkContainer() noexcept;
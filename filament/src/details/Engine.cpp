@@ -82,6 +82,7 @@ struct Engine::BuilderDetails {
     Engine::Config mConfig;
     FeatureLevel mFeatureLevel = FeatureLevel::FEATURE_LEVEL_1;
     void* mSharedContext = nullptr;
+    ProgramBinaryArchive* mProgramBinaryArchive = nullptr;
     bool mPaused = false;
     std::unordered_map<std::string_view, bool> mFeatureFlags;
 
@@ -113,6 +114,9 @@ Engine* FEngine::create(Engine::Builder const& builder) {
             delete instance;
             return nullptr;
         }
+        if (instance->mProgramBinaryArchive) {
+            instance->mProgramBinaryArchive->attach(*platform);
+        }
         DriverConfig const driverConfig{
                 .handleArenaSize = instance->getRequestedDriverHandleArenaSize(),
                 .metalUploadBufferSizeBytes = instance->getConfig().metalUploadBufferSizeBytes,
@@ -211,6 +215,7 @@ FEngine::FEngine(Engine::Builder const& builder) :
         mActiveFeatureLevel(builder->mFeatureLevel),
         mPlatform(builder->mPlatform),
         mSharedGLContext(builder->mSharedContext),
+        mProgramBinaryArchive(builder->mProgramBinaryArchive),
         mPostProcessManager(*this),
         mEntityManager(EntityManager::get()),
         mRenderableManager(*this),
@@ -580,6 +585,8 @@ void FEngine::shutdown() {
     cleanupResourceList(std::move(mTextures));
     cleanupResourceList(std::move(mRenderTargets));
     cleanupResourceList(std::move(mMaterials));
+    mHwProgramFactory.terminate(driver);
+    cleanupResourceList(std::move(mMaterialLibraries));
     cleanupResourceList(std::move(mInstanceBuffers));
     for (auto& item : mMaterialInstances) {
         cleanupResourceList(std::move(item.second));
@@ -748,6 +755,10 @@ int FEngine::loop() {
     }
 #endif
 
+    if (mProgramBinaryArchive) {
+        mProgramBinaryArchive->attach(*mPlatform);
+    }
+
     JobSystem::setThreadName("FEngine::loop");
     JobSystem::setThreadPriority(JobSystem::Priority::DISPLAY);
 
@@ -836,6 +847,10 @@ FInstanceBuffer* FEngine::createInstanceBuffer(const InstanceBuffer::Builder& bu
     return create(mInstanceBuffers, builder);
 }
 
+FMaterialLibrary* FEngine::createMaterialLibrary(const MaterialLibrary::Builder& builder) noexcept {
+    return create(mMaterialLibraries, builder);
+}
+
 FTexture* FEngine::createTexture(const Texture::Builder& builder) noexcept {
     return create(mTextures, builder);
 }
@@ -1148,6 +1163,11 @@ bool FEngine::destroy(const FInstanceBuffer* p){
     return terminateAndDestroy(p, mInstanceBuffers);
 }
 
+UTILS_NOINLINE
+bool FEngine::destroy(const FMaterialLibrary* p) {
+    return terminateAndDestroy(p, mMaterialLibraries);
+}
+
 UTILS_NOINLINE
 bool FEngine::destroy(const FMaterial* ptr) {
     if (ptr == nullptr) return true;
@@ -1283,6 +1303,10 @@ bool FEngine::isValid(const FInstanceBuffer* p) const {
     return isValid(p, mInstanceBuffers);
 }
 
+bool FEngine::isValid(const FMaterialLibrary* p) const {
+    return isValid(p, mMaterialLibraries);
+}
+
 size_t FEngine::getBufferObjectCount() const noexcept { return mBufferObjects.size(); }
 size_t FEngine::getViewCount() const noexcept { return mViews.size(); }
 size_t FEngine::getSceneCount() const noexcept { return mScenes.size(); }
@@ -1433,6 +1457,11 @@ Engine::Builder& Engine::Builder::paused(bool paused) noexcept {
     return *this;
 }
 
+Engine::Builder& Engine::Builder::programBinaryArchive(ProgramBinaryArchive* archive) noexcept {
+    mImpl->mProgramBinaryArchive = archive;
+    return *this;
+}
+
 Engine::Builder& Engine::Builder::feature(char const* name, bool value) noexcept {
     mImpl->mFeatureFlags[name] = value;
     return *this;
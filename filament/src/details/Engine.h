@@ -24,6 +24,7 @@
 #include "PostProcessManager.h"
 #include "ResourceList.h"
 #include "HwDescriptorSetLayoutFactory.h"
+#include "HwProgramFactory.h"
 #include "HwVertexBufferInfoFactory.h"
 
 #include "components/CameraManager.h"
@@ -40,6 +41,7 @@
 #include "details/Fence.h"
 #include "details/IndexBuffer.h"
 #include "details/InstanceBuffer.h"
+#include "details/MaterialLibrary.h"
 #include "details/RenderTarget.h"
 #include "details/SkinningBuffer.h"
 #include "details/MorphTargetBuffer.h"
@@ -300,6 +302,7 @@ public:
     FInstanceBuffer* createInstanceBuffer(const InstanceBuffer::Builder& builder) noexcept;
     FIndirectLight* createIndirectLight(const IndirectLight::Builder& builder) noexcept;
     FMaterial* createMaterial(const Material::Builder& builder, std::unique_ptr<MaterialParser> materialParser) noexcept;
+    FMaterialLibrary* createMaterialLibrary(const MaterialLibrary::Builder& builder) noexcept;
     FTexture* createTexture(const Texture::Builder& builder) noexcept;
     FSkybox* createSkybox(const Skybox::Builder& builder) noexcept;
     FColorGrading* createColorGrading(const ColorGrading::Builder& builder) noexcept;
@@ -347,6 +350,7 @@ public:
     bool destroy(const FSwapChain* p);
     bool destroy(const FView* p);
     bool destroy(const FInstanceBuffer* p);
+    bool destroy(const FMaterialLibrary* p);
 
     bool isValid(const FBufferObject* p) const;
     bool isValid(const FVertexBuffer* p) const;
@@ -368,6 +372,7 @@ public:
     bool isValid(const FRenderTarget* p) const;
     bool isValid(const FView* p) const;
     bool isValid(const FInstanceBuffer* p) const;
+    bool isValid(const FMaterialLibrary* p) const;
 
     size_t getBufferObjectCount() const noexcept;
     size_t getViewCount() const noexcept;
@@ -470,6 +475,10 @@ public:
         return mHwDescriptorSetLayoutFactory;
     }
 
+    HwProgramFactory& getProgramFactory() noexcept {
+        return mHwProgramFactory;
+    }
+
     DescriptorSetLayout const& getPerViewDescriptorSetLayoutDepthVariant() const noexcept {
         return mPerViewDescriptorSetLayoutDepthVariant;
     }
@@ -537,6 +546,7 @@ private:
     bool mOwnPlatform = false;
     bool mAutomaticInstancingEnabled = false;
     void* mSharedGLContext = nullptr;
+    backend::ProgramBinaryArchive* mProgramBinaryArchive = nullptr;
     backend::Handle<backend::HwRenderPrimitive> mFullScreenTriangleRph;
     FVertexBuffer* mFullScreenTriangleVb = nullptr;
     FIndexBuffer* mFullScreenTriangleIb = nullptr;
@@ -552,6 +562,7 @@ private:
     std::shared_ptr<ResourceAllocatorDisposer> mResourceAllocatorDisposer;
     HwVertexBufferInfoFactory mHwVertexBufferInfoFactory;
     HwDescriptorSetLayoutFactory mHwDescriptorSetLayoutFactory;
+    HwProgramFactory mHwProgramFactory;
     DescriptorSetLayout mPerViewDescriptorSetLayoutDepthVariant;
     DescriptorSetLayout mPerViewDescriptorSetLayoutSsrVariant;
     DescriptorSetLayout mPerRenderableDescriptorSetLayout;
@@ -569,6 +580,7 @@ private:
     ResourceList<FVertexBuffer> mVertexBuffers{ "VertexBuffer" };
     ResourceList<FIndirectLight> mIndirectLights{ "IndirectLight" };
     ResourceList<FMaterial> mMaterials{ "Material" };
+    ResourceList<FMaterialLibrary> mMaterialLibraries{ "MaterialLibrary" };
     ResourceList<FTexture> mTextures{ "Texture" };
     ResourceList<FSkybox> mSkyboxes{ "Skybox" };
     ResourceList<FColorGrading> mColorGradings{ "ColorGrading" };
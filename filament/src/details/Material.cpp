@@ -16,8 +16,10 @@
 
 #include "details/Material.h"
 #include "details/Engine.h"
+#include "details/MaterialLibrary.h"
 
 #include "Froxelizer.h"
+#include "HwProgramFactory.h"
 #include "MaterialParser.h"
 
 #include "ds/ColorPassDescriptorSet.h"
@@ -79,9 +81,11 @@ using namespace filaflat;
 using namespace utils;
 
 static std::unique_ptr<MaterialParser> createParser(Backend backend,
-        utils::FixedCapacityVector<ShaderLanguage> languages, const void* data, size_t size) {
+        utils::FixedCapacityVector<ShaderLanguage> languages, const void* data, size_t size,
+        FMaterialLibrary const* library = nullptr, bool persistent = false) {
     // unique_ptr so we don't leak MaterialParser on failures below
-    auto materialParser = std::make_unique<MaterialParser>(languages, data, size);
+    auto materialParser = std::make_unique<MaterialParser>(
+            languages, data, size, library, persistent);
 
     MaterialParser::ParseResult const materialResult = materialParser->parse();
 
@@ -121,6 +125,8 @@ static std::unique_ptr<MaterialParser> createParser(Backend backend,
 struct Material::BuilderDetails {
     const void* mPayload = nullptr;
     size_t mSize = 0;
+    FMaterialLibrary const* mLibrary = nullptr;
+    bool mPersistentPackage = false;
     bool mDefaultMaterial = false;
     int32_t mShBandsCount = 3;
     std::unordered_map<
@@ -144,6 +150,22 @@ BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder&& rhs
 Material::Builder& Material::Builder::package(const void* payload, size_t size) {
     mImpl->mPayload = payload;
     mImpl->mSize = size;
+    mImpl->mLibrary = nullptr;
+    return *this;
+}
+
+Material::Builder& Material::Builder::package(MaterialLibrary const& library, const char* name) {
+    FMaterialLibrary const& lib = downcast(library);
+    FMaterialLibrary::Entry const* const entry = lib.findMaterial(name);
+    FILAMENT_CHECK_PRECONDITION(entry) << "material '" << name << "' not found in library";
+    mImpl->mPayload = entry->data;
+    mImpl->mSize = entry->size;
+    mImpl->mLibrary = &lib;
+    return *this;
+}
+
+Material::Builder& Material::Builder::persistentPackage(bool persistent) noexcept {
+    mImpl->mPersistentPackage = persistent;
     return *this;
 }
 
@@ -164,9 +186,12 @@ template Material::Builder& Material::Builder::constant<float>(const char*, size
 template Material::Builder& Material::Builder::constant<bool>(const char*, size_t, bool);
 
 Material* Material::Builder::build(Engine& engine) {
+    // Materials don't keep their library alive, so a package that lives in a library is always
+    // copied, regardless of persistentPackage().
+    bool const persistent = mImpl->mPersistentPackage && !mImpl->mLibrary;
     std::unique_ptr<MaterialParser> materialParser = createParser(
         downcast(engine).getBackend(), downcast(engine).getShaderLanguage(),
-        mImpl->mPayload, mImpl->mSize);
+        mImpl->mPayload, mImpl->mSize, mImpl->mLibrary, persistent);
 
     if (!materialParser) {
         return nullptr;
@@ -255,6 +280,8 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder,
     success = parser->getCacheId(&mCacheId);
     assert_invariant(success);
 
+    acquirePackageId();
+
     success = parser->getSIB(&mSamplerInterfaceBlock);
     assert_invariant(success);
 
@@ -376,6 +403,7 @@ void FMaterial::terminate(FEngine& engine) {
 #endif
 
     destroyPrograms(engine);
+    releasePackageId();
 
     if (mDefaultMaterialInstance) {
         mDefaultMaterialInstance->setDefaultInstance(false);
@@ -491,6 +519,17 @@ bool FMaterial::hasVariant(Variant variant) const noexcept {
 void FMaterial::prepareProgramSlow(Variant variant,
         backend::CompilerPriorityQueue priorityQueue) const noexcept {
     assert_invariant(mEngine.hasFeatureLevel(mFeatureLevel));
+
+    // Another material built from the same package, with the same constants, may already have
+    // compiled this program.
+    if (!isSharedDepthVariant(variant)) {
+        auto program = mEngine.getProgramFactory().acquire(getProgramParameters(variant));
+        if (program) {
+            mCachedPrograms[variant.key] = program;
+            return;
+        }
+    }
+
     switch (getMaterialDomain()) {
         case MaterialDomain::SURFACE:
             getSurfaceProgramSlow(variant, priorityQueue);
@@ -601,14 +640,40 @@ Program FMaterial::getProgramWithVariants(
     return program;
 }
 
+bool FMaterial::isSharedDepthVariant(Variant variant) const noexcept {
+    return mMaterialDomain == MaterialDomain::SURFACE &&
+            !mIsDefaultMaterial && !mHasCustomDepthShader &&
+            Variant::isValidDepthVariant(variant);
+}
+
+void FMaterial::acquirePackageId() {
+    // The materials of a library index into its dictionary, which is kept alive by the parser
+    // for as long as the package id is in use.
+    MaterialParser const* const parser = mMaterialParser.get();
+    mPackageId = mEngine.getProgramFactory().acquirePackage(mCacheId,
+            parser->getPackageData(), parser->getPackageSize(), parser->getSharedDictionary());
+}
+
+void FMaterial::releasePackageId() noexcept {
+    mEngine.getProgramFactory().releasePackage(
+            mCacheId, mPackageId, mMaterialParser->getPackageData());
+}
+
+HwProgramFactory::Parameters FMaterial::getProgramParameters(Variant variant) const noexcept {
+    // Constants are set in no particular order, but the parameters of a program must be unique.
+    FixedCapacityVector<Program::SpecializationConstant> constants(mSpecializationConstants);
+    std::sort(constants.begin(), constants.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.id < rhs.id;
+    });
+    return { mPackageId, std::move(constants), variant };
+}
+
 void FMaterial::createAndCacheProgram(Program&& p, Variant variant) const noexcept {
-    FEngine const& engine = mEngine;
+    FEngine& engine = mEngine;
     DriverApi& driverApi = mEngine.getDriverApi();
 
     // Check if the default material has this program cached
-    if (mMaterialDomain == MaterialDomain::SURFACE &&
-            !mIsDefaultMaterial && !mHasCustomDepthShader &&
-            Variant::isValidDepthVariant(variant)) {
+    if (isSharedDepthVariant(variant)) {
         FMaterial const* const pDefaultMaterial = engine.getDefaultMaterial();
         if (pDefaultMaterial) {
             auto program = pDefaultMaterial->mCachedPrograms[variant.key];
@@ -619,7 +684,8 @@ void FMaterial::createAndCacheProgram(Program&& p, Variant variant) const noexce
         }
     }
 
-    auto program = driverApi.createProgram(std::move(p));
+    auto program = engine.getProgramFactory().create(driverApi,
+            getProgramParameters(variant), std::move(p));
     driverApi.setDebugTag(program.getId(), mName);
     assert_invariant(program);
     mCachedPrograms[variant.key] = program;
@@ -627,9 +693,7 @@ void FMaterial::createAndCacheProgram(Program&& p, Variant variant) const noexce
     // If the default material doesn't already have this program cached, and all caching conditions
     // are met (Surface Domain and no custom depth shader), cache it now.
     // New Materials will inherit these program automatically.
-    if (mMaterialDomain == MaterialDomain::SURFACE &&
-            !mIsDefaultMaterial && !mHasCustomDepthShader &&
-            Variant::isValidDepthVariant(variant)) {
+    if (isSharedDepthVariant(variant)) {
         FMaterial const* const pDefaultMaterial = engine.getDefaultMaterial();
         if (pDefaultMaterial && !pDefaultMaterial->mCachedPrograms[variant.key]) {
             // set the tag to the default material name
@@ -707,7 +771,10 @@ bool FMaterial::hasPendingEdits() noexcept {
 
 void FMaterial::latchPendingEdits() noexcept {
     std::lock_guard const lock(mPendingEditsLock);
+    // The edited package no longer matches the other materials of the original package.
+    releasePackageId();
     mMaterialParser.reset(mPendingEdits.release());
+    acquirePackageId();
 }
 
 /**
@@ -745,6 +812,7 @@ void FMaterial::destroyPrograms(FEngine& engine,
         Variant::type_t const variantMask, Variant::type_t const variantValue) {
 
     DriverApi& driverApi = engine.getDriverApi();
+    HwProgramFactory& programFactory = engine.getProgramFactory();
     auto& cachedPrograms = mCachedPrograms;
 
     switch (mMaterialDomain) {
@@ -756,7 +824,8 @@ void FMaterial::destroyPrograms(FEngine& engine,
                         // Only destroy if the handle is valid. Not strictly needed, but we have a lot
                         // of variants, and this generates traffic in the command queue.
                         if (cachedPrograms[k]) {
-                            driverApi.destroyProgram(std::move(cachedPrograms[k]));
+                            programFactory.destroy(driverApi, cachedPrograms[k]);
+                            cachedPrograms[k].clear();
                         }
                     }
                 }
@@ -787,7 +856,8 @@ void FMaterial::destroyPrograms(FEngine& engine,
                                 continue;
                             }
 
-                            driverApi.destroyProgram(std::move(cachedPrograms[k]));
+                            programFactory.destroy(driverApi, cachedPrograms[k]);
+                            cachedPrograms[k].clear();
                         }
                     }
                 }
@@ -800,7 +870,8 @@ void FMaterial::destroyPrograms(FEngine& engine,
                     // Only destroy if the handle is valid. Not strictly needed, but we have a lot
                     // of variant, and this generates traffic in the command queue.
                     if (cachedPrograms[k]) {
-                        driverApi.destroyProgram(std::move(cachedPrograms[k]));
+                        programFactory.destroy(driverApi, cachedPrograms[k]);
+                        cachedPrograms[k].clear();
                     }
                 }
             }
@@ -18,6 +18,7 @@
 #define TNT_FILAMENT_DETAILS_MATERIAL_H
 
 #include "downcast.h"
+#include "HwProgramFactory.h"
 
 #include "details/MaterialInstance.h"
 
@@ -290,6 +291,14 @@ private:
 
     void createAndCacheProgram(backend::Program&& p, Variant variant) const noexcept;
 
+    // Depth variants shared with the default material aren't owned by this material.
+    bool isSharedDepthVariant(Variant variant) const noexcept;
+
+    HwProgramFactory::Parameters getProgramParameters(Variant variant) const noexcept;
+
+    void acquirePackageId();
+    void releasePackageId() noexcept;
+
     // try to order by frequency of use
     mutable std::array<backend::Handle<backend::HwProgram>, VARIANT_COUNT> mCachedPrograms;
     DescriptorSetLayout mPerViewDescriptorSetLayout;
@@ -370,6 +379,9 @@ private:
     FEngine& mEngine;
     const uint32_t mMaterialId;
     uint64_t mCacheId = 0;
+    // Identifies the shaders of this material, programs are shared between materials with the
+    // same package and specialization constants.
+    uint32_t mPackageId = 0;
     mutable uint32_t mMaterialInstanceId = 0;
     std::unique_ptr<MaterialParser> mMaterialParser;
 };
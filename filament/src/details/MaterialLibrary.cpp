@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/MaterialLibrary.h"
+
+#include "details/Engine.h"
+
+#include "FilamentAPI-impl.h"
+
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryReader.h>
+#include <filaflat/Unflattener.h>
+
+#include <utils/FixedCapacityVector.h>
+#include <utils/Panic.h>
+#include <utils/compiler.h>
+#include <utils/debug.h>
+
+#include <memory>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace filament {
+
+using namespace filaflat;
+using namespace filamat;
+using namespace utils;
+
+struct MaterialLibrary::BuilderDetails {
+    const void* mPayload = nullptr;
+    size_t mSize = 0;
+};
+
+using BuilderType = MaterialLibrary;
+BuilderType::Builder::Builder() noexcept = default;
+BuilderType::Builder::~Builder() noexcept = default;
+BuilderType::Builder::Builder(BuilderType::Builder const& rhs) noexcept = default;
+BuilderType::Builder::Builder(BuilderType::Builder&& rhs) noexcept = default;
+BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder const& rhs) noexcept = default;
+BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder&& rhs) noexcept = default;
+
+MaterialLibrary::Builder& MaterialLibrary::Builder::package(const void* payload, size_t size) {
+    mImpl->mPayload = payload;
+    mImpl->mSize = size;
+    return *this;
+}
+
+MaterialLibrary* MaterialLibrary::Builder::build(Engine& engine) {
+    FILAMENT_CHECK_PRECONDITION(mImpl->mPayload && mImpl->mSize)
+            << "MaterialLibrary requires a package";
+
+    // Validate the library before the engine takes a copy of it.
+    ChunkContainer container(mImpl->mPayload, mImpl->mSize);
+    FixedCapacityVector<FMaterialLibrary::Entry> materials;
+    FILAMENT_CHECK_PRECONDITION(container.parse() &&
+            FMaterialLibrary::getMaterials(container, &materials))
+            << "could not parse the material library";
+
+    return downcast(engine).createMaterialLibrary(*this);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// The library takes a single copy of the whole package, so that the application can release its
+// buffer right after build(). Dictionaries are decoded lazily out of this copy, and the entries
+// handed to Material::Builder point into it.
+FMaterialLibrary::FMaterialLibrary(FEngine&, const Builder& builder)
+        : mData(malloc(builder->mSize)),
+          mChunkContainer(mData, builder->mSize) {
+    memcpy(mData, builder->mPayload, builder->mSize);
+    UTILS_UNUSED_IN_RELEASE bool const success =
+            mChunkContainer.parse() && getMaterials(mChunkContainer, &mMaterials);
+    assert_invariant(success);
+}
+
+FMaterialLibrary::~FMaterialLibrary() noexcept {
+    free(mData);
+}
+
+void FMaterialLibrary::terminate(FEngine&) {
+    // The dictionaries still in use are owned by their materials from now on.
+    for (auto& dictionary : mDictionaries) {
+        dictionary.reset();
+    }
+}
+
+bool FMaterialLibrary::getMaterials(ChunkContainer const& container,
+        FixedCapacityVector<Entry>* materials) noexcept {
+    auto [start, end] = container.getChunkRange(ChunkType::LibraryMaterials);
+    if (start == end) {
+        return false;
+    }
+    Unflattener unflattener(start, end);
+    uint32_t count = 0;
+    if (!unflattener.read(&count)) {
+        return false;
+    }
+    // Every material takes at least a (possibly empty) name and a blob size.
+    if (count > size_t(end - start) / (1 + sizeof(uint64_t))) {
+        return false;
+    }
+    auto result = FixedCapacityVector<Entry>::with_capacity(count);
+    for (uint32_t i = 0; i < count; i++) {
+        Entry entry{};
+        const char* data = nullptr;
+        if (!unflattener.read(&entry.name) || !unflattener.read(&data, &entry.size)) {
+            return false;
+        }
+        entry.data = data;
+        result.push_back(entry);
+    }
+    *materials = std::move(result);
+    return true;
+}
+
+const char* FMaterialLibrary::getMaterialName(size_t index) const noexcept {
+    assert_invariant(index < mMaterials.size());
+    return mMaterials[index].name;
+}
+
+FMaterialLibrary::Entry const* FMaterialLibrary::findMaterial(const char* name) const noexcept {
+    for (Entry const& entry : mMaterials) {
+        if (!strcmp(entry.name, name)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+size_t FMaterialLibrary::getDictionaryIndex(ChunkType dictionaryTag) noexcept {
+    switch (dictionaryTag) {
+        case ChunkType::DictionarySpirv:
+            return 1;
+        case ChunkType::DictionaryMetalLibrary:
+            return 2;
+        default:
+            assert_invariant(dictionaryTag == ChunkType::DictionaryText);
+            return 0;
+    }
+}
+
+bool FMaterialLibrary::hasDictionary(ChunkType dictionaryTag) const noexcept {
+    return mChunkContainer.hasChunk(dictionaryTag);
+}
+
+std::shared_ptr<BlobDictionary const> FMaterialLibrary::getDictionary(
+        ChunkType dictionaryTag) const noexcept {
+    auto& dictionary = mDictionaries[getDictionaryIndex(dictionaryTag)];
+    if (!dictionary && hasDictionary(dictionaryTag)) {
+        auto decoded = std::make_shared<BlobDictionary>();
+        if (UTILS_LIKELY(DictionaryReader::unflatten(mChunkContainer, dictionaryTag, *decoded))) {
+            dictionary = std::move(decoded);
+        }
+    }
+    return dictionary;
+}
+
+} // namespace filament
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_MATERIALLIBRARY_H
+#define TNT_FILAMENT_DETAILS_MATERIALLIBRARY_H
+
+#include "downcast.h"
+
+#include <filament/MaterialLibrary.h>
+#include <filament/MaterialChunkType.h>
+
+#include <filaflat/ChunkContainer.h>
+
+#include <utils/FixedCapacityVector.h>
+
+#include <array>
+#include <memory>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class FEngine;
+
+class FMaterialLibrary : public MaterialLibrary {
+public:
+    // A material of the library: a regular material package, minus the shader dictionaries.
+    struct Entry {
+        const char* name;
+        const void* data;
+        size_t size;
+    };
+
+    FMaterialLibrary(FEngine& engine, const Builder& builder);
+    ~FMaterialLibrary() noexcept;
+
+    void terminate(FEngine& engine);
+
+    size_t getMaterialCount() const noexcept { return mMaterials.size(); }
+
+    const char* getMaterialName(size_t index) const noexcept;
+
+    // Returns the material with the given name, or null if the library doesn't have it.
+    Entry const* findMaterial(const char* name) const noexcept;
+
+    bool hasDictionary(filamat::ChunkType dictionaryTag) const noexcept;
+
+    // Returns the given shared dictionary, decoding it on first use. The dictionary is kept alive
+    // by the materials using it, independently of the library.
+    std::shared_ptr<filaflat::BlobDictionary const> getDictionary(
+            filamat::ChunkType dictionaryTag) const noexcept;
+
+    // Lists the materials of a parsed library, returns false if the library is malformed.
+    static bool getMaterials(filaflat::ChunkContainer const& container,
+            utils::FixedCapacityVector<Entry>* materials) noexcept;
+
+private:
+    static size_t getDictionaryIndex(filamat::ChunkType dictionaryTag) noexcept;
+
+    void* mData;
+    filaflat::ChunkContainer mChunkContainer;
+    utils::FixedCapacityVector<Entry> mMaterials;
+    mutable std::array<std::shared_ptr<filaflat::BlobDictionary const>, 3> mDictionaries;
+};
+
+FILAMENT_DOWNCAST(MaterialLibrary)
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_MATERIALLIBRARY_H
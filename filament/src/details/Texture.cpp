@@ -788,16 +788,25 @@ void FTexture::generatePrefilterMipmap(FEngine& engine,
     const size_t baseExp = ctz(size);
     size_t const numSamples = options->sampleCount;
     const size_t numLevels = baseExp + 1;
+    const Slice<Cubemap> sourceLevels{ levels.begin(), uint32_t(levels.size()) };
+
+    // The importance samples only depend on the roughness of each level and on the size of the
+    // source, compute them all before filtering.
+    auto sampleTables = FixedCapacityVector<CubemapIBL::SampleTable>::with_capacity(numLevels);
+    for (size_t level = 0; level < numLevels; level++) {
+        const float lod = saturate(float(level) / float(numLevels - 1));
+        const float linearRoughness = lod * lod;
+        sampleTables.push_back(CubemapIBL::SampleTable::create(
+                linearRoughness, numSamples, size, levels.size(), true));
+    }
+
     for (ssize_t i = (ssize_t)baseExp; i >= 0; --i) {
         const size_t dim = 1U << i;
         const size_t level = baseExp - i;
-        const float lod = saturate(float(level) / float(numLevels - 1));
-        const float linearRoughness = lod * lod;
 
         Image image;
         Cubemap dst = CubemapUtils::create(image, dim);
-        CubemapIBL::roughnessFilter(js, dst, { levels.begin(), uint32_t(levels.size()) },
-                linearRoughness, numSamples, mirror, true);
+        CubemapIBL::roughnessFilter(js, dst, sourceLevels, sampleTables[level], mirror);
 
         Texture::PixelBufferDescriptor const pbd(image.getData(), image.getSize(),
                 Texture::PixelBufferDescriptor::PixelDataFormat::RGB,
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Engine.h>
+#include <filament/Material.h>
+#include <filament/MaterialChunkType.h>
+#include <filament/MaterialLibrary.h>
+
+#include <filaflat/ChunkContainer.h>
+
+#include "MaterialParser.h"
+#include "details/Engine.h"
+#include "details/Material.h"
+#include "details/MaterialLibrary.h"
+
+#include "filament_test_library_resources.h"
+
+#include <algorithm>
+
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace filament;
+using namespace filaflat;
+
+// The library is built with matedit from the sandboxLit and sandboxUnlit sample materials, which
+// are also embedded as standalone packages. See CMakeLists.txt.
+class MaterialLibraryTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        ASSERT_NE(mEngine, nullptr);
+        mLibrary = MaterialLibrary::Builder()
+                .package(FILAMENT_TEST_LIBRARY_RESOURCES_TEST_LIBRARY_DATA,
+                        FILAMENT_TEST_LIBRARY_RESOURCES_TEST_LIBRARY_SIZE)
+                .build(*mEngine);
+        ASSERT_NE(mLibrary, nullptr);
+    }
+
+    void TearDown() override {
+        if (mLibrary) {
+            mEngine->destroy(mLibrary);
+        }
+        Engine::destroy(&mEngine);
+    }
+
+    Engine* mEngine = nullptr;
+    MaterialLibrary* mLibrary = nullptr;
+};
+
+struct StandaloneMaterial {
+    const char* name;
+    const uint8_t* data;
+    size_t size;
+};
+
+static const StandaloneMaterial kMaterials[] = {
+        { "sandboxLit",
+                FILAMENT_TEST_LIBRARY_RESOURCES_SANDBOXLIT_DATA,
+                FILAMENT_TEST_LIBRARY_RESOURCES_SANDBOXLIT_SIZE },
+        { "sandboxUnlit",
+                FILAMENT_TEST_LIBRARY_RESOURCES_SANDBOXUNLIT_DATA,
+                FILAMENT_TEST_LIBRARY_RESOURCES_SANDBOXUNLIT_SIZE },
+};
+
+TEST_F(MaterialLibraryTest, RoundTrip) { // NOLINT
+    FMaterialLibrary const& library = downcast(*mLibrary);
+    ASSERT_EQ(library.getMaterialCount(), 2);
+
+    for (auto const& material : kMaterials) {
+        ASSERT_TRUE(mLibrary->hasMaterial(material.name)) << material.name;
+        FMaterialLibrary::Entry const* const entry = library.findMaterial(material.name);
+        ASSERT_NE(entry, nullptr) << material.name;
+
+        MaterialParser standalone({ backend::ShaderLanguage::ESSL3 },
+                material.data, material.size);
+        MaterialParser bundled({ backend::ShaderLanguage::ESSL3 },
+                entry->data, entry->size, &library);
+        ASSERT_EQ(standalone.parse(), MaterialParser::ParseResult::SUCCESS) << material.name;
+        ASSERT_EQ(bundled.parse(), MaterialParser::ParseResult::SUCCESS) << material.name;
+        EXPECT_EQ(standalone.getMaterialChunk().getShaderCount(),
+                bundled.getMaterialChunk().getShaderCount()) << material.name;
+
+        // Every shader decoded through the shared dictionary must match the original one.
+        size_t shaderCount = 0;
+        standalone.getMaterialChunk().visitShaders(
+                [&](backend::ShaderModel model, Variant variant, backend::ShaderStage stage) {
+                    ShaderContent expected;
+                    ShaderContent actual;
+                    ASSERT_TRUE(standalone.getShader(expected, model, variant, stage));
+                    ASSERT_TRUE(bundled.getShader(actual, model, variant, stage));
+                    ASSERT_EQ(expected.size(), actual.size());
+                    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin()))
+                            << material.name << " variant " << +variant.key;
+                    shaderCount++;
+                });
+        EXPECT_GT(shaderCount, 0) << material.name;
+    }
+}
+
+TEST_F(MaterialLibraryTest, SharedDictionary) { // NOLINT
+    FMaterialLibrary const& library = downcast(*mLibrary);
+    ASSERT_TRUE(library.hasDictionary(filamat::ChunkType::DictionaryText));
+
+    FMaterialLibrary::Entry const* const lit = library.findMaterial("sandboxLit");
+    FMaterialLibrary::Entry const* const unlit = library.findMaterial("sandboxUnlit");
+    ASSERT_NE(lit, nullptr);
+    ASSERT_NE(unlit, nullptr);
+
+    // The materials of the library don't carry a dictionary of their own.
+    for (auto const* entry : { lit, unlit }) {
+        ChunkContainer container(entry->data, entry->size);
+        ASSERT_TRUE(container.parse());
+        EXPECT_FALSE(container.hasChunk(filamat::ChunkType::DictionaryText));
+        EXPECT_TRUE(container.hasChunk(filamat::ChunkType::MaterialGlsl));
+    }
+
+    // Both materials decode their shaders with the single dictionary of the library.
+    MaterialParser litParser({ backend::ShaderLanguage::ESSL3 }, lit->data, lit->size, &library);
+    MaterialParser unlitParser({ backend::ShaderLanguage::ESSL3 },
+            unlit->data, unlit->size, &library);
+    ASSERT_EQ(litParser.parse(), MaterialParser::ParseResult::SUCCESS);
+    ASSERT_EQ(unlitParser.parse(), MaterialParser::ParseResult::SUCCESS);
+    ASSERT_NE(litParser.getSharedDictionary(), nullptr);
+    EXPECT_EQ(litParser.getSharedDictionary(), unlitParser.getSharedDictionary());
+    EXPECT_EQ(litParser.getSharedDictionary(),
+            library.getDictionary(filamat::ChunkType::DictionaryText).get());
+
+    // Shaders common to both materials are only stored once.
+    size_t standaloneSize = 0;
+    for (auto const& material : kMaterials) {
+        standaloneSize += material.size;
+    }
+    EXPECT_LT(size_t(FILAMENT_TEST_LIBRARY_RESOURCES_TEST_LIBRARY_SIZE), standaloneSize);
+}
+
+TEST_F(MaterialLibraryTest, MaterialOutlivesLibrary) { // NOLINT
+    // The library is destroyed before its material is used, so the material must not read the
+    // library's package in place, even when asked to.
+    Material* const material = Material::Builder()
+            .package(*mLibrary, "sandboxLit")
+            .persistentPackage(true)
+            .build(*mEngine);
+    ASSERT_NE(material, nullptr);
+    mEngine->destroy(mLibrary);
+    mLibrary = nullptr;
+
+    FEngine const& engine = downcast(*mEngine);
+    FMaterial const* const fmaterial = downcast(material);
+    Variant const variant{};
+    fmaterial->prepareProgram(variant);
+    EXPECT_TRUE(fmaterial->isCached(variant));
+
+    // The engine keeps the last shaders it decoded around, they must match the original ones.
+    MaterialParser standalone({ backend::ShaderLanguage::ESSL3 },
+            kMaterials[0].data, kMaterials[0].size);
+    ASSERT_EQ(standalone.parse(), MaterialParser::ParseResult::SUCCESS);
+    ShaderContent expected;
+    ASSERT_TRUE(standalone.getShader(expected, engine.getShaderModel(),
+            Variant::filterVariantVertex(variant), backend::ShaderStage::VERTEX));
+    ShaderContent const& actual = engine.getVertexShaderContent();
+    ASSERT_EQ(expected.size(), actual.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin()));
+
+    mEngine->destroy(material);
+}
+
+TEST_F(MaterialLibraryTest, ProgramSharing) { // NOLINT
+    auto build = [this](StandaloneMaterial const& material) {
+        return downcast(Material::Builder()
+                .package(material.data, material.size)
+                .build(*mEngine));
+    };
+    Variant const variant{};
+
+    // Each material takes its own copy of the package, so identical packages are recognized by
+    // their content.
+    FMaterial* const lit0 = build(kMaterials[0]);
+    FMaterial* const lit1 = build(kMaterials[0]);
+    FMaterial* const unlit = build(kMaterials[1]);
+    for (FMaterial const* material : { lit0, lit1, unlit }) {
+        ASSERT_NE(material, nullptr);
+        material->prepareProgram(variant);
+        ASSERT_TRUE(material->isCached(variant));
+    }
+    EXPECT_EQ(lit0->getProgram(variant), lit1->getProgram(variant));
+    EXPECT_NE(lit0->getProgram(variant), unlit->getProgram(variant));
+
+    // The program outlives the material that created it, as long as another one uses it.
+    auto const program = lit0->getProgram(variant);
+    mEngine->destroy(lit0);
+    FMaterial* const lit2 = build(kMaterials[0]);
+    ASSERT_NE(lit2, nullptr);
+    lit2->prepareProgram(variant);
+    EXPECT_EQ(lit2->getProgram(variant), program);
+    EXPECT_EQ(lit1->getProgram(variant), program);
+
+    mEngine->destroy(lit1);
+    mEngine->destroy(lit2);
+    mEngine->destroy(unlit);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
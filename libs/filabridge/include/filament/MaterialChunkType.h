@@ -97,6 +97,10 @@ enum UTILS_PUBLIC ChunkType : uint64_t {
     DictionaryText = charTo64bitNum("DIC_TEXT"),
     DictionarySpirv = charTo64bitNum("DIC_SPIR"),
     DictionaryMetalLibrary = charTo64bitNum("DIC_MLIB"),
+
+    // Material libraries hold the shader dictionaries above, shared by all the materials they
+    // contain, and one material package per material whose shader chunks index into them.
+    LibraryMaterials = charTo64bitNum("LIB_MATS"),
 };
 
 } // namespace filamat
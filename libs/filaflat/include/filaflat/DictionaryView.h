@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAFLAT_DICTIONARY_VIEW_H
+#define TNT_FILAFLAT_DICTIONARY_VIEW_H
+
+#include <filaflat/ChunkContainer.h>
+
+#include <utils/FixedCapacityVector.h>
+
+#include <string_view>
+
+#include <stddef.h>
+
+namespace filaflat {
+
+// A dictionary that references its chunk in the package instead of copying it, unlike the
+// BlobDictionary produced by DictionaryReader. Only the position of each entry is recorded when
+// the view is initialized; text lines are then used in place and binary blobs are copied, or
+// decompressed in the case of SPIR-V, only when a shader needs them.
+// The package must outlive the view.
+class DictionaryView {
+public:
+    bool initialize(ChunkContainer const& container, ChunkContainer::Type dictionaryTag) noexcept;
+
+    size_t size() const noexcept { return mEntries.size(); }
+
+    // Returns a text line, without its terminating null character.
+    std::string_view getLine(size_t index) const noexcept {
+        return mEntries[index];
+    }
+
+    // Populates "content" with the given blob, decompressing it if needed.
+    bool getBlob(size_t index, ShaderContent& content) const noexcept;
+
+private:
+    ChunkContainer::Type mDictionaryTag = ChunkContainer::Type::Unknown;
+    utils::FixedCapacityVector<std::string_view> mEntries;
+};
+
+} // namespace filaflat
+
+#endif // TNT_FILAFLAT_DICTIONARY_VIEW_H
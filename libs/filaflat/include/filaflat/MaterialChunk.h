@@ -33,6 +33,8 @@
 
 namespace filaflat {
 
+class DictionaryView;
+
 class MaterialChunk {
 public:
     using ShaderModel = filament::backend::ShaderModel;
@@ -50,6 +52,10 @@ public:
     bool getShader(ShaderContent& shaderContent, BlobDictionary const& dictionary,
             ShaderModel shaderModel, filament::Variant variant, ShaderStage stage);
 
+    // same as above, but only the dictionary entries used by the shader are read.
+    bool getShader(ShaderContent& shaderContent, DictionaryView const& dictionary,
+            ShaderModel shaderModel, filament::Variant variant, ShaderStage stage);
+
     uint32_t getShaderCount() const noexcept;
 
     void visitShaders(utils::Invocable<void(ShaderModel, Variant, ShaderStage)>&& visitor) const;
@@ -70,12 +76,18 @@ private:
     const uint8_t* mBase = nullptr;
     tsl::robin_map<uint32_t, uint32_t> mOffsets;
 
+    template<typename Dictionary>
+    bool getShaderImpl(ShaderContent& shaderContent, Dictionary const& dictionary,
+            ShaderModel shaderModel, filament::Variant variant, ShaderStage stage);
+
+    template<typename Dictionary>
     bool getTextShader(Unflattener unflattener,
-            BlobDictionary const& dictionary, ShaderContent& shaderContent,
+            Dictionary const& dictionary, ShaderContent& shaderContent,
             ShaderModel shaderModel, filament::Variant variant, ShaderStage shaderStage);
 
+    template<typename Dictionary>
     bool getBinaryShader(
-            BlobDictionary const& dictionary, ShaderContent& shaderContent,
+            Dictionary const& dictionary, ShaderContent& shaderContent,
             ShaderModel shaderModel, filament::Variant variant, ShaderStage shaderStage);
 };
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filaflat/DictionaryView.h>
+
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/Unflattener.h>
+
+#if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
+#include <smolv.h>
+#endif
+
+#include <string.h>
+
+using namespace filamat;
+
+namespace filaflat {
+
+bool DictionaryView::initialize(ChunkContainer const& container,
+        ChunkContainer::Type dictionaryTag) noexcept {
+    auto [start, end] = container.getChunkRange(dictionaryTag);
+    if (start == end) {
+        return false;
+    }
+    Unflattener unflattener(start, end);
+    mDictionaryTag = dictionaryTag;
+
+    if (dictionaryTag == ChunkType::DictionarySpirv) {
+        uint32_t compressionScheme;
+        if (!unflattener.read(&compressionScheme) || compressionScheme != 1) {
+            return false;
+        }
+    }
+
+    uint32_t count;
+    if (!unflattener.read(&count)) {
+        return false;
+    }
+    // Every entry takes at least one byte, this protects the allocation below.
+    if (count > size_t(end - start)) {
+        return false;
+    }
+
+    mEntries = utils::FixedCapacityVector<std::string_view>::with_capacity(count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (dictionaryTag == ChunkType::DictionaryText) {
+            const char* str;
+            if (!unflattener.read(&str) || unflattener.getCursor() > end) {
+                return false;
+            }
+            const size_t length = (const char*)unflattener.getCursor() - str - 1;
+            mEntries.push_back({ str, length });
+        } else {
+            unflattener.skipAlignmentPadding();
+            const char* data;
+            size_t size;
+            if (!unflattener.read(&data, &size)) {
+                return false;
+            }
+            mEntries.push_back({ data, size });
+        }
+    }
+    return true;
+}
+
+bool DictionaryView::getBlob(size_t index, ShaderContent& content) const noexcept {
+    if (UTILS_UNLIKELY(index >= mEntries.size())) {
+        return false;
+    }
+    std::string_view const blob = mEntries[index];
+    if (mDictionaryTag == ChunkType::DictionarySpirv) {
+#if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
+        size_t const spirvSize = smolv::GetDecodedBufferSize(blob.data(), blob.size());
+        if (spirvSize == 0) {
+            return false;
+        }
+        content = ShaderContent(spirvSize);
+        return smolv::Decode(blob.data(), blob.size(), content.data(), spirvSize);
+#else
+        return false;
+#endif
+    }
+    content = ShaderContent(blob.size());
+    memcpy(content.data(), blob.data(), blob.size());
+    return true;
+}
+
+} // namespace filaflat
@@ -16,11 +16,14 @@
 
 #include <filaflat/MaterialChunk.h>
 #include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryView.h>
 
 #include <backend/DriverEnums.h>
 
 #include <utils/Log.h>
 
+#include <string_view>
+
 namespace filaflat {
 
 static inline uint32_t makeKey(
@@ -40,6 +43,37 @@ void MaterialChunk::decodeKey(uint32_t key,
     *stage = MaterialChunk::ShaderStage((key >> 8) & 0xff);
 }
 
+// Dictionary accessors shared by the decoded and the in-place dictionaries.
+
+static inline size_t getEntryCount(BlobDictionary const& dictionary) noexcept {
+    return dictionary.size();
+}
+
+static inline size_t getEntryCount(DictionaryView const& dictionary) noexcept {
+    return dictionary.size();
+}
+
+static inline std::string_view getLine(BlobDictionary const& dictionary, size_t index) noexcept {
+    // lines are stored with their terminating null character
+    auto const& content = dictionary[index];
+    return { (const char*)content.data(), content.size() - 1 };
+}
+
+static inline std::string_view getLine(DictionaryView const& dictionary, size_t index) noexcept {
+    return dictionary.getLine(index);
+}
+
+static inline bool getBlob(BlobDictionary const& dictionary, size_t index,
+        ShaderContent& shaderContent) noexcept {
+    shaderContent = dictionary[index];
+    return true;
+}
+
+static inline bool getBlob(DictionaryView const& dictionary, size_t index,
+        ShaderContent& shaderContent) noexcept {
+    return dictionary.getBlob(index, shaderContent);
+}
+
 MaterialChunk::MaterialChunk(ChunkContainer const& container)
         : mContainer(container) {
 }
@@ -95,8 +129,9 @@ bool MaterialChunk::initialize(filamat::ChunkType materialTag) {
     return true;
 }
 
+template<typename Dictionary>
 bool MaterialChunk::getTextShader(Unflattener unflattener,
-        BlobDictionary const& dictionary, ShaderContent& shaderContent,
+        Dictionary const& dictionary, ShaderContent& shaderContent,
         ShaderModel shaderModel, Variant variant, ShaderStage shaderStage) {
     if (mBase == nullptr) {
         return false;
@@ -135,14 +170,16 @@ bool MaterialChunk::getTextShader(Unflattener unflattener,
     // Read all lines.
     for(int32_t i = 0 ; i < lineCount; i++) {
         uint16_t lineIndex;
-        if (!unflattener.read(&lineIndex)) {
+        if (!unflattener.read(&lineIndex) || lineIndex >= getEntryCount(dictionary)) {
+            return false;
+        }
+        std::string_view const line = getLine(dictionary, lineIndex);
+        if (UTILS_UNLIKELY(cursor + line.size() + 1 >= shaderSize)) {
             return false;
         }
-        const auto& content = dictionary[lineIndex];
 
-        // Replace null with newline.
-        memcpy(&shaderContent[cursor], content.data(), content.size() - 1);
-        cursor += content.size() - 1;
+        memcpy(&shaderContent[cursor], line.data(), line.size());
+        cursor += line.size();
         shaderContent[cursor++] = '\n';
     }
 
@@ -153,7 +190,8 @@ bool MaterialChunk::getTextShader(Unflattener unflattener,
     return true;
 }
 
-bool MaterialChunk::getBinaryShader(BlobDictionary const& dictionary,
+template<typename Dictionary>
+bool MaterialChunk::getBinaryShader(Dictionary const& dictionary,
         ShaderContent& shaderContent, ShaderModel shaderModel, filament::Variant variant, ShaderStage shaderStage) {
 
     if (mBase == nullptr) {
@@ -166,8 +204,10 @@ bool MaterialChunk::getBinaryShader(BlobDictionary const& dictionary,
         return false;
     }
 
-    shaderContent = dictionary[pos->second];
-    return true;
+    if (UTILS_UNLIKELY(pos->second >= getEntryCount(dictionary))) {
+        return false;
+    }
+    return getBlob(dictionary, pos->second, shaderContent);
 }
 
 bool MaterialChunk::hasShader(ShaderModel model, Variant variant, ShaderStage stage) const noexcept {
@@ -180,6 +220,17 @@ bool MaterialChunk::hasShader(ShaderModel model, Variant variant, ShaderStage st
 
 bool MaterialChunk::getShader(ShaderContent& shaderContent, BlobDictionary const& dictionary,
         ShaderModel shaderModel, filament::Variant variant, ShaderStage stage) {
+    return getShaderImpl(shaderContent, dictionary, shaderModel, variant, stage);
+}
+
+bool MaterialChunk::getShader(ShaderContent& shaderContent, DictionaryView const& dictionary,
+        ShaderModel shaderModel, filament::Variant variant, ShaderStage stage) {
+    return getShaderImpl(shaderContent, dictionary, shaderModel, variant, stage);
+}
+
+template<typename Dictionary>
+bool MaterialChunk::getShaderImpl(ShaderContent& shaderContent, Dictionary const& dictionary,
+        ShaderModel shaderModel, filament::Variant variant, ShaderStage stage) {
     switch (mMaterialTag) {
         case filamat::ChunkType::MaterialGlsl:
         case filamat::ChunkType::MaterialEssl1:
@@ -125,6 +125,15 @@ public:
      */
     static void shutdown();
 
+    /**
+     * Returns an identifier of this build of filamat.
+     *
+     * It changes when the material format or the shader sources embedded in the library change,
+     * i.e. when the same MaterialBuilder settings may produce a different package. Tools that
+     * cache built packages should include it in their cache keys.
+     */
+    static uint64_t getBuildId() noexcept;
+
 protected:
     // Looks at platform and target API, then decides on shader models and output formats.
     void prepare(bool vulkanSemantics, filament::backend::FeatureLevel featureLevel);
@@ -136,6 +145,7 @@ protected:
     bool mPrintShaders = false;
     bool mSaveRawVariants = false;
     bool mGenerateDebugInfo = false;
+    bool mAggressiveMinification = false;
     bool mIncludeEssl1 = true;
     utils::bitset32 mShaderModels;
     struct CodeGenParams {
@@ -601,6 +611,53 @@ public:
     //! If true, will include debugging information in generated SPIRV.
     MaterialBuilder& generateDebugInfo(bool generateDebugInfo) noexcept;
 
+    /**
+     * If true, the GLSL shaders are minified at the token level on top of the default whitespace
+     * removal: comments and unneeded spaces are stripped, local variables and parameters are
+     * renamed to the shortest available identifiers and functions not reachable from main() are
+     * removed. This reduces the size of the material and the time drivers spend parsing the
+     * shaders. It has no effect when debug information is generated. Defaults to false.
+     */
+    MaterialBuilder& aggressiveMinification(bool enabled) noexcept;
+
+    /**
+     * Enables a persistent cache of compiled shaders (optimized GLSL, SPIR-V and MSL) in the given
+     * directory, which is created if needed. Shaders whose generated code and compilation settings
+     * are unchanged are read back from the cache instead of being compiled again, which makes
+     * rebuilding a library of materials after a small change much faster. The directory can be
+     * shared by concurrent builds. Passing null disables the cache, which is the default.
+     */
+    MaterialBuilder& shaderCacheDirectory(const char* directory) noexcept;
+
+    struct ShaderCacheStats {
+        size_t hits = 0;     //!< number of shaders read from the cache
+        size_t misses = 0;   //!< number of shaders compiled and added to the cache
+    };
+
+    //! Returns the shader cache statistics of the last call to build().
+    ShaderCacheStats getShaderCacheStats() const noexcept { return mShaderCacheStats; }
+
+    //! Time spent in each stage of shader compilation, in seconds, summed over all threads.
+    struct ShaderTimings {
+        double generation = 0;          //!< generation of the GLSL source of each variant
+        double parsing = 0;             //!< glslang parsing and linking, SPIR-V generation
+        double optimization = 0;        //!< SPIR-V optimizer passes
+        double crossCompilation = 0;    //!< SPIR-V to MSL and GLSL with SPIRV-Cross
+        double minification = 0;        //!< GLSL whitespace removal and field renaming
+    };
+
+    //! Returns the time spent compiling shaders during the last call to build().
+    ShaderTimings getShaderTimings() const noexcept { return mShaderTimings; }
+
+    //! Size of the GLSL shaders compiled by build(), excluding the ones read from the cache.
+    struct MinificationStats {
+        size_t sourceSize = 0;      //!< total size of the shaders before minification, in bytes
+        size_t minifiedSize = 0;    //!< total size of the shaders after minification, in bytes
+    };
+
+    //! Returns the GLSL minification statistics of the last call to build().
+    MinificationStats getMinificationStats() const noexcept { return mMinificationStats; }
+
     //! Specifies a list of variants that should be filtered out during code generation.
     MaterialBuilder& variantFilter(filament::UserVariantFilterMask variantFilter) noexcept;
 
@@ -817,7 +874,8 @@ private:
     bool generateShaders(
             utils::JobSystem& jobSystem,
             const std::vector<filamat::Variant>& variants, ChunkContainer& container,
-            const MaterialInfo& info) const noexcept;
+            const MaterialInfo& info, ShaderCacheStats& cacheStats,
+            ShaderTimings& timings, MinificationStats& minificationStats) const noexcept;
 
     bool hasCustomVaryings() const noexcept;
     bool needsStandardDepthProgram() const noexcept;
@@ -826,6 +884,10 @@ private:
 
     utils::CString mMaterialName;
     utils::CString mFileName;
+    utils::CString mShaderCacheDirectory;
+    ShaderCacheStats mShaderCacheStats;
+    ShaderTimings mShaderTimings;
+    MinificationStats mMinificationStats;
 
     class ShaderCode {
     public:
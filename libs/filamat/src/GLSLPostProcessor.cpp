@@ -40,6 +40,8 @@
 
 #include <utils/Log.h>
 
+#include <chrono>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
@@ -291,16 +293,60 @@ static void collectDescriptorSets(const GLSLPostProcessor::Config& config, Descr
 GLSLPostProcessor::GLSLPostProcessor(MaterialBuilder::Optimization optimization, uint32_t flags)
         : mOptimization(optimization),
           mPrintShaders(flags & PRINT_SHADERS),
-          mGenerateDebugInfo(flags & GENERATE_DEBUG_INFO) {
-    // SPIRV error handler registration needs to occur only once. To avoid a race we do it up here
-    // in the constructor, which gets invoked before MaterialBuilder kicks off jobs.
-    spv::spirvbin_t::registerErrorHandler([](const std::string& str) {
-        slog.e << str << io::endl;
-    });
+          mGenerateDebugInfo(flags & GENERATE_DEBUG_INFO),
+          mAggressiveMinification(flags & AGGRESSIVE_MINIFICATION) {
 }
 
 GLSLPostProcessor::~GLSLPostProcessor() = default;
 
+void GLSLPostProcessor::init() {
+    // The SPIR-V error handler is a global. Post-processors are created concurrently when several
+    // materials are built at once, so it must be registered only once, before any of them.
+    static std::once_flag registered;
+    std::call_once(registered, [] {
+        spv::spirvbin_t::registerErrorHandler([](const std::string& str) {
+            slog.e << str << io::endl;
+        });
+    });
+}
+
+// Adds the time spent in its scope to one of the stages of the post-processor.
+class GLSLPostProcessor::StageTimer {
+public:
+    StageTimer(GLSLPostProcessor const& postProcessor, Stage stage) noexcept
+            : mTime(postProcessor.mStageTimes[size_t(stage)]),
+              mStart(std::chrono::steady_clock::now()) {
+    }
+
+    ~StageTimer() noexcept {
+        std::chrono::nanoseconds const elapsed = std::chrono::steady_clock::now() - mStart;
+        mTime.fetch_add(uint64_t(elapsed.count()), std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t>& mTime;
+    std::chrono::steady_clock::time_point const mStart;
+};
+
+MaterialBuilder::ShaderTimings GLSLPostProcessor::getTimings() const noexcept {
+    auto seconds = [this](Stage stage) {
+        return double(mStageTimes[size_t(stage)].load(std::memory_order_relaxed)) * 1e-9;
+    };
+    MaterialBuilder::ShaderTimings timings;
+    timings.parsing = seconds(Stage::PARSING);
+    timings.optimization = seconds(Stage::OPTIMIZATION);
+    timings.crossCompilation = seconds(Stage::CROSS_COMPILATION);
+    timings.minification = seconds(Stage::MINIFICATION);
+    return timings;
+}
+
+MaterialBuilder::MinificationStats GLSLPostProcessor::getMinificationStats() const noexcept {
+    MaterialBuilder::MinificationStats stats;
+    stats.sourceSize = size_t(mSourceSize.load(std::memory_order_relaxed));
+    stats.minifiedSize = size_t(mMinifiedSize.load(std::memory_order_relaxed));
+    return stats;
+}
+
 static bool filterSpvOptimizerMessage(spv_message_level_t level) {
 #ifdef NDEBUG
     // In release builds, only log errors.
@@ -557,36 +603,45 @@ bool GLSLPostProcessor::process(const std::string& inputShader, Config const& co
         msg = EShMessages(Type(msg) | Type(EShMessages::EShMsgVulkanRules));
     }
 
-    bool const ok = tShader.parse(&DefaultTBuiltInResource, internalConfig.langVersion, false, msg);
-    if (!ok) {
-        slog.e << tShader.getInfoLog() << io::endl;
-        return false;
-    }
+    {
+        StageTimer const timer(*this, Stage::PARSING);
 
-    // add texture lod bias
-    if (config.shaderType == backend::ShaderStage::FRAGMENT &&
-        config.domain == MaterialDomain::SURFACE) {
-        GLSLTools::textureLodBias(tShader);
-    }
+        bool const ok = tShader.parse(&DefaultTBuiltInResource, internalConfig.langVersion, false,
+                msg);
+        if (!ok) {
+            slog.e << tShader.getInfoLog() << io::endl;
+            return false;
+        }
 
-    program.addShader(&tShader);
-    // Even though we only have a single shader stage, linking is still necessary to finalize
-    // SPIR-V types
-    bool const linkOk = program.link(msg);
-    if (!linkOk) {
-        slog.e << tShader.getInfoLog() << io::endl;
-        return false;
+        // add texture lod bias
+        if (config.shaderType == backend::ShaderStage::FRAGMENT &&
+            config.domain == MaterialDomain::SURFACE) {
+            GLSLTools::textureLodBias(tShader);
+        }
+
+        program.addShader(&tShader);
+        // Even though we only have a single shader stage, linking is still necessary to finalize
+        // SPIR-V types
+        bool const linkOk = program.link(msg);
+        if (!linkOk) {
+            slog.e << tShader.getInfoLog() << io::endl;
+            return false;
+        }
     }
 
     switch (mOptimization) {
         case MaterialBuilder::Optimization::NONE:
             if (internalConfig.spirvOutput) {
-                SpvOptions options;
-                options.generateDebugInfo = mGenerateDebugInfo;
-                GlslangToSpv(*program.getIntermediate(internalConfig.shLang),
-                        *internalConfig.spirvOutput, &options);
-                fixupClipDistance(*internalConfig.spirvOutput, config);
+                {
+                    StageTimer const timer(*this, Stage::PARSING);
+                    SpvOptions options;
+                    options.generateDebugInfo = mGenerateDebugInfo;
+                    GlslangToSpv(*program.getIntermediate(internalConfig.shLang),
+                            *internalConfig.spirvOutput, &options);
+                    fixupClipDistance(*internalConfig.spirvOutput, config);
+                }
                 if (internalConfig.mslOutput) {
+                    StageTimer const timer(*this, Stage::CROSS_COMPILATION);
                     auto sibs = SibVector::with_capacity(CONFIG_SAMPLER_BINDING_COUNT);
                     DescriptorSets descriptors {};
                     msl::collectDescriptorSets(config, descriptors);
@@ -615,6 +670,8 @@ bool GLSLPostProcessor::process(const std::string& inputShader, Config const& co
 
     if (internalConfig.glslOutput) {
         if (!mGenerateDebugInfo) {
+            StageTimer const timer(*this, Stage::MINIFICATION);
+            mSourceSize.fetch_add(internalConfig.glslOutput->size(), std::memory_order_relaxed);
             *internalConfig.glslOutput =
                     internalConfig.minifier.removeWhitespace(
                             *internalConfig.glslOutput,
@@ -625,6 +682,12 @@ bool GLSLPostProcessor::process(const std::string& inputShader, Config const& co
                 *internalConfig.glslOutput =
                         internalConfig.minifier.renameStructFields(*internalConfig.glslOutput);
             }
+
+            if (mAggressiveMinification) {
+                *internalConfig.glslOutput =
+                        internalConfig.minifier.minifyTokens(*internalConfig.glslOutput);
+            }
+            mMinifiedSize.fetch_add(internalConfig.glslOutput->size(), std::memory_order_relaxed);
         }
         if (mPrintShaders) {
             slog.i << *internalConfig.glslOutput << io::endl;
@@ -640,6 +703,7 @@ void GLSLPostProcessor::preprocessOptimization(glslang::TShader& tShader,
 
     std::string glsl;
     TShader::ForbidIncluder forbidIncluder;
+    std::optional<StageTimer> parsingTimer(std::in_place, *this, Stage::PARSING);
 
     const int version = GLSLTools::getGlslDefaultVersion(config.shaderModel);
     EShMessages const msg =
@@ -679,7 +743,10 @@ void GLSLPostProcessor::preprocessOptimization(glslang::TShader& tShader,
         }
     }
 
+    parsingTimer.reset();
+
     if (internalConfig.mslOutput) {
+        StageTimer const timer(*this, Stage::CROSS_COMPILATION);
         DescriptorSets descriptors {};
         msl::collectDescriptorSets(config, descriptors);
 #if DEBUG_LOG_DESCRIPTOR_SETS == 1
@@ -702,27 +769,35 @@ bool GLSLPostProcessor::fullOptimization(const TShader& tShader,
     bool const optimizeForSize = mOptimization == MaterialBuilderBase::Optimization::SIZE;
 
     // Compile GLSL to to SPIR-V
-    SpvOptions options;
-    options.generateDebugInfo = mGenerateDebugInfo;
-    GlslangToSpv(*tShader.getIntermediate(), spirv, &options);
+    {
+        StageTimer const timer(*this, Stage::PARSING);
+        SpvOptions options;
+        options.generateDebugInfo = mGenerateDebugInfo;
+        GlslangToSpv(*tShader.getIntermediate(), spirv, &options);
+    }
 
-    if (internalConfig.spirvOutput) {
-        // Run the SPIR-V optimizer
-        OptimizerPtr const optimizer = createOptimizer(mOptimization, config);
-        optimizeSpirv(optimizer, spirv);
-    } else {
-        if (!optimizeForSize) {
+    {
+        StageTimer const timer(*this, Stage::OPTIMIZATION);
+        if (internalConfig.spirvOutput) {
+            // Run the SPIR-V optimizer
             OptimizerPtr const optimizer = createOptimizer(mOptimization, config);
             optimizeSpirv(optimizer, spirv);
+        } else {
+            if (!optimizeForSize) {
+                OptimizerPtr const optimizer = createOptimizer(mOptimization, config);
+                optimizeSpirv(optimizer, spirv);
+            }
         }
-    }
 
-    fixupClipDistance(spirv, config);
+        fixupClipDistance(spirv, config);
+    }
 
     if (internalConfig.spirvOutput) {
         *internalConfig.spirvOutput = spirv;
     }
 
+    StageTimer const crossCompilationTimer(*this, Stage::CROSS_COMPILATION);
+
     if (internalConfig.mslOutput) {
         DescriptorSets descriptors {};
         msl::collectDescriptorSets(config, descriptors);
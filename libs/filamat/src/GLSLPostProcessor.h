@@ -32,6 +32,8 @@
 
 #include <utils/FixedCapacityVector.h>
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <string>
@@ -55,12 +57,16 @@ public:
     enum Flags : uint32_t {
         PRINT_SHADERS = 1 << 0,
         GENERATE_DEBUG_INFO = 1 << 1,
+        AGGRESSIVE_MINIFICATION = 1 << 2,
     };
 
     GLSLPostProcessor(MaterialBuilder::Optimization optimization, uint32_t flags);
 
     ~GLSLPostProcessor();
 
+    // Sets up the global state shared by all post-processors, see MaterialBuilder::init().
+    static void init();
+
     struct Config {
         filament::Variant variant;
         filament::UserVariantFilterMask variantFilter;
@@ -83,6 +89,13 @@ public:
             SpirvBlob* outputSpirv,
             std::string* outputMsl);
 
+    // Returns the time spent in each stage of process(), summed over all calls and threads.
+    // The code generation time is not known to the post-processor and is left to zero.
+    MaterialBuilder::ShaderTimings getTimings() const noexcept;
+
+    // Returns the size of the GLSL shaders before and after minification, summed over all calls.
+    MaterialBuilder::MinificationStats getMinificationStats() const noexcept;
+
     // public so backend_test can also use it
     static void spirvToMsl(const SpirvBlob* spirv, std::string* outMsl,
             filament::backend::ShaderStage stage, filament::backend::ShaderModel shaderModel,
@@ -107,7 +120,8 @@ private:
             GLSLPostProcessor::Config const& config, InternalConfig& internalConfig) const;
 
     /**
-     * Retrieve an optimizer instance tuned for the given optimization level and shader configuration.
+     * Create an optimizer instance tuned for the given optimization level and shader configuration.
+     * Optimizers can't be reused: spvtools passes refuse to run more than once.
      */
     using OptimizerPtr = std::shared_ptr<spvtools::Optimizer>;
     static OptimizerPtr createOptimizer(
@@ -121,9 +135,25 @@ private:
 
     void fixupClipDistance(SpirvBlob& spirv, GLSLPostProcessor::Config const& config) const;
 
+    enum class Stage : uint8_t {
+        PARSING,
+        OPTIMIZATION,
+        CROSS_COMPILATION,
+        MINIFICATION,
+        COUNT
+    };
+
+    class StageTimer;
+
     const MaterialBuilder::Optimization mOptimization;
     const bool mPrintShaders;
     const bool mGenerateDebugInfo;
+    const bool mAggressiveMinification;
+
+    // Nanoseconds spent in each stage, updated concurrently by the jobs calling process().
+    mutable std::array<std::atomic<uint64_t>, size_t(Stage::COUNT)> mStageTimes{};
+    mutable std::atomic<uint64_t> mSourceSize{ 0 };
+    mutable std::atomic<uint64_t> mMinifiedSize{ 0 };
 };
 
 } // namespace filamat
@@ -25,6 +25,7 @@
 #include "shaders/UibGenerator.h"
 
 #include "GLSLPostProcessor.h"
+#include "ShaderCache.h"
 #include "sca/GLSLTools.h"
 
 #include "shaders/MaterialInfo.h"
@@ -40,6 +41,8 @@
 #include "eiff/DictionaryTextChunk.h"
 #include "eiff/DictionarySpirvChunk.h"
 
+#include "generated/shaders.h"
+
 #include <private/filament/BufferInterfaceBlock.h>
 #include <private/filament/SamplerInterfaceBlock.h>
 #include <private/filament/UibStructs.h>
@@ -61,6 +64,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -69,6 +73,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 namespace filamat {
 
@@ -194,6 +199,7 @@ MaterialBuilder::~MaterialBuilder() = default;
 void MaterialBuilderBase::init() {
     materialBuilderClients++;
     GLSLTools::init();
+    GLSLPostProcessor::init();
 }
 
 void MaterialBuilderBase::shutdown() {
@@ -201,6 +207,12 @@ void MaterialBuilderBase::shutdown() {
     GLSLTools::shutdown();
 }
 
+uint64_t MaterialBuilderBase::getBuildId() noexcept {
+    static uint64_t const buildId = ContentHasher(MATERIAL_VERSION)
+            .add(SHADERS_PACKAGE, size_t(SHADERS_PACKAGE_SIZE)).get().low;
+    return buildId;
+}
+
 MaterialBuilder& MaterialBuilder::name(const char* name) noexcept {
     mMaterialName = CString(name);
     return *this;
@@ -582,6 +594,16 @@ MaterialBuilder& MaterialBuilder::generateDebugInfo(bool generateDebugInfo) noex
     return *this;
 }
 
+MaterialBuilder& MaterialBuilder::aggressiveMinification(bool enabled) noexcept {
+    mAggressiveMinification = enabled;
+    return *this;
+}
+
+MaterialBuilder& MaterialBuilder::shaderCacheDirectory(const char* directory) noexcept {
+    mShaderCacheDirectory = CString(directory);
+    return *this;
+}
+
 MaterialBuilder& MaterialBuilder::variantFilter(UserVariantFilterMask variantFilter) noexcept {
     mVariantFilter = variantFilter;
     return *this;
@@ -856,15 +878,67 @@ static void showErrorMessage(const char* materialName, filament::Variant variant
             << shaderCode;
 }
 
+// Computes the shader cache key of a generated shader. Besides the code itself, this covers every
+// input of GLSLPostProcessor::process(), including the material properties used to lay out
+// descriptor sets for Metal. The material version is included so that a new release of the
+// tools never picks up entries produced by an older one.
+static ShaderCache::Key getShaderCacheKey(std::string_view shader, GLSLPostProcessor::Config const& config,
+        MaterialBuilder::Optimization optimization, bool generateDebugInfo,
+        bool aggressiveMinification) noexcept {
+    ContentHasher hasher(MATERIAL_VERSION);
+    hasher.add(shader)
+            .add(optimization)
+            .add(generateDebugInfo)
+            .add(aggressiveMinification)
+            .add(config.variant.key)
+            .add(config.variantFilter)
+            .add(config.targetApi)
+            .add(config.targetLanguage)
+            .add(config.shaderType)
+            .add(config.shaderModel)
+            .add(config.featureLevel)
+            .add(config.domain)
+            .add(config.hasFramebufferFetch)
+            .add(config.usesClipDistance);
+
+    MaterialInfo const& info = *config.materialInfo;
+    hasher.add(info.isLit)
+            .add(info.hasShadowMultiplier)
+            .add(info.reflectionMode)
+            .add(info.refractionMode)
+            .add(info.stereoscopicType)
+            .add(info.stereoscopicEyeCount);
+    for (auto const& sampler : info.sib.getSamplerInfoList()) {
+        hasher.add(sampler.name.c_str_safe(), sampler.name.size())
+                .add(sampler.uniformName.c_str_safe(), sampler.uniformName.size())
+                .add(sampler.binding)
+                .add(sampler.type)
+                .add(sampler.format)
+                .add(sampler.precision)
+                .add(sampler.multisample);
+    }
+    for (auto const& [index, location] : config.glsl.subpassInputToColorLocation) {
+        hasher.add(index).add(location);
+    }
+    return hasher.get();
+}
+
 bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Variant>& variants,
-        ChunkContainer& container, const MaterialInfo& info) const noexcept {
+        ChunkContainer& container, const MaterialInfo& info,
+        ShaderCacheStats& cacheStats, ShaderTimings& timings,
+        MinificationStats& minificationStats) const noexcept {
     // Create a postprocessor to optimize / compile to Spir-V if necessary.
 
     uint32_t flags = 0;
     flags |= mPrintShaders ? GLSLPostProcessor::PRINT_SHADERS : 0;
     flags |= mGenerateDebugInfo ? GLSLPostProcessor::GENERATE_DEBUG_INFO : 0;
+    flags |= mAggressiveMinification ? GLSLPostProcessor::AGGRESSIVE_MINIFICATION : 0;
     GLSLPostProcessor postProcessor(mOptimization, flags);
 
+    // Compiled shaders are looked up in the cache first, unless they need to be printed.
+    ShaderCache const shaderCache(mShaderCacheDirectory.c_str_safe());
+    const bool readShaderCache = shaderCache.isEnabled() && !mPrintShaders;
+
     // Start: must be protected by lock
     Mutex entriesLock;
     std::vector<TextEntry> glslEntries;
@@ -883,11 +957,20 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
     container.emplace<bool>(ChunkType::MaterialHasCustomDepthShader, needsStandardDepthProgram());
 
     std::atomic_bool cancelJobs(false);
-    bool firstJob = true;
+    std::atomic<uint64_t> generationTime(0);
+    std::atomic_bool glslangUsed(false);
+
+    // The permutations are compiled by children of a single job, so that the shaders of one
+    // target API don't wait for the slowest shader of the previous one. The job system holds at
+    // most JobSystem::MAX_JOB_COUNT jobs, shared with the other materials being built, so the
+    // jobs are started in batches of at most kMaxJobsInFlight.
+    constexpr size_t kMaxJobsInFlight = 256;
+    size_t jobsInFlight = 0;
+    JobSystem::Job* parent = jobSystem.createJob();
 
     for (const auto& params : mCodeGenPermutations) {
         if (cancelJobs.load()) {
-            return false;
+            break;
         }
 
         const ShaderModel shaderModel = ShaderModel(params.shaderModel);
@@ -903,11 +986,11 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
         const bool targetApiNeedsMsl = targetApi == TargetApi::METAL;
         const bool targetApiNeedsGlsl = targetApi == TargetApi::OPENGL;
 
-        // Set when a job fails
-        JobSystem::Job* parent = jobSystem.createJob();
-
         for (const auto& v : variants) {
-            JobSystem::Job* job = jobs::createJob(jobSystem, parent, [&]() {
+            // The permutation is captured by value, the job may run after this iteration.
+            JobSystem::Job* job = jobs::createJob(jobSystem, parent, [&, params, v, shaderModel,
+                    targetApi, targetLanguage, featureLevel, targetApiNeedsSpirv,
+                    targetApiNeedsMsl, targetApiNeedsGlsl]() {
                 if (cancelJobs.load()) {
                     return;
                 }
@@ -935,6 +1018,7 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                 // The quotes in Google-style line directives cause problems with certain drivers. These
                 // directives are optimized away when using the full filamat, so down below we
                 // explicitly remove them when using filamat lite.
+                auto const generationStart = std::chrono::steady_clock::now();
                 std::string shader;
                 if (v.stage == backend::ShaderStage::VERTEX) {
                     shader = sg.createVertexProgram(
@@ -949,6 +1033,10 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                             shaderModel, targetApi, targetLanguage, featureLevel,
                             info);
                 }
+                std::chrono::nanoseconds const generationDuration =
+                        std::chrono::steady_clock::now() - generationStart;
+                generationTime.fetch_add(uint64_t(generationDuration.count()),
+                        std::memory_order_relaxed);
 
                 // Write the variant to a file.
                 if (mSaveRawVariants) {
@@ -998,15 +1086,48 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                     config.glsl.subpassInputToColorLocation.emplace_back(0, 0);
                 }
 
-                bool const ok = postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
-                if (!ok) {
-                    showErrorMessage(mMaterialName.c_str_safe(), v.variant, targetApi, v.stage,
-                                     featureLevel, shader);
-                    cancelJobs = true;
-                    if (mPrintShaders) {
-                        slog.e << shader << io::endl;
+                // Only the output that is actually emitted below is cached: GLSL for OpenGL,
+                // SPIR-V for Vulkan and MSL for Metal.
+                ShaderCache::Key cacheKey;
+                bool cacheHit = false;
+                if (shaderCache.isEnabled()) {
+                    cacheKey = getShaderCacheKey(shader, config, mOptimization, mGenerateDebugInfo,
+                            mAggressiveMinification);
+                }
+                if (readShaderCache) {
+                    std::vector<uint8_t> blob;
+                    if (shaderCache.get(cacheKey, &blob)) {
+                        cacheHit = true;
+                        if (targetApiNeedsGlsl) {
+                            shader.assign(blob.begin(), blob.end());
+                        } else if (targetApiNeedsMsl) {
+                            msl.assign(blob.begin(), blob.end());
+                        } else {
+                            spirv.resize(blob.size() / sizeof(uint32_t));
+                            memcpy(spirv.data(), blob.data(), spirv.size() * sizeof(uint32_t));
+                        }
+                    }
+                }
+
+                if (!cacheHit) {
+                    bool const ok = postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
+                    glslangUsed.store(true);
+                    if (!ok) {
+                        showErrorMessage(mMaterialName.c_str_safe(), v.variant, targetApi,
+                                v.stage, featureLevel, shader);
+                        cancelJobs = true;
+                        if (mPrintShaders) {
+                            slog.e << shader << io::endl;
+                        }
+                        return;
+                    }
+                    if (targetApiNeedsGlsl) {
+                        shaderCache.put(cacheKey, shader.data(), shader.size());
+                    } else if (targetApiNeedsMsl) {
+                        shaderCache.put(cacheKey, msl.data(), msl.size());
+                    } else {
+                        shaderCache.put(cacheKey, spirv.data(), spirv.size() * sizeof(uint32_t));
                     }
-                    return;
                 }
 
                 if (targetApi == TargetApi::OPENGL) {
@@ -1047,7 +1168,6 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                         break;
                     }
                     case TargetApi::METAL:
-                        assert(!spirv.empty());
                         assert(msl.length() > 0);
                         metalEntry.stage = v.stage;
                         metalEntry.shader = msl;
@@ -1056,20 +1176,32 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                 }
             });
 
-            // NOTE: We run the first job separately to work the lack of thread safety
-            //       guarantees in glslang. This library performs unguarded global
-            //       operations on first use.
-            if (firstJob) {
+            // NOTE: We run jobs one at a time until one of them has gone through glslang, to
+            //       work around the lack of thread safety guarantees in glslang. This library
+            //       performs unguarded global operations on first use. Jobs whose shader is
+            //       found in the shader cache don't use glslang at all.
+            if (!glslangUsed.load()) {
                 jobSystem.runAndWait(job);
-                firstJob = false;
             } else {
                 jobSystem.run(job);
+                if (++jobsInFlight == kMaxJobsInFlight) {
+                    jobSystem.runAndWait(parent);
+                    parent = jobSystem.createJob();
+                    jobsInFlight = 0;
+                }
             }
         }
-
-        jobSystem.runAndWait(parent);
     }
 
+    jobSystem.runAndWait(parent);
+
+    cacheStats.hits = shaderCache.getHitCount();
+    cacheStats.misses = shaderCache.getMissCount();
+
+    timings = postProcessor.getTimings();
+    timings.generation = double(generationTime.load()) * 1e-9;
+    minificationStats = postProcessor.getMinificationStats();
+
     if (cancelJobs.load()) {
         return false;
     }
@@ -1291,7 +1423,11 @@ error:
             break;
     }
 
-    success = generateShaders(jobSystem, variants, container, info);
+    mShaderCacheStats = {};
+    mShaderTimings = {};
+    mMinificationStats = {};
+    success = generateShaders(jobSystem, variants, container, info, mShaderCacheStats,
+            mShaderTimings, mMinificationStats);
     if (!success) {
         // Return an empty package to signal a failure to build the material.
         goto error;
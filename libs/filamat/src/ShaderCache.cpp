@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ShaderCache.h"
+
+#include <utils/Log.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace utils;
+
+namespace filamat {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x4843534d; // "MSCH"
+constexpr uint32_t kVersion = 2;
+
+struct EntryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t keyLow;
+    uint64_t keyHigh;
+    uint64_t size;
+};
+
+} // anonymous namespace
+
+ShaderCache::ShaderCache(const char* directory) {
+    if (!directory || !*directory) {
+        return;
+    }
+    Path path(directory);
+    if (!path.mkdirRecursive()) {
+        slog.w << "Unable to create shader cache directory " << path
+               << ", caching disabled." << io::endl;
+        return;
+    }
+    mDirectory = path;
+}
+
+Path ShaderCache::getEntryPath(Key const& key) const {
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx%016llx.bin",
+            (unsigned long long) key.high, (unsigned long long) key.low);
+    return mDirectory + Path(name);
+}
+
+bool ShaderCache::get(Key const& key, std::vector<uint8_t>* blob) const {
+    if (!isEnabled()) {
+        return false;
+    }
+    auto miss = [this]() {
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    };
+    std::ifstream in(getEntryPath(key).getPath(), std::ifstream::in | std::ifstream::binary);
+    if (!in) {
+        return miss();
+    }
+    EntryHeader header{};
+    if (!in.read((char*) &header, sizeof(header)) || header.magic != kMagic ||
+            header.version != kVersion || header.keyLow != key.low ||
+            header.keyHigh != key.high) {
+        return miss();
+    }
+    blob->resize(header.size);
+    if (!in.read((char*) blob->data(), std::streamsize(header.size))) {
+        blob->clear();
+        return miss();
+    }
+    mHits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ShaderCache::put(Key const& key, const void* data, size_t size) const {
+    if (!isEnabled()) {
+        return;
+    }
+
+    // Write to a unique temporary file first, such that readers never observe a partial entry.
+    // The random salt keeps temporary names distinct across processes sharing the directory.
+    static const uint32_t sSalt = std::random_device{}();
+    static std::atomic<uint32_t> sCounter{ 0 };
+    const Path path = getEntryPath(key);
+    const std::string temp = path.getPath() + ".tmp" + std::to_string(sSalt) + "-" +
+            std::to_string(sCounter++);
+    {
+        std::ofstream out(temp, std::ofstream::out | std::ofstream::binary);
+        const EntryHeader header{ kMagic, kVersion, key.low, key.high, size };
+        out.write((const char*) &header, sizeof(header));
+        out.write((const char*) data, std::streamsize(size));
+        if (!out) {
+            out.close();
+            std::remove(temp.c_str());
+            return;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+    }
+}
+
+} // namespace filamat
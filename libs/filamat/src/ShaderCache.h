@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMAT_SHADERCACHE_H
+#define TNT_FILAMAT_SHADERCACHE_H
+
+#include <utils/ContentHasher.h>
+#include <utils/Path.h>
+
+#include <atomic>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filamat {
+
+// Persists the output of GLSLPostProcessor (optimized GLSL, SPIR-V or MSL) across matc
+// invocations, using one file per shader.
+//
+// The cache is content-addressed: the key is a 128-bit hash of the generated GLSL and of every
+// setting that influences post-processing (see utils::ContentHasher), so entries never need to be
+// invalidated. Each entry is prefixed with a small header that records the full key and the
+// payload size, which guards against truncated files and entries written by other versions.
+// Entries are written to a temporary file and then renamed, so concurrent jobs (or matc
+// processes) may share the same directory.
+//
+// A cache constructed with an empty directory is disabled, and all lookups miss.
+class ShaderCache {
+public:
+    using Key = utils::ContentHasher::Digest;
+
+    explicit ShaderCache(const char* directory);
+
+    bool isEnabled() const noexcept { return !mDirectory.isEmpty(); }
+
+    // Returns true and populates the given blob if an entry exists for the given key.
+    bool get(Key const& key, std::vector<uint8_t>* blob) const;
+
+    // Stores a blob under the given key, replacing any existing entry. Failures are not fatal
+    // since the cache is only an optimization.
+    void put(Key const& key, const void* data, size_t size) const;
+
+    size_t getHitCount() const noexcept { return mHits.load(std::memory_order_relaxed); }
+    size_t getMissCount() const noexcept { return mMisses.load(std::memory_order_relaxed); }
+
+private:
+    utils::Path getEntryPath(Key const& key) const;
+    utils::Path mDirectory;
+    mutable std::atomic<size_t> mHits{ 0 };
+    mutable std::atomic<size_t> mMisses{ 0 };
+};
+
+} // namespace filamat
+
+#endif // TNT_FILAMAT_SHADERCACHE_H
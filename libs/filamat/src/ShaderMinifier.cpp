@@ -19,6 +19,10 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+
 namespace filamat {
 
 static bool isIdCharNondigit(char c) {
@@ -335,4 +339,464 @@ std::string ShaderMinifier::applyFieldMapping() const {
     return result;
 }
 
+// ------------------------------------------------------------------------------------------------
+// Token-level minification
+// ------------------------------------------------------------------------------------------------
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Operators made of several characters, which must not be split or merged when whitespace is removed.
+static bool isMultiCharOperator(std::string_view s) {
+    static const std::unordered_set<std::string_view> operators = {
+            "++", "--", "+=", "-=", "*=", "/=", "%=", "<<", ">>", "<=", ">=", "==", "!=",
+            "&&", "||", "^^", "&=", "|=", "^=", "<<=", ">>=",
+    };
+    return operators.find(s) != operators.end();
+}
+
+// Returns the length of the operator or punctuation at the given index of a codeline.
+static size_t getOperatorLength(std::string_view codeline, size_t index) {
+    for (size_t length : { 3, 2 }) {
+        if (index + length <= codeline.size() &&
+                isMultiCharOperator(codeline.substr(index, length))) {
+            return length;
+        }
+    }
+    return 1;
+}
+
+// Returns the index of the first character after the numeric literal at the given index.
+static size_t skipNumber(std::string_view codeline, size_t index) {
+    const bool hex = codeline.compare(index, 2, "0x") == 0 || codeline.compare(index, 2, "0X") == 0;
+    const size_t start = index;
+    while (index < codeline.size()) {
+        const char c = codeline[index];
+        if (isIdChar(c) || c == '.') {
+            ++index;
+        } else if (!hex && index > start && (c == '+' || c == '-') &&
+                (codeline[index - 1] == 'e' || codeline[index - 1] == 'E')) {
+            ++index;
+        } else {
+            break;
+        }
+    }
+    return index;
+}
+
+// Calls the given function for each identifier of a preprocessor directive.
+template<typename F>
+static void forEachIdentifier(std::string_view directive, F&& f) {
+    size_t index = 0;
+    while (index < directive.size()) {
+        std::string_view id;
+        if (isDigit(directive[index])) {
+            index = skipNumber(directive, index);
+        } else if (getId(directive, &index, &id)) {
+            f(id);
+        } else {
+            ++index;
+        }
+    }
+}
+
+// Conditional directives can make the braces of a function unbalanced in the source text.
+static bool isConditionalDirective(std::string_view directive) {
+    size_t index = 1;
+    std::string_view id;
+    getWhitespace(directive, &index);
+    if (!getId(directive, &index, &id)) {
+        return false;
+    }
+    return id == "if" || id == "ifdef" || id == "ifndef" || id == "elif" || id == "else" ||
+            id == "endif";
+}
+
+// Generates the index-th short identifier: a..z, A..Z, then two characters and so on.
+static std::string getShortName(size_t index) {
+    static constexpr std::string_view first =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    static constexpr std::string_view next =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    std::string name(1, first[index % first.size()]);
+    index /= first.size();
+    while (index > 0) {
+        --index;
+        name += next[index % next.size()];
+        index /= next.size();
+    }
+    return name;
+}
+
+/**
+ * Minifies a GLSL shader at the token level. The shader is first split into tokens, dropping all
+ * comments and whitespace, then:
+ * - functions that can't be reached from main() are removed,
+ * - the parameters and local variables of each function are renamed to the shortest identifiers
+ *   that are not used anywhere else in the shader,
+ * - the tokens are joined back, with a space only where two tokens would otherwise merge.
+ *
+ * Preprocessor directives are kept verbatim, and the identifiers they reference are never renamed
+ * nor removed. The transforms that depend on the function structure are skipped if a conditional
+ * directive appears within a function.
+ */
+std::string ShaderMinifier::minifyTokens(const std::string& source) {
+    tokenize(source);
+    if (findFunctions()) {
+        removeDeadFunctions();
+        renameLocals();
+    }
+    return joinTokens();
+}
+
+void ShaderMinifier::tokenize(std::string_view source) {
+    mTokens.clear();
+    bool inComment = false;
+    uint32_t line = 0;
+    size_t first = 0;
+    while (first < source.size()) {
+        size_t last = source.find('\n', first);
+        if (last == std::string_view::npos) {
+            last = source.size();
+        }
+        const std::string_view codeline = source.substr(first, last - first);
+        first = last + 1;
+        ++line;
+
+        size_t index = 0;
+        if (!inComment) {
+            getWhitespace(codeline, &index);
+            if (index < codeline.size() && codeline[index] == '#') {
+                const size_t end = codeline.find_last_not_of(" \t\r");
+                mTokens.push_back({ std::string(codeline.substr(index, end + 1 - index)),
+                        Token::Type::DIRECTIVE, line });
+                continue;
+            }
+        }
+
+        while (index < codeline.size()) {
+            if (inComment) {
+                const size_t end = codeline.find("*/", index);
+                if (end == std::string_view::npos) {
+                    break;
+                }
+                inComment = false;
+                index = end + 2;
+                continue;
+            }
+            const char c = codeline[index];
+            if (c == ' ' || c == '\t' || c == '\r') {
+                ++index;
+                continue;
+            }
+            if (codeline.compare(index, 2, "//") == 0) {
+                break;
+            }
+            if (codeline.compare(index, 2, "/*") == 0) {
+                inComment = true;
+                index += 2;
+                continue;
+            }
+            const size_t start = index;
+            Token::Type type;
+            std::string_view id;
+            if (getId(codeline, &index, &id)) {
+                type = Token::Type::IDENTIFIER;
+            } else if (isDigit(c) ||
+                    (c == '.' && index + 1 < codeline.size() && isDigit(codeline[index + 1]))) {
+                index = skipNumber(codeline, index);
+                type = Token::Type::NUMBER;
+            } else {
+                index += getOperatorLength(codeline, index);
+                type = Token::Type::OPERATOR;
+            }
+            mTokens.push_back({ std::string(codeline.substr(start, index - start)), type, line });
+        }
+    }
+}
+
+size_t ShaderMinifier::findClosing(size_t open) const noexcept {
+    const std::string_view opening = mTokens[open].text;
+    const std::string_view closing = opening == "{" ? "}" : ")";
+    size_t depth = 0;
+    for (size_t i = open; i < mTokens.size(); i++) {
+        if (mTokens[i].type != Token::Type::OPERATOR) {
+            continue;
+        }
+        if (mTokens[i].text == opening) {
+            ++depth;
+        } else if (mTokens[i].text == closing && --depth == 0) {
+            return i;
+        }
+    }
+    return mTokens.size();
+}
+
+// Finds the function definitions and prototypes of the shader. Returns false if the shader can't
+// be safely restructured.
+bool ShaderMinifier::findFunctions() {
+    mFunctions.clear();
+    const size_t count = mTokens.size();
+    size_t declarationStart = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Token& token = mTokens[i];
+        if (token.type == Token::Type::DIRECTIVE || token.text == ";") {
+            declarationStart = i + 1;
+            continue;
+        }
+        if (token.text == "{") {
+            // Struct or interface block, which ends with a semicolon.
+            i = findClosing(i);
+            if (i == count) {
+                return false;
+            }
+            continue;
+        }
+        if (token.type != Token::Type::IDENTIFIER || i + 1 == count || mTokens[i + 1].text != "(" ||
+                i == declarationStart || mTokens[i - 1].type != Token::Type::IDENTIFIER) {
+            continue;
+        }
+        const size_t parametersEnd = findClosing(i + 1);
+        if (parametersEnd + 1 >= count) {
+            return false;
+        }
+        const size_t body = parametersEnd + 1;
+        if (mTokens[body].text == "{") {
+            const size_t end = findClosing(body);
+            if (end == count) {
+                return false;
+            }
+            mFunctions.push_back({ declarationStart, i, body, end });
+            i = end;
+            declarationStart = end + 1;
+        } else if (mTokens[body].text == ";") {
+            mFunctions.push_back({ declarationStart, i, body, body });
+            i = body;
+            declarationStart = body + 1;
+        }
+    }
+
+    for (const Function& function : mFunctions) {
+        for (size_t i = function.begin; i <= function.end; i++) {
+            if (mTokens[i].type == Token::Type::DIRECTIVE &&
+                    isConditionalDirective(mTokens[i].text)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ShaderMinifier::removeDeadFunctions() {
+    // Index of the function owning each token, or -1 for the global scope.
+    std::vector<int32_t> owners(mTokens.size(), -1);
+    bool hasMain = false;
+    for (size_t f = 0; f < mFunctions.size(); f++) {
+        const Function& function = mFunctions[f];
+        std::fill(owners.begin() + function.begin, owners.begin() + function.end + 1, int32_t(f));
+        hasMain = hasMain || mTokens[function.name].text == "main";
+    }
+    if (!hasMain) {
+        return;
+    }
+
+    // Overloads are not told apart: a function is kept if any function of the same name is used.
+    std::unordered_map<std::string_view, std::vector<std::string_view>> callees;
+    std::vector<std::string_view> live = { "main" };
+    for (size_t i = 0; i < mTokens.size(); i++) {
+        const Token& token = mTokens[i];
+        if (token.type == Token::Type::DIRECTIVE) {
+            // Macros can call any function.
+            forEachIdentifier(token.text, [&live](std::string_view id) { live.push_back(id); });
+            continue;
+        }
+        if (token.type != Token::Type::IDENTIFIER || i + 1 == mTokens.size() ||
+                mTokens[i + 1].text != "(") {
+            continue;
+        }
+        const int32_t owner = owners[i];
+        if (owner < 0) {
+            live.push_back(token.text);
+        } else if (mFunctions[owner].name != i) {
+            callees[mTokens[mFunctions[owner].name].text].push_back(token.text);
+        }
+    }
+
+    std::unordered_set<std::string_view> reachable;
+    while (!live.empty()) {
+        const std::string_view name = live.back();
+        live.pop_back();
+        if (!reachable.insert(name).second) {
+            continue;
+        }
+        auto const pos = callees.find(name);
+        if (pos != callees.end()) {
+            live.insert(live.end(), pos->second.begin(), pos->second.end());
+        }
+    }
+
+    for (const Function& function : mFunctions) {
+        if (reachable.find(mTokens[function.name].text) == reachable.end()) {
+            for (size_t i = function.begin; i <= function.end; i++) {
+                mTokens[i].removed = true;
+            }
+        }
+    }
+}
+
+void ShaderMinifier::renameLocals() {
+    // Keywords, reserved words and built-in functions short enough to be generated by
+    // getShortName().
+    static const std::unordered_set<std::string_view> reservedWords = {
+            "do", "if", "in", "for", "int", "out", "asm", "abs", "all", "any", "cos", "dot",
+            "exp", "log", "max", "min", "mix", "mod", "not", "pow", "sin", "tan",
+    };
+
+    // Identifiers of the global scope, the function names and return types, and the identifiers
+    // used by preprocessor directives are never renamed. New names must not clash with any
+    // existing identifier.
+    std::vector<bool> isLocal(mTokens.size(), false);
+    for (const Function& function : mFunctions) {
+        std::fill(isLocal.begin() + function.name + 1, isLocal.begin() + function.end + 1, true);
+    }
+    std::unordered_set<std::string> globals;
+    std::unordered_set<std::string> identifiers;
+    for (size_t i = 0; i < mTokens.size(); i++) {
+        const Token& token = mTokens[i];
+        if (token.removed) {
+            continue;
+        }
+        if (token.type == Token::Type::DIRECTIVE) {
+            forEachIdentifier(token.text, [&](std::string_view id) {
+                globals.emplace(id);
+                identifiers.emplace(id);
+            });
+        } else if (token.type == Token::Type::IDENTIFIER) {
+            identifiers.insert(token.text);
+            if (!isLocal[i]) {
+                globals.insert(token.text);
+            }
+        }
+    }
+
+    std::unordered_set<std::string> called;
+    std::unordered_map<std::string, size_t> useCounts;
+    std::unordered_map<std::string, std::string> names;
+    for (const Function& function : mFunctions) {
+        if (function.body == function.end || mTokens[function.body].removed) {
+            continue;
+        }
+        const size_t begin = function.name + 2;
+        const size_t end = function.end;
+
+        // Local structs and precision statements declare names that are not variables.
+        bool skip = false;
+        for (size_t i = begin; i < end && !skip; i++) {
+            skip = mTokens[i].type == Token::Type::IDENTIFIER &&
+                    (mTokens[i].text == "struct" || mTokens[i].text == "precision");
+        }
+        if (skip) {
+            continue;
+        }
+
+        // Locals are renamed by name, not by scope, so a local named like a function that is
+        // called anywhere in this function, e.g. a built-in such as min(), is kept as is.
+        called.clear();
+        for (size_t i = begin; i < end; i++) {
+            if (mTokens[i].type == Token::Type::IDENTIFIER && mTokens[i + 1].text == "(") {
+                called.insert(mTokens[i].text);
+            }
+        }
+
+        // A declaration is an identifier preceded by a type or qualifier, and followed by an
+        // initializer, an array size or the end of the declaration.
+        useCounts.clear();
+        for (size_t i = begin; i < end; i++) {
+            const Token& token = mTokens[i];
+            const std::string_view previous = mTokens[i - 1].text;
+            const std::string_view next = mTokens[i + 1].text;
+            if (token.type != Token::Type::IDENTIFIER ||
+                    mTokens[i - 1].type != Token::Type::IDENTIFIER ||
+                    previous == "return" || previous == "else" || previous == "case" ||
+                    token.text.compare(0, 3, "gl_") == 0 ||
+                    globals.find(token.text) != globals.end() ||
+                    called.find(token.text) != called.end()) {
+                continue;
+            }
+            if (next == "=" || next == ";" || next == "," || next == "[" || next == ")") {
+                useCounts[token.text] = 0;
+            }
+        }
+        if (useCounts.empty()) {
+            continue;
+        }
+        for (size_t i = begin; i < end; i++) {
+            auto const pos = useCounts.find(mTokens[i].text);
+            if (pos != useCounts.end()) {
+                pos->second++;
+            }
+        }
+
+        // The most used variables get the shortest names.
+        std::vector<std::pair<std::string, size_t>> locals(useCounts.begin(), useCounts.end());
+        std::sort(locals.begin(), locals.end(), [](auto const& lhs, auto const& rhs) {
+            return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+        });
+        names.clear();
+        size_t nameIndex = 0;
+        for (auto const& local : locals) {
+            std::string name;
+            do {
+                name = getShortName(nameIndex++);
+            } while (identifiers.find(name) != identifiers.end() ||
+                    reservedWords.find(name) != reservedWords.end() ||
+                    name.find("__") != std::string::npos);
+            names[local.first] = std::move(name);
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            Token& token = mTokens[i];
+            if (token.type != Token::Type::IDENTIFIER || mTokens[i - 1].text == ".") {
+                continue;
+            }
+            auto const pos = names.find(token.text);
+            if (pos != names.end()) {
+                token.text = pos->second;
+            }
+        }
+    }
+}
+
+std::string ShaderMinifier::joinTokens() const {
+    std::string result;
+    const Token* previous = nullptr;
+    for (const Token& token : mTokens) {
+        if (token.removed) {
+            continue;
+        }
+        if (previous && previous->line != token.line) {
+            result += '\n';
+            previous = nullptr;
+        }
+        if (previous) {
+            // Identifiers and numbers must stay apart, and so must operators that would merge.
+            const bool previousIsOperator = previous->type == Token::Type::OPERATOR;
+            const bool isOperator = token.type == Token::Type::OPERATOR;
+            const char pair[2] = { previous->text.back(), token.text.front() };
+            const std::string_view joint(pair, 2);
+            if ((!previousIsOperator && !isOperator) || (previousIsOperator && isOperator &&
+                    (isMultiCharOperator(joint) || joint == "//" || joint == "/*"))) {
+                result += ' ';
+            }
+        }
+        result += token.text;
+        previous = &token;
+    }
+    if (previous) {
+        result += '\n';
+    }
+    return result;
+}
+
 } // namespace filamat
@@ -18,10 +18,14 @@
 #define TNT_SHADERMINIFIER_H
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <stddef.h>
+#include <stdint.h>
+
 namespace filamat {
 
 // Simple minifier for monolithic GLSL or MSL strings.
@@ -33,17 +37,50 @@ class ShaderMinifier {
         std::string removeWhitespace(const std::string& source, bool mergeBraces = false) const;
         std::string renameStructFields(const std::string& source);
 
+        // Token-level minification of a GLSL shader: removes comments and all the whitespace that
+        // isn't needed to separate tokens, renames the local variables and parameters of each
+        // function to the shortest available names, and removes the functions that are not
+        // reachable from main(). Line breaks are kept so that shader lines can still be shared
+        // between variants in the line dictionary.
+        std::string minifyTokens(const std::string& source);
+
     private:
         using RenameEntry = std::pair<std::string, std::string>;
 
+        struct Token {
+            enum class Type : uint8_t { IDENTIFIER, NUMBER, OPERATOR, DIRECTIVE };
+            std::string text;
+            Type type;
+            uint32_t line;
+            bool removed = false;
+        };
+
+        // Token indices of a function definition or prototype. For a prototype, body and end
+        // are both the index of the terminating semicolon.
+        struct Function {
+            size_t begin;   // first token of the declaration (return type or qualifiers)
+            size_t name;    // function name, followed by the parameter list
+            size_t body;    // opening brace of the body
+            size_t end;     // closing brace of the body
+        };
+
         void buildFieldMapping();
         std::string applyFieldMapping() const;
 
+        void tokenize(std::string_view source);
+        bool findFunctions();
+        void removeDeadFunctions();
+        void renameLocals();
+        std::string joinTokens() const;
+        size_t findClosing(size_t open) const noexcept;
+
         // These fields do not need to be members, but they allow clients to reduce malloc churn
         // by persisting the minifier object.
         std::vector<std::string_view> mCodelines;
         std::vector<RenameEntry> mStructFieldMap;
         std::unordered_map<std::string, std::string> mStructDefnMap;
+        std::vector<Token> mTokens;
+        std::vector<Function> mFunctions;
 };
 
 } // namespace filamat
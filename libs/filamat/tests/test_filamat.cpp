@@ -17,8 +17,10 @@
 #include <gtest/gtest.h>
 
 #include "sca/ASTHelpers.h"
+#include "sca/builtinResource.h"
 #include "sca/GLSLTools.h"
 #include "shaders/ShaderGenerator.h"
+#include "ShaderMinifier.h"
 
 #include "MockIncluder.h"
 
@@ -26,9 +28,12 @@
 #include <filamat/MaterialBuilder.h>
 
 #include <utils/JobSystem.h>
+#include <utils/Path.h>
 
 #include <memory>
 
+#include <string.h>
+
 using namespace utils;
 using namespace ASTHelpers;
 using namespace filamat;
@@ -891,6 +896,84 @@ TEST_F(MaterialCompiler, FeatureLevel0Ess3CallFails) {
   EXPECT_FALSE(result.isValid());
 }
 
+TEST_F(MaterialCompiler, ShaderCache) {
+    std::string shaderCode(R"(
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor = materialParams.color;
+        }
+    )");
+
+    Path const cacheDirectory = Path::getTemporaryDirectory() + "test_filamat_shader_cache";
+    for (Path const& entry : cacheDirectory.listContents()) {
+        Path(entry).unlinkFile();
+    }
+
+    auto build = [&](MaterialBuilder::ShaderCacheStats* stats) {
+        MaterialBuilder builder;
+        builder.parameter("color", UniformType::FLOAT4)
+                .shading(filament::Shading::UNLIT)
+                .material(shaderCode.c_str())
+                .targetApi(MaterialBuilder::TargetApi::ALL)
+                .shaderCacheDirectory(cacheDirectory.c_str());
+        Package package = builder.build(*jobSystem);
+        *stats = builder.getShaderCacheStats();
+        return package;
+    };
+
+    MaterialBuilder::ShaderCacheStats first, second;
+    Package const cold = build(&first);
+    Package const warm = build(&second);
+    ASSERT_TRUE(cold.isValid());
+    ASSERT_TRUE(warm.isValid());
+
+    EXPECT_EQ(first.hits, 0u);
+    EXPECT_GT(first.misses, 0u);
+    EXPECT_EQ(second.hits, first.misses);
+    EXPECT_EQ(second.misses, 0u);
+
+    // Cached shaders must produce exactly the same package.
+    ASSERT_EQ(cold.getSize(), warm.getSize());
+    EXPECT_EQ(memcmp(cold.getData(), warm.getData(), cold.getSize()), 0);
+}
+
+TEST_F(MaterialCompiler, MinifiedShaderCompiles) {
+    std::string fragmentCode(R"(
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor = vec4(0.8, 0.2, 0.1, 1.0);
+            material.roughness = 0.5;
+        }
+    )");
+    std::string const shader = shaderWithAllProperties(*jobSystem, ShaderStage::FRAGMENT,
+            fragmentCode);
+
+    int const version = GLSLTools::getGlslDefaultVersion(ShaderModel::MOBILE);
+    EShMessages const msg = GLSLTools::glslangFlagsFromTargetApi(
+            MaterialBuilder::TargetApi::OPENGL, MaterialBuilder::TargetLanguage::GLSL);
+
+    // Resolve the conditionals first, like Optimization::PREPROCESSOR does, so that functions
+    // are removed and their locals renamed.
+    std::string preprocessed;
+    glslang::TShader::ForbidIncluder forbidIncluder;
+    glslang::TShader preprocessor(EShLangFragment);
+    const char* source = shader.c_str();
+    preprocessor.setStrings(&source, 1);
+    ASSERT_TRUE(preprocessor.preprocess(&DefaultTBuiltInResource, version, ENoProfile, false,
+            false, msg, &preprocessed, forbidIncluder)) << preprocessor.getInfoLog();
+
+    ShaderMinifier minifier;
+    std::string const minified = minifier.minifyTokens(preprocessed);
+    EXPECT_LT(minified.size(), preprocessed.size());
+
+    glslang::TShader parser(EShLangFragment);
+    GLSLangCleaner const cleaner;
+    source = minified.c_str();
+    parser.setStrings(&source, 1);
+    EXPECT_TRUE(parser.parse(&DefaultTBuiltInResource, version, false, msg))
+            << parser.getInfoLog() << minified;
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2024 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ShaderMinifier.h"
+
+TEST(ShaderMinifier, StripWhitespaceAndComments) {
+    std::string source =
+            "#version 300 es\n"
+            "out vec4 fragColor; // output\n"
+            "void main() {\n"
+            "    /* a\n"
+            "       comment */ fragColor = vec4(1.0e-5 - -2.0, 0.0, 0.0, 1.0);\n"
+            "}\n";
+    std::string expected =
+            "#version 300 es\n"
+            "out vec4 fragColor;\n"
+            "void main(){\n"
+            "fragColor=vec4(1.0e-5- -2.0,0.0,0.0,1.0);\n"
+            "}\n";
+    filamat::ShaderMinifier minifier;
+    EXPECT_EQ(minifier.minifyTokens(source), expected);
+}
+
+TEST(ShaderMinifier, RenameLocals) {
+    std::string source =
+            "uniform float scale;\n"
+            "float helper(float value) {\n"
+            "    float result = value * scale;\n"
+            "    return result + result;\n"
+            "}\n"
+            "void main() {\n"
+            "    float value = helper(scale);\n"
+            "    gl_FragDepth = value;\n"
+            "}\n";
+    std::string expected =
+            "uniform float scale;\n"
+            "float helper(float b){\n"
+            "float a=b*scale;\n"
+            "return a+a;\n"
+            "}\n"
+            "void main(){\n"
+            "float a=helper(scale);\n"
+            "gl_FragDepth=a;\n"
+            "}\n";
+    filamat::ShaderMinifier minifier;
+    EXPECT_EQ(minifier.minifyTokens(source), expected);
+}
+
+TEST(ShaderMinifier, KeepLocalsNamedLikeCalledFunctions) {
+    std::string source =
+            "float f(float y) {\n"
+            "    { float min = 1.0; y += min; }\n"
+            "    return min(y, 2.0);\n"
+            "}\n";
+    std::string expected =
+            "float f(float a){\n"
+            "{float min=1.0;a+=min;}\n"
+            "return min(a,2.0);\n"
+            "}\n";
+    filamat::ShaderMinifier minifier;
+    EXPECT_EQ(minifier.minifyTokens(source), expected);
+}
+
+TEST(ShaderMinifier, RemoveDeadFunctions) {
+    std::string source =
+            "#define CALL(x) kept(x)\n"
+            "float unused(float a) { return a; }\n"
+            "float kept(float v) { return v; }\n"
+            "float called(float v) { return v; }\n"
+            "void main() {\n"
+            "    gl_FragDepth = called(CALL(1.0));\n"
+            "}\n";
+    std::string expected =
+            "#define CALL(x) kept(x)\n"
+            "float kept(float a){return a;}\n"
+            "float called(float a){return a;}\n"
+            "void main(){\n"
+            "gl_FragDepth=called(CALL(1.0));\n"
+            "}\n";
+    filamat::ShaderMinifier minifier;
+    EXPECT_EQ(minifier.minifyTokens(source), expected);
+}
+
+TEST(ShaderMinifier, KeepFunctionsWithConditionals) {
+    std::string source =
+            "float unused(float a) {\n"
+            "#ifdef FOO\n"
+            "    return a;\n"
+            "#else\n"
+            "    return 0.0;\n"
+            "#endif\n"
+            "}\n"
+            "void main() {}\n";
+    std::string expected =
+            "float unused(float a){\n"
+            "#ifdef FOO\n"
+            "return a;\n"
+            "#else\n"
+            "return 0.0;\n"
+            "#endif\n"
+            "}\n"
+            "void main(){}\n";
+    filamat::ShaderMinifier minifier;
+    EXPECT_EQ(minifier.minifyTokens(source), expected);
+}
@@ -38,6 +38,9 @@ struct Config {
 
     // Provided to indicate GPU preference for vulkan
     std::string vulkanGPUHint;
+
+    // When set, program binaries are read from and captured into this archive
+    filament::Engine::ProgramBinaryArchive* programBinaryArchive = nullptr;
 };
 
 #endif // TNT_FILAMENT_SAMPLE_CONFIG_H
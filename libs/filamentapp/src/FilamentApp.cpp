@@ -671,6 +671,7 @@ FilamentApp::Window::Window(FilamentApp* filamentApp,
                         .platform(mFilamentApp->mVulkanPlatform)
                         .featureLevel(config.featureLevel)
                         .config(&engineConfig)
+                        .programBinaryArchive(config.programBinaryArchive)
                         .build();
             #endif
         }
@@ -678,6 +679,7 @@ FilamentApp::Window::Window(FilamentApp* filamentApp,
                 .backend(backend)
                 .featureLevel(config.featureLevel)
                 .config(&engineConfig)
+                .programBinaryArchive(config.programBinaryArchive)
                 .build();
     };
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_GEOMETRY_MESHSIMPLIFIER_H
+#define TNT_GEOMETRY_MESHSIMPLIFIER_H
+
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+#include <utils/FixedCapacityVector.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+namespace geometry {
+
+/**
+ * Creates a function object that generates a chain of simplified levels of detail for an indexed
+ * triangle mesh.
+ *
+ * Every level re-uses the vertices of the original mesh, so only index data is produced. This
+ * allows all levels to share a single VertexBuffer and be selected with
+ * RenderableManager::setGeometryAt().
+ *
+ * Usage Example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * using filament::geometry::MeshSimplifier;
+ *
+ * MeshSimplifier simplify({
+ *     .levelCount = 3,
+ *     .reduction = 0.5f,
+ *     .maxError = 0.05f
+ * });
+ *
+ * MeshSimplifier::Result lods = simplify(indices, indexCount, positions, vertexCount);
+ * for (auto const& level : lods.levels) {
+ *     // level.indexOffset and level.indexCount are ranges into lods.indices
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class UTILS_PUBLIC MeshSimplifier {
+public:
+    /**
+     * Describes how aggressively the mesh should be simplified.
+     */
+    struct Config {
+        uint32_t levelCount = 3; //!< Maximum number of levels, not counting the original mesh.
+        float reduction = 0.5f;  //!< Target index count ratio between two consecutive levels.
+        float maxError = 0.05f;  //!< Largest permitted error, relative to the mesh extents.
+    };
+
+    /**
+     * Describes a single simplified level of detail.
+     */
+    struct Level {
+        uint32_t indexOffset; //!< Offset of the first index of this level in Result::indices.
+        uint32_t indexCount;  //!< Number of indices in this level, always a multiple of 3.
+        float error;          //!< Deviation from the original mesh, relative to the mesh extents.
+    };
+
+    /**
+     * Simplified levels, from finest to coarsest. The indices of all levels are concatenated.
+     */
+    struct Result {
+        utils::FixedCapacityVector<uint32_t> indices;
+        utils::FixedCapacityVector<Level> levels;
+    };
+
+    /**
+     * Creates an immutable function object with the specified configuration.
+     *
+     * The config is not passed by const reference to allow for type inference at the call site.
+     */
+    MeshSimplifier(Config config) noexcept : mConfig(config) {}
+
+    /**
+     * Generates up to Config::levelCount simplified levels for the given triangle list.
+     *
+     * Generation stops early when the next level would exceed Config::maxError or when the mesh
+     * cannot be simplified any further, therefore the result may contain fewer levels than
+     * requested, or none at all. Each level is optimized for the post-transform vertex cache.
+     *
+     * @param indices Triangle list indices (does not get retained)
+     * @param indexCount Number of indices, must be a multiple of 3
+     * @param positions Vertex positions (does not get retained)
+     * @param vertexCount Number of vertices
+     * @param positionStride Byte stride between positions, or 0 for tight packing
+     */
+    Result operator()(uint32_t const* UTILS_NONNULL indices, size_t indexCount,
+            math::float3 const* UTILS_NONNULL positions, size_t vertexCount,
+            size_t positionStride = 0) const;
+
+private:
+    const Config mConfig;
+};
+
+} // namespace geometry
+} // namespace filament
+
+#endif // TNT_GEOMETRY_MESHSIMPLIFIER_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <geometry/MeshSimplifier.h>
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace filament::math;
+
+namespace filament {
+namespace geometry {
+
+MeshSimplifier::Result MeshSimplifier::operator()(uint32_t const* indices, size_t indexCount,
+        float3 const* positions, size_t vertexCount, size_t positionStride) const {
+    positionStride = positionStride ? positionStride : sizeof(float3);
+
+    std::vector<uint32_t> allIndices;
+    std::vector<Level> levels;
+    if (indexCount < 3 || vertexCount == 0) {
+        return {};
+    }
+
+    // Each level is simplified from the original mesh rather than from the previous level, such
+    // that the reported error is always relative to the original surface.
+    std::vector<uint32_t> scratch(indexCount);
+    size_t previousCount = indexCount;
+    float targetRatio = 1.0f;
+    for (uint32_t level = 0; level < mConfig.levelCount; ++level) {
+        targetRatio *= mConfig.reduction;
+        const size_t targetCount = size_t(float(indexCount) * targetRatio) / 3 * 3;
+        if (targetCount < 3) {
+            break;
+        }
+        float error = 0.0f;
+        const size_t count = meshopt_simplify(scratch.data(), indices, indexCount,
+                &positions->x, vertexCount, positionStride, targetCount, mConfig.maxError, 0,
+                &error);
+
+        // Stop when the error bound prevents any further reduction.
+        if (count == 0 || count >= previousCount) {
+            break;
+        }
+
+        meshopt_optimizeVertexCache(scratch.data(), scratch.data(), count, vertexCount);
+        levels.push_back({ uint32_t(allIndices.size()), uint32_t(count), error });
+        allIndices.insert(allIndices.end(), scratch.begin(), scratch.begin() + count);
+        previousCount = count;
+    }
+
+    Result result{
+        .indices = utils::FixedCapacityVector<uint32_t>(allIndices.size()),
+        .levels = utils::FixedCapacityVector<Level>(levels.size()),
+    };
+    std::copy(allIndices.begin(), allIndices.end(), result.indices.begin());
+    std::copy(levels.begin(), levels.end(), result.levels.begin());
+    return result;
+}
+
+} // namespace geometry
+} // namespace filament
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <geometry/MeshSimplifier.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using filament::math::float3;
+using filament::geometry::MeshSimplifier;
+
+class MeshSimplifierTest : public testing::Test {};
+
+// Creates a tessellated sphere made of (rings * segments) quads.
+static void createSphere(size_t rings, size_t segments, std::vector<float3>& positions,
+        std::vector<uint32_t>& indices) {
+    for (size_t r = 0; r <= rings; ++r) {
+        const float theta = float(M_PI) * float(r) / float(rings);
+        for (size_t s = 0; s <= segments; ++s) {
+            const float phi = 2.0f * float(M_PI) * float(s) / float(segments);
+            positions.push_back({
+                    std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+        }
+    }
+    for (size_t r = 0; r < rings; ++r) {
+        for (size_t s = 0; s < segments; ++s) {
+            const uint32_t a = r * (segments + 1) + s;
+            const uint32_t b = a + segments + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+}
+
+TEST_F(MeshSimplifierTest, LevelsShrink) {
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+    createSphere(64, 64, positions, indices);
+
+    MeshSimplifier simplify({
+        .levelCount = 4,
+        .reduction = 0.5f,
+        .maxError = 0.1f
+    });
+
+    MeshSimplifier::Result result = simplify(indices.data(), indices.size(), positions.data(),
+            positions.size());
+
+    ASSERT_GT(result.levels.size(), 0u);
+    EXPECT_LE(result.levels.size(), 4u);
+
+    size_t previousCount = indices.size();
+    size_t expectedOffset = 0;
+    for (auto const& level : result.levels) {
+        EXPECT_EQ(level.indexOffset, expectedOffset);
+        EXPECT_EQ(level.indexCount % 3, 0u);
+        EXPECT_LT(level.indexCount, previousCount);
+        EXPECT_LE(level.error, 0.1f);
+        previousCount = level.indexCount;
+        expectedOffset += level.indexCount;
+    }
+    EXPECT_EQ(result.indices.size(), expectedOffset);
+
+    for (uint32_t index : result.indices) {
+        EXPECT_LT(index, positions.size());
+    }
+}
+
+TEST_F(MeshSimplifierTest, ErrorBound) {
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+    createSphere(32, 32, positions, indices);
+
+    auto coarsestCount = [&](float maxError) {
+        MeshSimplifier simplify({
+            .levelCount = 8,
+            .reduction = 0.5f,
+            .maxError = maxError
+        });
+        MeshSimplifier::Result result = simplify(indices.data(), indices.size(),
+                positions.data(), positions.size());
+        for (auto const& level : result.levels) {
+            EXPECT_LE(level.error, maxError);
+        }
+        return result.levels.empty() ? indices.size() : result.levels.back().indexCount;
+    };
+
+    // A tighter error bound cannot remove more triangles than a looser one.
+    EXPECT_GT(coarsestCount(0.001f), coarsestCount(0.1f));
+}
@@ -22,6 +22,8 @@
 
 #include <gltfio/NodeManager.h>
 
+#include <math/vec3.h>
+
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 
@@ -216,6 +218,37 @@ public:
      */
     size_t getMorphTargetCountAt(Entity entity) const noexcept;
 
+    /**
+     * A small cluster of triangles that occupies a contiguous range of its primitive's index
+     * buffer, generated when ResourceConfiguration::optimizeMeshes is enabled. The bounding sphere
+     * and normal cone allow the cluster to be culled as a whole: it is entirely backfacing if
+     * dot(normalize(coneApex - eye), coneAxis) >= coneCutoff. All values are in object space.
+     */
+    struct Meshlet {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        math::float3 center;
+        float radius;
+        math::float3 coneApex;
+        math::float3 coneAxis;
+        float coneCutoff;
+    };
+
+    /**
+     * Gets the meshlets of the given primitive of the given renderable entity.
+     *
+     * Meshlets are only generated if ResourceConfiguration::optimizeMeshes was enabled when
+     * resources were loaded, and only for the primitives that could be optimized. They remain
+     * available after releaseSourceData().
+     *
+     * @param entity Renderable entity of this asset.
+     * @param primitiveIndex Index of the primitive within the renderable.
+     * @param count Receives the number of meshlets, zero if there are none.
+     * @return Pointer to the meshlets, owned by the asset, or null if there are none.
+     */
+    const Meshlet* getMeshlets(Entity entity, size_t primitiveIndex,
+            size_t* count) const noexcept;
+
     /**
      * Lazily creates a single LINES renderable that draws the transformed bounding-box hierarchy
      * for diagnostic purposes. The wireframe is owned by the asset so clients should not delete it.
@@ -23,6 +23,7 @@
 #include <filament/Box.h>
 
 namespace filament {
+class Camera;
 class MaterialInstance;
 }
 
@@ -151,6 +152,16 @@ public:
      */
     Aabb getBoundingBox() const noexcept;
 
+    /**
+     * Picks a level of detail for every primitive of every renderable in this instance, according
+     * to the size of its bounding sphere on screen when seen through the given camera.
+     *
+     * Levels of detail are only available if ResourceConfiguration::lodCount was non-zero when
+     * resources were loaded; otherwise this is a no-op. This is typically called once per frame
+     * before rendering, and only primitives whose level changes are updated.
+     */
+    void applyLevelOfDetail(Camera const& camera) noexcept;
+
     /** Gets all material instances. These are already bound to renderables. */
     const MaterialInstance* const* getMaterialInstances() const noexcept;
 
@@ -160,6 +160,21 @@ public:
     virtual Material* getMaterial(MaterialKey* config, UvMap* uvmap,
             const char* label = "material") { return nullptr; }
 
+    /**
+     * Hints that materials corresponding to the given configs are about to be requested.
+     *
+     * Providers that generate materials at run time can use this to start building them in the
+     * background; getMaterial() and createMaterialInstance() then wait for the corresponding build
+     * to complete. AssetLoader calls this with the configs of all the primitives of an asset
+     * before creating its entities. The default implementation does nothing.
+     *
+     * @param configs Array of configs, which are constrained like in getMaterial().
+     * @param labels Array of optional labels, with the same semantics as in getMaterial().
+     * @param count Number of configs and labels.
+     */
+    virtual void prepareMaterials(const MaterialKey* configs, const char* const* labels,
+            size_t count) {}
+
     /**
      * Gets a weak reference to the array of cached materials.
      */
@@ -195,7 +210,15 @@ void processShaderString(std::string* shader, const UvMap& uvmap,
 /**
  * Creates a material provider that builds materials on the fly, composing GLSL at run time.
  *
+ * Materials announced with MaterialProvider::prepareMaterials() are built concurrently on the
+ * engine's JobSystem.
+ *
  * @param optimizeShaders Optimizes shaders, but at significant cost to construction time.
+ * @param cacheDirectory Optional directory where the generated materials are persisted across
+ *                       runs, so that subsequent runs don't need to build them again. Entries are
+ *                       keyed by a hash of the material requirements, so the directory can be
+ *                       shared by many assets. The directory is created if needed. The string
+ *                       pointer is not retained. Ignored on platforms without a file system.
  * @return New material provider that can build materials at run time.
  *
  * Requires \c libfilamat to be linked in. Not available in \c libgltfio_core.
@@ -203,7 +226,8 @@ void processShaderString(std::string* shader, const UvMap& uvmap,
  * @see createUbershaderProvider
  */
 UTILS_PUBLIC
-MaterialProvider* createJitShaderProvider(Engine* engine, bool optimizeShaders = false);
+MaterialProvider* createJitShaderProvider(Engine* engine, bool optimizeShaders = false,
+        const char* cacheDirectory = nullptr);
 
 /**
  * Creates a material provider that loads a small set of pre-built materials.
@@ -49,6 +49,23 @@ struct ResourceConfiguration {
     //! If true, adjusts skinning weights to sum to 1. Well formed glTF files do not need this,
     //! but it is useful for robustness.
     bool normalizeSkinningWeights;
+
+    //! If true, reorders the index and vertex data of each indexed triangle primitive to improve
+    //! post-transform vertex cache usage, overdraw, and vertex fetch locality, and splits it into
+    //! meshlets with bounding spheres and normal cones. This is skipped for primitives that share
+    //! accessors with other primitives. Increases load time; off by default.
+    bool optimizeMeshes = false;
+
+    //! Number of simplified levels of detail to generate for each indexed triangle primitive, not
+    //! counting the original geometry. Levels are picked with
+    //! FilamentInstance::applyLevelOfDetail(). Zero (the default) disables generation.
+    uint8_t lodCount = 0;
+
+    //! Optional directory where expensive derived data, such as generated tangent frames and
+    //! decoded Draco meshes, is persisted across runs. Entries are keyed by a hash of their
+    //! inputs, so the directory can be shared by many assets. The directory is created if needed.
+    //! The string pointer is not retained. Ignored on platforms without a file system.
+    const char* cacheDirectory = nullptr;
 };
 
 /**
@@ -61,6 +61,7 @@
 #include <codecvt>
 #include <locale>
 #include <memory>
+#include <vector>
 
 using namespace filament;
 using namespace filament::math;
@@ -323,6 +324,7 @@ private:
             FFilamentInstance* instance);
 
     // Utility methods that work with MaterialProvider.
+    void prepareMaterials(const cgltf_data* srcAsset);
     Material* getMaterial(const cgltf_data* srcAsset, const cgltf_material* inputMat, UvMap* uvmap,
             bool vertexColor);
     MaterialInstance* createMaterialInstance(const cgltf_material* inputMat, UvMap* uvmap,
@@ -396,6 +398,9 @@ FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_
         return nullptr;
     }
 
+    // Let the material provider start building the materials while we create the primitives.
+    prepareMaterials(sourceAsset);
+
     FFilamentAsset* fAsset = createRootAsset(sourceAsset);
     if (mError) {
         delete fAsset;
@@ -734,6 +739,7 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
     // that were already generated (one for each primitive).
     FixedCapacityVector<Primitive>& prims = fAsset->mMeshCache[mesh - srcAsset->meshes];
     assert_invariant(prims.size() == primitiveCount);
+    fAsset->mRenderableMeshes[entity] = uint32_t(mesh - srcAsset->meshes);
     Primitive* outputPrim = prims.data();
     const cgltf_primitive* inputPrim = &mesh->primitives[0];
 
@@ -1428,6 +1434,33 @@ MaterialKey FAssetLoader::getMaterialKey(const cgltf_data* srcAsset,
     return matkey;
 }
 
+void FAssetLoader::prepareMaterials(const cgltf_data* srcAsset) {
+    std::vector<MaterialKey> configs;
+    std::vector<const char*> labels;
+    auto addMaterial = [&](const cgltf_primitive& prim, const cgltf_material* inputMat) {
+        if (!inputMat) {
+            inputMat = &kDefaultMat;
+        }
+        UvMap uvmap {};
+        cgltf_texture_view baseColorTexture;
+        cgltf_texture_view metallicRoughnessTexture;
+        configs.push_back(getMaterialKey(srcAsset, inputMat, &uvmap,
+                primitiveHasVertexColor(prim), &baseColorTexture, &metallicRoughnessTexture));
+        labels.push_back(inputMat->name);
+    };
+    for (cgltf_size i = 0, n = srcAsset->meshes_count; i < n; ++i) {
+        const cgltf_mesh& mesh = srcAsset->meshes[i];
+        for (cgltf_size j = 0, m = mesh.primitives_count; j < m; ++j) {
+            const cgltf_primitive& prim = mesh.primitives[j];
+            addMaterial(prim, prim.material);
+            for (cgltf_size k = 0, l = prim.mappings_count; k < l; ++k) {
+                addMaterial(prim, prim.mappings[k].material);
+            }
+        }
+    }
+    mMaterials.prepareMaterials(configs.data(), labels.data(), configs.size());
+}
+
 Material* FAssetLoader::getMaterial(const cgltf_data* srcAsset,
         const cgltf_material* inputMat, UvMap* uvmap, bool vertexColor) {
     cgltf_texture_view baseColorTexture;
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_DISK_CACHE_H
+#define GLTFIO_DISK_CACHE_H
+
+#include <utils/ContentHasher.h>
+#include <utils/Path.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace filament::gltfio {
+
+// Persists blobs of derived data (e.g. generated tangents) across runs, using one file per blob.
+//
+// The cache is content-addressed: the key is a 128-bit hash of everything the blob was computed
+// from (see utils::ContentHasher), so entries never need to be invalidated. Each entry is prefixed
+// with a small header that records the full key and the payload size, which guards against
+// truncated files and entries written by other versions. Entries are written to a temporary file
+// and then renamed, so concurrent jobs may safely read and write the cache, even across processes.
+//
+// A default-constructed cache (or one constructed with an empty directory) is disabled, and all
+// lookups miss.
+class DiskCache {
+public:
+    using Hasher = utils::ContentHasher;
+    using Key = utils::ContentHasher::Digest;
+
+    DiskCache() = default;
+    explicit DiskCache(const char* directory);
+
+    bool isEnabled() const noexcept { return !mDirectory.isEmpty(); }
+
+    // Returns true and populates the given blob if an entry exists for the given key.
+    bool get(Key const& key, std::vector<uint8_t>* blob) const;
+
+    // Stores a blob under the given key, replacing any existing entry. Failures are not fatal
+    // since the cache is only an optimization.
+    void put(Key const& key, const void* data, size_t size) const;
+
+private:
+    utils::Path getEntryPath(Key const& key) const;
+    utils::Path mDirectory;
+};
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_DISK_CACHE_H
@@ -15,6 +15,7 @@
  */
 
 #include "DracoCache.h"
+#include "DiskCache.h"
 
 #if GLTFIO_DRACO_SUPPORTED
 #include <draco/compression/decode.h>
@@ -28,6 +29,8 @@
 #include <memory>
 #include <vector>
 
+#include <string.h>
+
 using std::unique_ptr;
 using std::vector;
 
@@ -49,14 +52,40 @@ DracoMesh* DracoCache::findOrCreateMesh(const cgltf_buffer_view* key) {
     return mesh;
 }
 
+DracoMesh* DracoCache::findOrCreateLazyMesh(const cgltf_buffer_view* key,
+        const DiskCache* diskCache) {
+    auto iter = mCache.find(key);
+    if (iter != mCache.end()) {
+        return iter->second.get();
+    }
+    assert(key->buffer && key->buffer->data);
+    const uint8_t* compressedData = key->offset + (uint8_t*) key->buffer->data;
+    DracoMesh* mesh = DracoMesh::createLazy(compressedData, key->size, diskCache);
+    mCache.emplace(key, mesh);
+    return mesh;
+}
+
 DracoMesh::DracoMesh(struct DracoMeshDetails* details) : mDetails(details) {}
 
 #if GLTFIO_DRACO_SUPPORTED
 
+// Bump this whenever the conversion of decoded data changes, which invalidates cached accessors.
+static constexpr uint64_t kDracoCacheVersion = 1;
+
+// Identifies the index data in cache keys, since it does not have a Draco attribute id.
+static constexpr uint32_t kFaceIndicesId = ~0u;
+
 struct DracoMeshDetails {
     unique_ptr<draco::Mesh> mesh;
     vector<unique_ptr<cgltf_buffer_view>> views;
     vector<unique_ptr<cgltf_buffer>> buffers;
+
+    // The following fields are used only by lazy meshes.
+    const uint8_t* compressedData = nullptr;
+    size_t compressedSize = 0;
+    const DiskCache* diskCache = nullptr;
+    DiskCache::Key compressedHash;
+    bool decodeFailed = false;
 };
 
 DracoMesh::~DracoMesh() {
@@ -122,12 +151,90 @@ DracoMesh* DracoMesh::decode(const uint8_t* data, size_t dataSize) {
     return new DracoMesh(new DracoMeshDetails { std::move(meshStatus).value() });
 }
 
+DracoMesh* DracoMesh::createLazy(const uint8_t* data, size_t dataSize,
+        const DiskCache* diskCache) {
+    DracoMeshDetails* details = new DracoMeshDetails;
+    details->compressedData = data;
+    details->compressedSize = dataSize;
+    if (diskCache && diskCache->isEnabled()) {
+        details->diskCache = diskCache;
+        details->compressedHash = DiskCache::Hasher(kDracoCacheVersion).add(data, dataSize).get();
+    }
+    return new DracoMesh(details);
+}
+
+bool DracoMesh::decodeIfNeeded() const {
+    if (mDetails->mesh) {
+        return true;
+    }
+    if (mDetails->decodeFailed || !mDetails->compressedData) {
+        return false;
+    }
+    unique_ptr<DracoMesh> decoded(decode(mDetails->compressedData, mDetails->compressedSize));
+    if (!decoded) {
+        slog.e << "Cannot decompress mesh, Draco decoding error." << io::endl;
+        mDetails->decodeFailed = true;
+        return false;
+    }
+    mDetails->mesh = std::move(decoded->mDetails->mesh);
+    return true;
+}
+
+DiskCache::Key DracoMesh::getCacheKey(uint32_t attributeId,
+        const cgltf_accessor* target) const {
+    if (!mDetails->diskCache) {
+        return {};
+    }
+    return DiskCache::Hasher().add(mDetails->compressedHash).add(attributeId)
+            .add(target->component_type).add(target->type).add(target->count)
+            .add(target->stride).get();
+}
+
+bool DracoMesh::loadFromCache(DiskCache::Key const& key, cgltf_accessor* target,
+        cgltf_buffer_view_type type) const {
+    vector<uint8_t> blob;
+    if (key == DiskCache::Key{} || !mDetails->diskCache->get(key, &blob) ||
+            blob.size() != target->count * target->stride) {
+        return false;
+    }
+
+    cgltf_buffer_view* view = new cgltf_buffer_view;
+    cgltf_buffer* buffer = view->buffer = new cgltf_buffer;
+
+    mDetails->views.emplace_back(view);
+    mDetails->buffers.emplace_back(buffer);
+
+    const cgltf_size size = blob.size();
+    *buffer = { nullptr, size, nullptr, malloc(size) };
+    *view = { nullptr, buffer, 0, size, 0, type };
+    memcpy(buffer->data, blob.data(), size);
+
+    target->offset = 0;
+    target->buffer_view = view;
+    return true;
+}
+
+void DracoMesh::storeInCache(DiskCache::Key const& key, const cgltf_accessor* target) const {
+    if (key != DiskCache::Key{}) {
+        const cgltf_buffer_view* view = target->buffer_view;
+        mDetails->diskCache->put(key, view->buffer->data, view->size);
+    }
+}
+
 bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
     // Return early if we've already decompressed this data.
     if (target->buffer_view) {
         return true;
     }
 
+    const DiskCache::Key key = getCacheKey(kFaceIndicesId, target);
+    if (loadFromCache(key, target, cgltf_buffer_view_type_indices)) {
+        return true;
+    }
+
+    if (!decodeIfNeeded()) {
+        return false;
+    }
     draco::Mesh* mesh = mDetails->mesh.get();
 
     // Check the accessor's index count against the number of faces in the Draco mesh.
@@ -156,6 +263,7 @@ bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
             slog.e << "Unexpected component type for Draco indices." << io::endl;
             return false;
     }
+    storeInCache(key, target);
     return true;
 }
 
@@ -165,6 +273,15 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
         return true;
     }
 
+    const DiskCache::Key key = getCacheKey(attributeId, target);
+    if (loadFromCache(key, target, cgltf_buffer_view_type_vertices)) {
+        return true;
+    }
+
+    if (!decodeIfNeeded()) {
+        return false;
+    }
+
     // Return early if no such attribute exists.
     draco::Mesh* mesh = mDetails->mesh.get();
     const draco::PointAttribute* attr = mesh->GetAttributeByUniqueId(attributeId);
@@ -205,9 +322,10 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
 	    case cgltf_component_type_r_32f: convertAttribs<float>(target, attr, count); break;
         default:
             slog.e << "Unexpected component type for Draco vertices." << io::endl;
-            break;
+            return true;
     }
 
+    storeInCache(key, target);
     return true;
 }
 
@@ -217,6 +335,11 @@ DracoMesh::~DracoMesh() {}
 struct DracoMeshDetails {};
 DracoMesh* DracoMesh::decode(const uint8_t* data, size_t dataSize) { return nullptr; }
 
+DracoMesh* DracoMesh::createLazy(const uint8_t* data, size_t dataSize,
+        const DiskCache* diskCache) {
+    return nullptr;
+}
+
 bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
     return false;
 }
@@ -17,6 +17,8 @@
 #ifndef GLTFIO_DRACO_CACHE_H
 #define GLTFIO_DRACO_CACHE_H
 
+#include "DiskCache.h"
+
 #include <cgltf.h>
 
 #include <tsl/robin_map.h>
@@ -35,9 +37,17 @@ class DracoMesh;
 //
 // The cache key is the buffer view that holds the compressed data. This allows the loader to
 // avoid duplicated work when a single Draco mesh is referenced from multiple primitives.
+//
+// The cache itself is not thread safe, but distinct meshes can be used from different threads
+// once they have been created.
 class DracoCache {
 public:
     DracoMesh* findOrCreateMesh(const cgltf_buffer_view* key);
+
+    // Similar to findOrCreateMesh, but the returned mesh is decoded on first use rather than
+    // immediately, and is backed by the given disk cache, which may be null. This lets the caller
+    // decode several meshes in parallel, and skip decoding entirely on a cache hit.
+    DracoMesh* findOrCreateLazyMesh(const cgltf_buffer_view* key, const DiskCache* diskCache);
 private:
     tsl::robin_map<const cgltf_buffer_view*, std::unique_ptr<DracoMesh>> mCache;
 };
@@ -55,14 +65,25 @@ private:
 // our Draco decoder relies on the accessor fields being 100% correct. If we had to be robust
 // against faulty accessor information, we would need to replace the VertexBuffer object that was
 // created in the AssetLoader, which would be a messy process.
+//
+// A lazy mesh keeps a pointer to the compressed data and only decodes it when an accessor cannot be
+// populated from the disk cache. Decoded accessors are keyed by a hash of the compressed data and of
+// the accessor's format, so a given blob of compressed data can be shared across assets.
 class DracoMesh {
 public:
     static DracoMesh* decode(const uint8_t* compressedData, size_t compressedSize);
+    static DracoMesh* createLazy(const uint8_t* compressedData, size_t compressedSize,
+            const DiskCache* diskCache);
     bool getFaceIndices(cgltf_accessor* destination) const;
     bool getVertexAttributes(uint32_t attributeId, cgltf_accessor* destination) const;
     ~DracoMesh();
 private:
     DracoMesh(struct DracoMeshDetails* details);
+    bool decodeIfNeeded() const;
+    DiskCache::Key getCacheKey(uint32_t attributeId, const cgltf_accessor* target) const;
+    bool loadFromCache(DiskCache::Key const& key, cgltf_accessor* target,
+            cgltf_buffer_view_type type) const;
+    void storeInCache(DiskCache::Key const& key, const cgltf_accessor* target) const;
     std::unique_ptr<struct DracoMeshDetails> mDetails;
 };
 
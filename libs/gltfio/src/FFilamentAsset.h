@@ -45,6 +45,7 @@
 #include "DependencyGraph.h"
 #include "DracoCache.h"
 #include "FFilamentInstance.h"
+#include "OptimizeMeshJob.h"
 #include "Utility.h"
 
 #include <string>
@@ -102,6 +103,27 @@ struct Primitive {
 };
 using MeshCache = utils::FixedCapacityVector<utils::FixedCapacityVector<Primitive>>;
 
+// Simplified levels of detail for a single primitive, generated by ResourceLoader on request.
+// All levels share the VertexBuffer of the original primitive and are packed into one IndexBuffer.
+// Unlike the MeshCache, this outlives releaseSourceData() because it is needed every frame.
+struct PrimitiveLods {
+    struct Level {
+        uint32_t offset;
+        uint32_t count;
+        float screenSize; // max projected diameter of the bounds, as a fraction of viewport height
+    };
+    VertexBuffer* vertices = nullptr;
+    IndexBuffer* indices = nullptr; // original geometry
+    IndexBuffer* lodIndices = nullptr;
+    utils::FixedCapacityVector<Level> levels; // from finest to coarsest
+};
+using MeshLods = utils::FixedCapacityVector<utils::FixedCapacityVector<PrimitiveLods>>;
+
+// Meshlets of each primitive of each cgltf_mesh, only populated if optimizeMeshes is enabled.
+// Like the levels of detail, these outlive releaseSourceData().
+using MeshMeshlets = utils::FixedCapacityVector<
+        utils::FixedCapacityVector<utils::FixedCapacityVector<Meshlet>>>;
+
 struct FFilamentAsset : public FilamentAsset {
     struct ResourceInfo;
     struct ResourceInfoExtended;
@@ -194,6 +216,9 @@ struct FFilamentAsset : public FilamentAsset {
 
     size_t getMorphTargetCountAt(utils::Entity entity) const noexcept;
 
+    const Meshlet* getMeshlets(utils::Entity entity, size_t primitiveIndex,
+            size_t* count) const noexcept;
+
     utils::Entity getWireframe() noexcept;
 
     Engine* getEngine() const noexcept {
@@ -321,6 +346,13 @@ struct FFilamentAsset : public FilamentAsset {
     // The mapping from cgltf_mesh to VertexBuffer* (etc) is required when creating new instances.
     MeshCache mMeshCache;
 
+    // Generated levels of detail for each cgltf_mesh, and the mesh index of each renderable.
+    MeshLods mMeshLods;
+    tsl::robin_map<utils::Entity, uint32_t, utils::Entity::Hasher> mRenderableMeshes;
+
+    // Generated meshlets for each cgltf_mesh.
+    MeshMeshlets mMeshlets;
+
     // Asset information that is produced by AssetLoader and consumed by ResourceLoader:
     struct ResourceInfo {
         // Encapsulates VertexBuffer::setBufferAt() or IndexBuffer::setBuffer().
@@ -25,6 +25,7 @@
 
 #include <math/mat4.h>
 
+#include <tsl/robin_map.h>
 #include <tsl/robin_set.h>
 
 #include <vector>
@@ -120,6 +121,12 @@ struct FFilamentInstance : public FilamentInstance {
     math::mat4f const* getInverseBindMatricesAt(size_t skinIndex) const;
 
     void recomputeBoundingBoxes();
+
+    void applyLevelOfDetail(Camera const& camera) noexcept;
+
+    // The level of detail that is currently applied to each primitive of each renderable.
+    tsl::robin_map<utils::Entity, utils::FixedCapacityVector<uint8_t>, utils::Entity::Hasher>
+            mLodLevels;
 };
 
 FILAMENT_DOWNCAST(FilamentInstance)
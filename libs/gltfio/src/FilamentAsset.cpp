@@ -179,6 +179,21 @@ size_t FFilamentAsset::getMorphTargetCountAt(utils::Entity entity) const noexcep
     return names.size();
 }
 
+const Meshlet* FFilamentAsset::getMeshlets(utils::Entity entity, size_t primitiveIndex,
+        size_t* count) const noexcept {
+    *count = 0;
+    auto const iter = mRenderableMeshes.find(entity);
+    if (iter == mRenderableMeshes.end() || iter->second >= mMeshlets.size()) {
+        return nullptr;
+    }
+    auto const& prims = mMeshlets[iter->second];
+    if (primitiveIndex >= prims.size() || prims[primitiveIndex].empty()) {
+        return nullptr;
+    }
+    *count = prims[primitiveIndex].size();
+    return prims[primitiveIndex].data();
+}
+
 Entity FFilamentAsset::getWireframe() noexcept {
     if (!mWireframe) {
         mWireframe = new Wireframe(this);
@@ -369,6 +384,11 @@ size_t FilamentAsset::getMorphTargetCountAt(utils::Entity entity) const noexcept
     return downcast(this)->getMorphTargetCountAt(entity);
 }
 
+const FilamentAsset::Meshlet* FilamentAsset::getMeshlets(Entity entity, size_t primitiveIndex,
+        size_t* count) const noexcept {
+    return downcast(this)->getMeshlets(entity, primitiveIndex, count);
+}
+
 Entity FilamentAsset::getWireframe() noexcept {
     return downcast(this)->getWireframe();
 }
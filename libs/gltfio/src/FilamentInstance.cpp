@@ -19,9 +19,16 @@
 
 #include <gltfio/Animator.h>
 
+#include <filament/Camera.h>
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
+
 #include <utils/JobSystem.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace filament;
 using namespace filament::math;
 using namespace utils;
@@ -326,6 +333,74 @@ void FFilamentInstance::recomputeBoundingBoxes() {
     mBoundingBox = assetBounds;
 }
 
+void FFilamentInstance::applyLevelOfDetail(Camera const& camera) noexcept {
+    if (mOwner->mMeshLods.empty()) {
+        return;
+    }
+
+    auto& rm = mOwner->mEngine->getRenderableManager();
+    auto& tm = mOwner->mEngine->getTransformManager();
+
+    // The projected radius of a sphere in clip space is its radius multiplied by the vertical
+    // scale of the projection, divided by its distance for perspective projections. Clip space
+    // spans two units vertically, so this is also the projected diameter as a fraction of the
+    // viewport height, which is what PrimitiveLods::Level::screenSize is expressed in.
+    const mat4 projection = camera.getProjectionMatrix();
+    const bool isPerspective = projection[2][3] != 0.0;
+    const float projectionScale = float(projection[1][1]);
+    const float3 eye = float3(camera.getPosition());
+
+    for (Entity entity : mEntities) {
+        auto meshIter = mOwner->mRenderableMeshes.find(entity);
+        if (meshIter == mOwner->mRenderableMeshes.end()) {
+            continue;
+        }
+        FixedCapacityVector<PrimitiveLods> const& lods = mOwner->mMeshLods[meshIter->second];
+        RenderableManager::Instance ri = rm.getInstance(entity);
+        if (lods.empty() || !ri) {
+            continue;
+        }
+
+        const Box box = rm.getAxisAlignedBoundingBox(ri);
+        const mat4f world = tm.getWorldTransform(tm.getInstance(entity));
+        const float3 center = (world * float4(box.center, 1.0f)).xyz;
+        const float maxScale = std::sqrt(std::max({ dot(world[0].xyz, world[0].xyz),
+                dot(world[1].xyz, world[1].xyz), dot(world[2].xyz, world[2].xyz) }));
+        const float radius = length(box.halfExtent) * maxScale;
+        float clipRadius = radius * projectionScale;
+        if (isPerspective) {
+            clipRadius /= std::max(distance(center, eye), radius);
+        }
+        const float screenSize = clipRadius;
+
+        auto& current = mLodLevels[entity];
+        if (current.empty()) {
+            current = FixedCapacityVector<uint8_t>(lods.size(), 0);
+        }
+        for (size_t primIndex = 0, n = lods.size(); primIndex < n; ++primIndex) {
+            PrimitiveLods const& prim = lods[primIndex];
+            uint8_t level = 0;
+            for (size_t i = 0; i < prim.levels.size(); ++i) {
+                if (screenSize <= prim.levels[i].screenSize) {
+                    level = uint8_t(i + 1);
+                }
+            }
+            if (level == current[primIndex]) {
+                continue;
+            }
+            current[primIndex] = level;
+            if (level == 0) {
+                rm.setGeometryAt(ri, primIndex, RenderableManager::PrimitiveType::TRIANGLES,
+                        prim.vertices, prim.indices, 0, prim.indices->getIndexCount());
+            } else {
+                PrimitiveLods::Level const& lod = prim.levels[level - 1];
+                rm.setGeometryAt(ri, primIndex, RenderableManager::PrimitiveType::TRIANGLES,
+                        prim.vertices, prim.lodIndices, lod.offset, lod.count);
+            }
+        }
+    }
+}
+
 size_t FFilamentInstance::getMaterialVariantCount() const noexcept {
     return mVariants.size();
 }
@@ -434,4 +509,8 @@ Aabb FilamentInstance::getBoundingBox() const noexcept {
     return downcast(this)->mBoundingBox;
 }
 
+void FilamentInstance::applyLevelOfDetail(Camera const& camera) noexcept {
+    downcast(this)->applyLevelOfDetail(camera);
+}
+
 } // namespace filament::gltfio
@@ -16,13 +16,23 @@
 
 #include <gltfio/MaterialProvider.h>
 
+#include "DiskCache.h"
+#include "FFilamentAsset.h"
+
+#include <filament/MaterialEnums.h>
+
 #include <filamat/MaterialBuilder.h>
 
 #include <utils/Hash.h>
+#include <utils/JobSystem.h>
+#include <utils/Log.h>
 
 #include <tsl/robin_map.h>
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace filamat;
 using namespace filament;
@@ -31,9 +41,13 @@ using namespace utils;
 
 namespace {
 
+// Bump this whenever the generated materials change for the same MaterialKey, which invalidates
+// previously cached materials.
+constexpr uint64_t kMaterialCacheVersion = 1;
+
 class JitShaderProvider : public MaterialProvider {
 public:
-    explicit JitShaderProvider(Engine* engine, bool optimizeShaders);
+    explicit JitShaderProvider(Engine* engine, bool optimizeShaders, const char* cacheDirectory);
     ~JitShaderProvider() override;
 
     MaterialInstance* createMaterialInstance(MaterialKey* config, UvMap* uvmap,
@@ -41,6 +55,9 @@ public:
 
     Material* getMaterial(MaterialKey* config, UvMap* uvmap, const char* label) override;
 
+    void prepareMaterials(const MaterialKey* configs, const char* const* labels,
+            size_t count) override;
+
     size_t getMaterialsCount() const noexcept override;
     const Material* const* getMaterials() const noexcept override;
     void destroyMaterials() override;
@@ -49,19 +66,51 @@ public:
         return false;
     }
 
+private:
+    // A material whose package is being built (or read from the disk cache) by a job.
+    struct PendingMaterial {
+        std::string label;
+        std::vector<uint8_t> package;
+        bool compiled = false;
+        JobSystem::Job* job = nullptr;
+    };
+
+    // Returns the package for the given (constrained) config, from the disk cache if possible.
+    // This is safe to call from any thread.
+    std::vector<uint8_t> getPackage(const MaterialKey& config, const UvMap& uvmap,
+            const char* label, bool* compiled) const;
+
+    void cancelPendingMaterials();
+
     using HashFn = hash::MurmurHashFn<MaterialKey>;
     tsl::robin_map<MaterialKey, Material*, HashFn> mCache;
+    tsl::robin_map<MaterialKey, std::unique_ptr<PendingMaterial>, HashFn> mPending;
     std::vector<Material*> mMaterials;
     Engine* const mEngine;
     const bool mOptimizeShaders;
+    const DiskCache mDiskCache;
+
+    // glslang performs unguarded global operations on first use, so materials are built one at a
+    // time until one of them has been compiled.
+    bool mHasCompiledMaterial = false;
 };
 
-JitShaderProvider::JitShaderProvider(Engine* engine, bool optimizeShaders) : mEngine(engine),
-        mOptimizeShaders(optimizeShaders) {
+static DiskCache createDiskCache(const char* cacheDirectory) {
+    if constexpr (GLTFIO_USE_FILESYSTEM) {
+        return DiskCache(cacheDirectory);
+    }
+    return {};
+}
+
+JitShaderProvider::JitShaderProvider(Engine* engine, bool optimizeShaders,
+        const char* cacheDirectory) : mEngine(engine),
+        mOptimizeShaders(optimizeShaders),
+        mDiskCache(createDiskCache(cacheDirectory)) {
     MaterialBuilder::init();
 }
 
 JitShaderProvider::~JitShaderProvider() {
+    cancelPendingMaterials();
     MaterialBuilder::shutdown();
 }
 
@@ -74,6 +123,7 @@ const Material* const* JitShaderProvider::getMaterials() const noexcept {
 }
 
 void JitShaderProvider::destroyMaterials() {
+    cancelPendingMaterials();
     for (auto& iter : mCache) {
         mEngine->destroy(iter.second);
     }
@@ -81,6 +131,18 @@ void JitShaderProvider::destroyMaterials() {
     mCache.clear();
 }
 
+void JitShaderProvider::cancelPendingMaterials() {
+    // JobSystem does not allow cancellation of in-flight jobs, so we wait for them and drop
+    // their results.
+    JobSystem& js = mEngine->getJobSystem();
+    for (auto& iter : mPending) {
+        if (iter.second->job) {
+            js.waitAndRelease(iter.second->job);
+        }
+    }
+    mPending.clear();
+}
+
 std::string shaderFromKey(const MaterialKey& config) {
     std::string shader = "void material(inout MaterialInputs material) {\n";
 
@@ -343,7 +405,7 @@ std::string shaderFromKey(const MaterialKey& config) {
     return shader;
 }
 
-Material* createMaterial(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
+Package buildMaterial(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
         const char* name, bool optimizeShaders) {
     std::string shader = shaderFromKey(config);
     processShaderString(&shader, uvmap, config);
@@ -581,39 +643,117 @@ Material* createMaterial(Engine* engine, const MaterialKey& config, const UvMap&
         builder.shading(Shading::LIT);
     }
 
-    Package pkg = builder.build(engine->getJobSystem());
-    return Material::Builder().package(pkg.getData(), pkg.getSize()).build(*engine);
+    return builder.build(engine->getJobSystem());
+}
+
+std::vector<uint8_t> JitShaderProvider::getPackage(const MaterialKey& config, const UvMap& uvmap,
+        const char* label, bool* compiled) const {
+    bool optimizeShaders = mOptimizeShaders;
+#ifndef NDEBUG
+    optimizeShaders = false;
+#endif
+
+    // The label only affects the name of the material, so it is not part of the key; a cached
+    // material keeps the name of the material it was first built for. The filamat build id
+    // invalidates materials cached by a previous version of Filament.
+    Engine::Config const& engineConfig = mEngine->getConfig();
+    DiskCache::Key const key = DiskCache::Hasher(kMaterialCacheVersion)
+            .add(MaterialBuilder::getBuildId()).add(config).add(uvmap).add(mEngine->getBackend())
+            .add(optimizeShaders).add(engineConfig.stereoscopicType)
+            .add(engineConfig.stereoscopicEyeCount).get();
+
+    std::vector<uint8_t> package;
+    *compiled = false;
+    if (mDiskCache.get(key, &package)) {
+        return package;
+    }
+
+    Package const pkg = buildMaterial(mEngine, config, uvmap, label, optimizeShaders);
+    *compiled = true;
+    if (!pkg.isValid()) {
+        return {};
+    }
+    const uint8_t* data = pkg.getData();
+    package.assign(data, data + pkg.getSize());
+    mDiskCache.put(key, package.data(), package.size());
+    return package;
+}
+
+void JitShaderProvider::prepareMaterials(const MaterialKey* configs, const char* const* labels,
+        size_t count) {
+    JobSystem& js = mEngine->getJobSystem();
+    for (size_t i = 0; i < count; i++) {
+        MaterialKey config = configs[i];
+        UvMap uvmap {};
+        constrainMaterial(&config, &uvmap);
+        if (mCache.find(config) != mCache.end() || mPending.find(config) != mPending.end()) {
+            continue;
+        }
+
+        PendingMaterial* const pending = mPending.emplace(config,
+                std::make_unique<PendingMaterial>()).first.value().get();
+        pending->label = labels[i] ? labels[i] : "material";
+
+        JobSystem::Job* job = jobs::createJob(js, nullptr, [this, pending, config, uvmap] {
+            pending->package = getPackage(config, uvmap, pending->label.c_str(),
+                    &pending->compiled);
+        });
+
+        if (!mHasCompiledMaterial) {
+            js.runAndWait(job);
+            mHasCompiledMaterial = pending->compiled;
+        } else {
+            pending->job = js.runAndRetain(job);
+        }
+    }
 }
 
 Material* JitShaderProvider::getMaterial(MaterialKey* config, UvMap* uvmap, const char* label) {
     constrainMaterial(config, uvmap);
     auto iter = mCache.find(*config);
-    if (iter == mCache.end()) {
+    if (iter != mCache.end()) {
+        return iter.value();
+    }
 
-        bool optimizeShaders = mOptimizeShaders;
-#ifndef NDEBUG
-        optimizeShaders = false;
-#endif
+    std::vector<uint8_t> package;
+    auto pos = mPending.find(*config);
+    if (pos != mPending.end()) {
+        PendingMaterial& pending = *pos.value();
+        if (pending.job) {
+            mEngine->getJobSystem().waitAndRelease(pending.job);
+        }
+        package = std::move(pending.package);
+        mPending.erase(pos);
+    } else {
+        bool compiled;
+        package = getPackage(*config, *uvmap, label, &compiled);
+        mHasCompiledMaterial = mHasCompiledMaterial || compiled;
+    }
 
-        Material* mat = createMaterial(mEngine, *config, *uvmap, label, optimizeShaders);
-        mCache.emplace(std::make_pair(*config, mat));
-        mMaterials.push_back(mat);
-        return mat;
+    if (package.empty()) {
+        slog.e << "Unable to build material " << (label ? label : "material") << io::endl;
+        return nullptr;
     }
-    return iter.value();
+
+    Material* mat = Material::Builder().package(package.data(), package.size()).build(*mEngine);
+    mCache.emplace(std::make_pair(*config, mat));
+    mMaterials.push_back(mat);
+    return mat;
 }
 
 MaterialInstance* JitShaderProvider::createMaterialInstance(MaterialKey* config, UvMap* uvmap,
         const char* label, const char* extras) {
-    return getMaterial(config, uvmap, label)->createInstance(label);
+    Material* mat = getMaterial(config, uvmap, label);
+    return mat ? mat->createInstance(label) : nullptr;
 }
 
 } // anonymous namespace
 
 namespace filament::gltfio {
 
-MaterialProvider* createJitShaderProvider(filament::Engine* engine, bool optimizeShaders) {
-    return new JitShaderProvider(engine, optimizeShaders);
+MaterialProvider* createJitShaderProvider(filament::Engine* engine, bool optimizeShaders,
+        const char* cacheDirectory) {
+    return new JitShaderProvider(engine, optimizeShaders, cacheDirectory);
 }
 
 } // namespace filament::gltfio
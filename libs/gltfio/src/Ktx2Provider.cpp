@@ -20,6 +20,7 @@
 #include <vector>
 
 #include <utils/JobSystem.h>
+#include <utils/Log.h>
 
 #include <filament/Engine.h>
 #include <filament/Texture.h>
@@ -70,10 +71,13 @@ private:
         ktxreader::Ktx2Reader::Async* async;
         QueueItemState state;
         atomic<TranscoderState> transcoderState;
+        atomic<uint32_t> pendingLevels;
+        atomic<bool> failed;
         JobSystem::Job* job;
     };
 
     void transcodeSingleTexture();
+    void reportStats(QueueItem const& item) const;
 
     size_t mPushedCount = 0;
     size_t mPoppedCount = 0;
@@ -84,6 +88,7 @@ private:
     std::string mRecentPopMessage;
     std::unique_ptr<ktxreader::Ktx2Reader> mKtxReader;
     Engine* const mEngine;
+    bool mQuiet;
 };
 
 Texture* Ktx2Provider::pushTexture(const uint8_t* data, size_t byteCount,
@@ -115,12 +120,28 @@ Texture* Ktx2Provider::pushTexture(const uint8_t* data, size_t byteCount,
         return async->getTexture();
     }
 
+    // Each miplevel is transcoded by its own job, such that large textures are spread across all
+    // worker threads. Jobs for the smallest levels are scheduled first, which allows updateQueue()
+    // to upload a low resolution version of the texture while the larger levels are in flight.
+    // The last job to finish publishes the final state of the texture.
+    const uint32_t levelCount = async->getLevelCount();
+    item->pendingLevels.store(levelCount);
+    item->failed.store(false);
+
     JobSystem* js = &mEngine->getJobSystem();
-    item->job = jobs::createJob(*js, mDecoderRootJob, [item] {
-        using Result = ktxreader::Ktx2Reader::Result;
-        const bool success = Result::SUCCESS == item->async->doTranscoding();
-        item->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
-    });
+    item->job = js->createJob(mDecoderRootJob);
+    for (uint32_t level = levelCount; level-- > 0;) {
+        js->run(jobs::createJob(*js, item->job, [item, level] {
+            using Result = ktxreader::Ktx2Reader::Result;
+            if (Result::SUCCESS != item->async->doTranscoding(level)) {
+                item->failed.store(true);
+            }
+            if (item->pendingLevels.fetch_sub(1) == 1) {
+                item->transcoderState.store(item->failed.load() ?
+                        TranscoderState::ERROR : TranscoderState::SUCCESS);
+            }
+        }));
+    }
 
     js->runAndRetain(item->job);
     return async->getTexture();
@@ -158,21 +179,23 @@ void Ktx2Provider::updateQueue() {
         if (item->state != QueueItemState::TRANSCODING) {
             continue;
         }
-        item->async->getTexture();
         const TranscoderState state = item->transcoderState.load();
-        if (state != TranscoderState::NOT_STARTED) {
-            if (item->job) {
-                js->waitAndRelease(item->job);
-            }
-            if (state == TranscoderState::ERROR) {
-                item->state = QueueItemState::READY;
-                ++mDecodedCount;
-                continue;
-            }
+        if (state == TranscoderState::NOT_STARTED) {
+            // Upload the levels that have been transcoded so far. Only the smallest ones are taken,
+            // so that the texture samples a contiguous range of levels in the meantime.
             item->async->uploadImages();
-            item->state = QueueItemState::READY;
-            ++mDecodedCount;
+            continue;
         }
+        if (item->job) {
+            js->waitAndRelease(item->job);
+            item->job = nullptr;
+        }
+        if (state == TranscoderState::SUCCESS) {
+            item->async->uploadImages();
+            reportStats(*item);
+        }
+        item->state = QueueItemState::READY;
+        ++mDecodedCount;
     }
 
     // Here we periodically clean up the "queue" (which is really just a vector) by removing unused
@@ -188,6 +211,7 @@ void Ktx2Provider::waitForCompletion() {
     for (auto& item : mQueueItems) {
         if (item->job) {
             js.waitAndRelease(item->job);
+            item->job = nullptr;
         }
     }
 }
@@ -218,6 +242,17 @@ const char* Ktx2Provider::getPopMessage() const {
     return mRecentPopMessage.empty() ? nullptr : mRecentPopMessage.c_str();
 }
 
+void Ktx2Provider::reportStats(QueueItem const& item) const {
+    if (mQuiet) {
+        return;
+    }
+    const ktxreader::Ktx2Reader::Async::Stats stats = item.async->getStats();
+    Texture const* texture = item.async->getTexture();
+    slog.i << "Transcoded " << texture->getWidth() << "x" << texture->getHeight()
+           << " KTX2 texture in " << float(stats.transcodeNanoseconds) / 1e6f
+           << " ms (peak " << (stats.peakPendingBytes + 1023) / 1024 << " KiB)" << io::endl;
+}
+
 void Ktx2Provider::transcodeSingleTexture() {
     assert_invariant(!UTILS_HAS_THREADING);
     for (auto& item : mQueueItems) {
@@ -233,11 +268,11 @@ void Ktx2Provider::transcodeSingleTexture() {
 Ktx2Provider::Ktx2Provider(Engine* engine) : mEngine(engine) {
     mDecoderRootJob = mEngine->getJobSystem().createJob();
 #ifdef NDEBUG
-    const bool quiet = true;
+    mQuiet = true;
 #else
-    const bool quiet = false;
+    mQuiet = false;
 #endif
-    mKtxReader.reset(new ktxreader::Ktx2Reader(*engine, quiet));
+    mKtxReader.reset(new ktxreader::Ktx2Reader(*engine, mQuiet));
 
     mKtxReader->requestFormat(Texture::InternalFormat::ETC2_EAC_SRGBA8);
     mKtxReader->requestFormat(Texture::InternalFormat::DXT5_SRGBA);
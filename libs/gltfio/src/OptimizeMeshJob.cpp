@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OptimizeMeshJob.h"
+
+#include <meshoptimizer.h>
+
+#include <utils/compiler.h>
+
+#include <string.h>
+
+#include <vector>
+
+using namespace filament::gltfio;
+using namespace filament;
+using namespace filament::math;
+
+namespace {
+
+uint8_t* getAccessorData(const cgltf_accessor* accessor) {
+    return (uint8_t*) cgltf_buffer_view_data(accessor->buffer_view) + accessor->offset;
+}
+
+// Permutes the elements of the given accessor in place, honoring its stride.
+void remapAccessor(const cgltf_accessor* accessor, const uint32_t* remap,
+        std::vector<uint8_t>& scratch) {
+    const size_t elementSize = cgltf_calc_size(accessor->type, accessor->component_type);
+    const size_t stride = accessor->stride;
+    const size_t count = accessor->count;
+    uint8_t* data = getAccessorData(accessor);
+    scratch.resize(elementSize * count);
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(scratch.data() + remap[i] * elementSize, data + i * stride, elementSize);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(data + i * stride, scratch.data() + i * elementSize, elementSize);
+    }
+}
+
+template<typename T>
+void writeIndices(uint8_t* dst, size_t stride, const uint32_t* src, size_t count) {
+    for (size_t i = 0; i < count; ++i, dst += stride) {
+        *((T*) dst) = T(src[i]);
+    }
+}
+
+} // anonymous namespace
+
+// This procedure is designed to run in an isolated job.
+void OptimizeMeshJob::run(Params* params) {
+    cgltf_primitive& prim = *params->in.prim;
+    const cgltf_accessor* indicesAccessor = prim.indices;
+    const cgltf_accessor* positionsAccessor = nullptr;
+    for (cgltf_size aindex = 0; aindex < prim.attributes_count; aindex++) {
+        const cgltf_attribute& attr = prim.attributes[aindex];
+        if (attr.type == cgltf_attribute_type_position && attr.index == 0) {
+            positionsAccessor = attr.data;
+        }
+    }
+    if (UTILS_UNLIKELY(!indicesAccessor || !positionsAccessor)) {
+        return;
+    }
+
+    const size_t indexCount = indicesAccessor->count;
+    const size_t vertexCount = positionsAccessor->count;
+    if (indexCount == 0 || indexCount % 3 != 0 || vertexCount == 0) {
+        return;
+    }
+
+    // Every per-vertex accessor is rewritten in place, so bail out before touching anything if
+    // one of them cannot be.
+    auto isWritable = [vertexCount](const cgltf_accessor* accessor) {
+        return !accessor->is_sparse && accessor->buffer_view &&
+                cgltf_buffer_view_data(accessor->buffer_view) && accessor->count == vertexCount;
+    };
+    for (cgltf_size aindex = 0; aindex < prim.attributes_count; aindex++) {
+        if (!isWritable(prim.attributes[aindex].data)) {
+            return;
+        }
+    }
+    for (cgltf_size tindex = 0; tindex < prim.targets_count; tindex++) {
+        const cgltf_morph_target& target = prim.targets[tindex];
+        for (cgltf_size aindex = 0; aindex < target.attributes_count; aindex++) {
+            if (!isWritable(target.attributes[aindex].data)) {
+                return;
+            }
+        }
+    }
+
+    std::vector<uint32_t> indices(indexCount);
+    if (cgltf_accessor_unpack_indices(indicesAccessor, indices.data(), sizeof(uint32_t),
+            indexCount) != indexCount) {
+        return;
+    }
+    for (uint32_t index : indices) {
+        if (UTILS_UNLIKELY(index >= vertexCount)) {
+            return;
+        }
+    }
+
+    std::vector<float3> positions(vertexCount);
+    cgltf_accessor_unpack_floats(positionsAccessor, &positions[0].x, vertexCount * 3);
+
+    meshopt_optimizeVertexCache(indices.data(), indices.data(), indexCount, vertexCount);
+    meshopt_optimizeOverdraw(indices.data(), indices.data(), indexCount, &positions[0].x,
+            vertexCount, sizeof(float3), 1.05f);
+
+    // Compute a vertex order that follows the order of first use in the index buffer. Unreferenced
+    // vertices are moved to the end rather than discarded, because the VertexBuffer has already
+    // been created with the original vertex count.
+    std::vector<uint32_t> remap(vertexCount);
+    size_t nextVertex = meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indexCount,
+            vertexCount);
+    for (uint32_t& r : remap) {
+        if (r == ~0u) {
+            r = uint32_t(nextVertex++);
+        }
+    }
+    meshopt_remapIndexBuffer(indices.data(), indices.data(), indexCount, remap.data());
+    meshopt_remapVertexBuffer(positions.data(), positions.data(), vertexCount, sizeof(float3),
+            remap.data());
+
+    // Split the primitive into meshlets and compute their culling bounds.
+    const size_t maxMeshlets = meshopt_buildMeshletsBound(indexCount, kMaxMeshletVertices,
+            kMaxMeshletTriangles);
+    std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+    std::vector<uint32_t> meshletVertices(maxMeshlets * kMaxMeshletVertices);
+    std::vector<uint8_t> meshletTriangles(maxMeshlets * kMaxMeshletTriangles * 3);
+    const size_t meshletCount = meshopt_buildMeshlets(meshlets.data(), meshletVertices.data(),
+            meshletTriangles.data(), indices.data(), indexCount, &positions[0].x, vertexCount,
+            sizeof(float3), kMaxMeshletVertices, kMaxMeshletTriangles, 0.25f);
+
+    // Rewrite the index buffer such that each meshlet covers a contiguous range of indices.
+    std::vector<uint32_t> clustered;
+    clustered.reserve(indexCount);
+    utils::FixedCapacityVector<Meshlet> result(meshletCount);
+    for (size_t i = 0; i < meshletCount; ++i) {
+        const meshopt_Meshlet& src = meshlets[i];
+        const uint32_t* vertices = &meshletVertices[src.vertex_offset];
+        const uint8_t* triangles = &meshletTriangles[src.triangle_offset];
+        const meshopt_Bounds bounds = meshopt_computeMeshletBounds(vertices, triangles,
+                src.triangle_count, &positions[0].x, vertexCount, sizeof(float3));
+        result[i] = {
+            .indexOffset = uint32_t(clustered.size()),
+            .indexCount = src.triangle_count * 3,
+            .center = { bounds.center[0], bounds.center[1], bounds.center[2] },
+            .radius = bounds.radius,
+            .coneApex = { bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2] },
+            .coneAxis = { bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] },
+            .coneCutoff = bounds.cone_cutoff,
+        };
+        for (size_t j = 0, n = src.triangle_count * 3; j < n; ++j) {
+            clustered.push_back(vertices[triangles[j]]);
+        }
+    }
+    if (UTILS_UNLIKELY(clustered.size() != indexCount)) {
+        // Fall back to the cache-optimized order without meshlets.
+        clustered = std::move(indices);
+        result.clear();
+    }
+
+    // Write the results back into the source buffers, which the ResourceLoader uploads later.
+    uint8_t* indexData = getAccessorData(indicesAccessor);
+    switch (indicesAccessor->component_type) {
+        case cgltf_component_type_r_8u:
+            writeIndices<uint8_t>(indexData, indicesAccessor->stride, clustered.data(), indexCount);
+            break;
+        case cgltf_component_type_r_16u:
+            writeIndices<uint16_t>(indexData, indicesAccessor->stride, clustered.data(), indexCount);
+            break;
+        default:
+            writeIndices<uint32_t>(indexData, indicesAccessor->stride, clustered.data(), indexCount);
+            break;
+    }
+
+    // Several attributes might alias the same accessor, so each one is permuted only once.
+    std::vector<const cgltf_accessor*> visited;
+    std::vector<uint8_t> scratch;
+    auto remapOnce = [&](const cgltf_accessor* accessor) {
+        for (const cgltf_accessor* other : visited) {
+            if (other == accessor) {
+                return;
+            }
+        }
+        visited.push_back(accessor);
+        remapAccessor(accessor, remap.data(), scratch);
+    };
+    for (cgltf_size aindex = 0; aindex < prim.attributes_count; aindex++) {
+        remapOnce(prim.attributes[aindex].data);
+    }
+    for (cgltf_size tindex = 0; tindex < prim.targets_count; tindex++) {
+        const cgltf_morph_target& target = prim.targets[tindex];
+        for (cgltf_size aindex = 0; aindex < target.attributes_count; aindex++) {
+            remapOnce(target.attributes[aindex].data);
+        }
+    }
+
+    params->out.meshlets = std::move(result);
+}
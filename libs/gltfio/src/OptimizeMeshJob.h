@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_OPTIMIZEMESHJOB_H
+#define GLTFIO_OPTIMIZEMESHJOB_H
+
+#include <gltfio/FilamentAsset.h>
+
+#include <cgltf.h>
+
+#include <utils/FixedCapacityVector.h>
+
+#include <stdint.h>
+
+namespace filament::gltfio {
+
+using Meshlet = FilamentAsset::Meshlet;
+
+/**
+ * Internal helper that reorders the index and vertex data of a cgltf primitive in place for GPU
+ * friendliness (post-transform cache, overdraw, and vertex fetch) and splits it into meshlets.
+ * This has been designed to be run as a JobSystem job, but clients are not required to do so.
+ *
+ * The primitive must be an indexed triangle list whose accessors are not shared with any other
+ * primitive, since every vertex attribute (including morph targets) gets permuted.
+ */
+struct OptimizeMeshJob {
+    static constexpr size_t kMaxMeshletVertices = 64;
+    static constexpr size_t kMaxMeshletTriangles = 124;
+
+    // The inputs to the procedure. The prim is owned by the client, which should ensure that it
+    // stays alive for the duration of the procedure.
+    struct InputParams {
+        cgltf_primitive* prim;
+    };
+
+    // The outputs of the procedure. The list of meshlets is empty if the primitive was left as-is.
+    struct OutputParams {
+        utils::FixedCapacityVector<Meshlet> meshlets;
+    };
+
+    struct Params {
+        InputParams in;
+        OutputParams out;
+    };
+
+    // Performs the optimization synchronously. This can be invoked from inside a job if desired.
+    // The parameters structure is owned by the client.
+    static void run(Params* params);
+};
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_OPTIMIZEMESHJOB_H
@@ -17,8 +17,10 @@
 #include <gltfio/ResourceLoader.h>
 #include <gltfio/TextureProvider.h>
 
+#include "DiskCache.h"
 #include "GltfEnums.h"
 #include "FFilamentAsset.h"
+#include "OptimizeMeshJob.h"
 #include "TangentsJob.h"
 #include "downcast.h"
 #include "Utility.h"
@@ -32,6 +34,7 @@
 #include <filament/VertexBuffer.h>
 #include <filament/MorphTargetBuffer.h>
 
+#include <geometry/MeshSimplifier.h>
 #include <geometry/Transcoder.h>
 
 #include <utils/compiler.h>
@@ -48,8 +51,11 @@
 #include <math/vec4.h>
 
 #include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -59,9 +65,18 @@ using namespace filament::math;
 using namespace utils;
 
 using filament::geometry::ComponentType;
+using filament::geometry::MeshSimplifier;
 
 static const auto FREE_CALLBACK = [](void* mem, size_t, void*) { free(mem); };
 
+// A simplified level of detail is used once its error, projected on screen, drops below this
+// fraction of the viewport height. This is about one pixel on a 1080p display.
+// MeshSimplifier reports errors relative to the mesh extents, which we bound by the diameter of the
+// bounding sphere. A level's error therefore covers error * D of the viewport height, where D is
+// the projected diameter as a fraction of the viewport height, and the level is selected when
+// D <= kLodScreenError / error.
+static constexpr float kLodScreenError = 1.0f / 1000.0f;
+
 namespace filament::gltfio {
 
 using BufferTextureCache = tsl::robin_map<const void*, Texture*>;
@@ -81,17 +96,32 @@ struct ResourceLoader::Impl {
     explicit Impl(const ResourceConfiguration& config) :
         mEngine(config.engine),
         mNormalizeSkinningWeights(config.normalizeSkinningWeights),
+        mOptimizeMeshes(config.optimizeMeshes),
+        mLodCount(config.lodCount),
         mGltfPath(config.gltfPath ? config.gltfPath : ""),
-        mUriDataCache(std::make_shared<UriDataCache>()) {}
+        mUriDataCache(std::make_shared<UriDataCache>()),
+        mDiskCache(createDiskCache(config)) {}
+
+    static DiskCache createDiskCache(const ResourceConfiguration& config) {
+        if constexpr (GLTFIO_USE_FILESYSTEM) {
+            return DiskCache(config.cacheDirectory);
+        }
+        return {};
+    }
 
     Engine* const mEngine;
     bool mNormalizeSkinningWeights;
+    bool mOptimizeMeshes;
+    uint8_t mLodCount;
     std::string mGltfPath;
 
     // User-provided resource data with URI string keys, populated with addResourceData().
     // This is used on platforms without traditional file systems, such as Android, iOS, and WebGL.
     UriDataCacheHandle mUriDataCache;
 
+    // Persistent storage for derived data, disabled unless a cache directory was supplied.
+    DiskCache mDiskCache;
+
     // User-provided mapping from mime types to texture providers.
     TextureProviderList mTextureProviders;
 
@@ -103,6 +133,9 @@ struct ResourceLoader::Impl {
     size_t mRemainingTextureDownloads = 0;
 
     void addResourceData(const char* uri, BufferDescriptor&& buffer);
+    void decodeDracoMeshes(FFilamentAsset* asset);
+    void optimizeMeshes(FFilamentAsset* asset);
+    void generateLods(FFilamentAsset* asset);
     void computeTangents(FFilamentAsset* asset);
     void createTextures(FFilamentAsset* asset, bool async);
     void cancelTextureDecoding();
@@ -318,6 +351,90 @@ inline void uploadBuffers(FFilamentAsset* asset, Engine& engine,
     }
 }
 
+// Bump this whenever TangentsJob produces different results for the same input, which invalidates
+// previously cached tangents.
+constexpr uint64_t kTangentsCacheVersion = 1;
+
+// Computes a cache key that covers all the data that TangentsJob reads for the given input, or
+// returns an empty key if the input cannot be hashed (e.g. sparse accessors).
+DiskCache::Key hashTangentsInput(TangentsJob::InputParams const& in) {
+    DiskCache::Hasher hasher(kTangentsCacheVersion);
+    auto addAccessor = [&hasher](cgltf_attribute_type type, cgltf_accessor const* accessor) {
+        if (accessor->is_sparse || !accessor->buffer_view) {
+            return false;
+        }
+        const uint8_t* data = cgltf_buffer_view_data(accessor->buffer_view);
+        if (!data) {
+            return false;
+        }
+        hasher.add(type).add(accessor->type).add(accessor->component_type)
+                .add(accessor->normalized).add(accessor->count).add(accessor->stride);
+        if (accessor->count > 0) {
+            hasher.add(data + accessor->offset, utility::computeBindingSize(accessor));
+        }
+        return true;
+    };
+    auto addAttributes = [&addAccessor](cgltf_attribute const* attributes, cgltf_size count) {
+        for (cgltf_size aindex = 0; aindex < count; ++aindex) {
+            cgltf_attribute const& attr = attributes[aindex];
+            if (attr.index != 0) {
+                continue;
+            }
+            switch (attr.type) {
+                case cgltf_attribute_type_position:
+                case cgltf_attribute_type_normal:
+                case cgltf_attribute_type_tangent:
+                case cgltf_attribute_type_texcoord:
+                    if (!addAccessor(attr.type, attr.data)) {
+                        return false;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        return true;
+    };
+
+    cgltf_primitive const& prim = *in.prim;
+    hasher.add(in.morphTargetIndex);
+    if (prim.indices && !addAccessor(cgltf_attribute_type_invalid, prim.indices)) {
+        return {};
+    }
+    if (!addAttributes(prim.attributes, prim.attributes_count)) {
+        return {};
+    }
+    if (in.morphTargetIndex != TangentsJob::kMorphTargetUnused) {
+        cgltf_morph_target const& target = prim.targets[in.morphTargetIndex];
+        if (!addAttributes(target.attributes, target.attributes_count)) {
+            return {};
+        }
+    }
+    return hasher.get();
+}
+
+// Runs TangentsJob, or fetches its results from the given cache if they have been computed by a
+// previous run.
+void runTangentsJob(TangentsJob::Params* params, DiskCache const& cache) {
+    const DiskCache::Key key =
+            cache.isEnabled() ? hashTangentsInput(params->in) : DiskCache::Key{};
+    if (key != DiskCache::Key{}) {
+        const cgltf_primitive& prim = *params->in.prim;
+        const cgltf_size vertexCount = prim.attributes_count ? prim.attributes[0].data->count : 0;
+        std::vector<uint8_t> blob;
+        if (cache.get(key, &blob) && blob.size() == vertexCount * sizeof(short4)) {
+            params->out.vertexCount = vertexCount;
+            params->out.results = (short4*) malloc(blob.size());
+            memcpy(params->out.results, blob.data(), blob.size());
+            return;
+        }
+    }
+    TangentsJob::run(params);
+    if (key != DiskCache::Key{} && params->out.results) {
+        cache.put(key, params->out.results, params->out.vertexCount * sizeof(short4));
+    }
+}
+
 } // anonymous namespace
 
 ResourceLoader::ResourceLoader(const ResourceConfiguration& config) : pImpl(new Impl(config)) { }
@@ -328,6 +445,9 @@ ResourceLoader::~ResourceLoader() {
 
 void ResourceLoader::setConfiguration(const ResourceConfiguration& config) {
     pImpl->mNormalizeSkinningWeights = config.normalizeSkinningWeights;
+    pImpl->mOptimizeMeshes = config.optimizeMeshes;
+    pImpl->mLodCount = config.lodCount;
+    pImpl->mDiskCache = Impl::createDiskCache(config);
     pImpl->mGltfPath = config.gltfPath;
 }
 
@@ -432,17 +552,17 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
 
         // Decompress Draco meshes early on, which allows us to exploit subsequent processing such
         // as tangent generation.
-        DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
-        auto& primitives = std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mPrimitives;
-        // Go through every primitive and check if it has a Draco mesh.
-        for (auto& [prim, vertexBuffer]: primitives) {
-            if (!prim->has_draco_mesh_compression) {
-                continue;
-            }
-            utility::decodeDracoMeshes(gltf, prim, dracoCache);
-        }
+        pImpl->decodeDracoMeshes(asset);
         utility::decodeMeshoptCompression((cgltf_data*) gltf);
 
+        // Reorder vertex data before it gets uploaded and before tangents are generated from it.
+        if (pImpl->mOptimizeMeshes) {
+            pImpl->optimizeMeshes(asset);
+        }
+        if (pImpl->mLodCount > 0) {
+            pImpl->generateLods(asset);
+        }
+
         uploadBuffers(asset, *pImpl->mEngine, pImpl->mUriDataCache);
 
         // Compute surface orientation quaternions if necessary. This is similar to sparse data in
@@ -673,6 +793,213 @@ void ResourceLoader::Impl::createTextures(FFilamentAsset* asset, bool async) {
     }
 }
 
+void ResourceLoader::Impl::optimizeMeshes(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+
+    cgltf_data* gltf = asset->mSourceAsset->hierarchy;
+
+    // Primitives are permuted in place, so skip any primitive whose data is also referenced by
+    // another primitive. Accessors are identified by the address of their first element, which
+    // also catches distinct accessors that alias the same bytes.
+    tsl::robin_map<const uint8_t*, const cgltf_primitive*> owners;
+    tsl::robin_set<const cgltf_primitive*> shared;
+    auto addOwner = [&owners, &shared](const cgltf_primitive* prim, const cgltf_accessor* accessor) {
+        if (!accessor || !accessor->buffer_view) {
+            return;
+        }
+        const uint8_t* data = cgltf_buffer_view_data(accessor->buffer_view);
+        if (!data) {
+            return;
+        }
+        auto [iter, inserted] = owners.try_emplace(data + accessor->offset, prim);
+        if (!inserted && iter->second != prim) {
+            shared.insert(prim);
+            shared.insert(iter->second);
+        }
+    };
+    for (cgltf_size mindex = 0; mindex < gltf->meshes_count; ++mindex) {
+        const cgltf_mesh& mesh = gltf->meshes[mindex];
+        for (cgltf_size pindex = 0; pindex < mesh.primitives_count; ++pindex) {
+            const cgltf_primitive& prim = mesh.primitives[pindex];
+            addOwner(&prim, prim.indices);
+            for (cgltf_size aindex = 0; aindex < prim.attributes_count; ++aindex) {
+                addOwner(&prim, prim.attributes[aindex].data);
+            }
+            for (cgltf_size tindex = 0; tindex < prim.targets_count; ++tindex) {
+                const cgltf_morph_target& target = prim.targets[tindex];
+                for (cgltf_size aindex = 0; aindex < target.attributes_count; ++aindex) {
+                    addOwner(&prim, target.attributes[aindex].data);
+                }
+            }
+        }
+    }
+
+    // Create a job description for each eligible primitive that has been instantiated.
+    using Params = OptimizeMeshJob::Params;
+    std::vector<std::pair<FixedCapacityVector<Meshlet>*, Params>> jobParams;
+    asset->mMeshlets = MeshMeshlets(gltf->meshes_count);
+    for (cgltf_size mindex = 0; mindex < gltf->meshes_count; ++mindex) {
+        cgltf_mesh& mesh = gltf->meshes[mindex];
+        FixedCapacityVector<Primitive>& prims = asset->mMeshCache[mindex];
+        if (prims.empty()) {
+            continue;
+        }
+        auto& meshlets = asset->mMeshlets[mindex];
+        meshlets = FixedCapacityVector<FixedCapacityVector<Meshlet>>(mesh.primitives_count);
+        for (cgltf_size pindex = 0; pindex < mesh.primitives_count; ++pindex) {
+            cgltf_primitive* prim = &mesh.primitives[pindex];
+            if (prim->type != cgltf_primitive_type_triangles || !prim->indices ||
+                    !prims[pindex].vertices || shared.find(prim) != shared.end()) {
+                continue;
+            }
+            jobParams.emplace_back(&meshlets[pindex], Params{{ prim }});
+        }
+    }
+
+    JobSystem* js = &mEngine->getJobSystem();
+    JobSystem::Job* parent = js->createJob();
+    for (auto& [target, params] : jobParams) {
+        Params* pptr = &params;
+        js->run(jobs::createJob(*js, parent, [pptr] { OptimizeMeshJob::run(pptr); }));
+    }
+    js->runAndWait(parent);
+
+    for (auto& [target, params] : jobParams) {
+        *target = std::move(params.out.meshlets);
+    }
+}
+
+void ResourceLoader::Impl::decodeDracoMeshes(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+
+    cgltf_data const* gltf = asset->mSourceAsset->hierarchy;
+    DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
+    auto& primitives = std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mPrimitives;
+
+    // Group the Draco primitives by compressed mesh. Primitives that share a mesh also share its
+    // accessors, so each group must be processed by a single job. The meshes are registered in the
+    // cache up front, which leaves the cache untouched while the jobs are running.
+    tsl::robin_map<const cgltf_buffer_view*, std::vector<const cgltf_primitive*>> groups;
+    for (auto& [prim, vertexBuffer] : primitives) {
+        if (!prim->has_draco_mesh_compression) {
+            continue;
+        }
+        const cgltf_buffer_view* view = prim->draco_mesh_compression.buffer_view;
+        dracoCache->findOrCreateLazyMesh(view, &mDiskCache);
+        groups[view].push_back(prim);
+    }
+    if (groups.empty()) {
+        return;
+    }
+
+    JobSystem* js = &mEngine->getJobSystem();
+    JobSystem::Job* parent = js->createJob();
+    for (auto const& [view, prims] : groups) {
+        std::vector<const cgltf_primitive*> const* group = &prims;
+        js->run(jobs::createJob(*js, parent, [gltf, group, dracoCache] {
+            for (const cgltf_primitive* prim : *group) {
+                utility::decodeDracoMeshes(gltf, prim, dracoCache);
+            }
+        }));
+    }
+    js->runAndWait(parent);
+}
+
+void ResourceLoader::Impl::generateLods(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+
+    cgltf_data const* gltf = asset->mSourceAsset->hierarchy;
+    asset->mMeshLods = MeshLods(gltf->meshes_count);
+
+    // Create a job description for each indexed triangle primitive that has been instantiated.
+    struct Params {
+        const cgltf_primitive* prim;
+        PrimitiveLods* lods;
+        MeshSimplifier::Result result;
+    };
+    std::vector<Params> jobParams;
+    for (cgltf_size mindex = 0; mindex < gltf->meshes_count; ++mindex) {
+        const cgltf_mesh& mesh = gltf->meshes[mindex];
+        FixedCapacityVector<Primitive> const& prims = asset->mMeshCache[mindex];
+        if (prims.empty()) {
+            continue;
+        }
+        auto& lods = asset->mMeshLods[mindex];
+        lods = FixedCapacityVector<PrimitiveLods>(mesh.primitives_count);
+        for (cgltf_size pindex = 0; pindex < mesh.primitives_count; ++pindex) {
+            const cgltf_primitive& prim = mesh.primitives[pindex];
+            if (prim.type != cgltf_primitive_type_triangles || !prim.indices ||
+                    !prims[pindex].vertices || !prims[pindex].indices) {
+                continue;
+            }
+            lods[pindex].vertices = prims[pindex].vertices;
+            lods[pindex].indices = prims[pindex].indices;
+            jobParams.push_back({ &prim, &lods[pindex] });
+        }
+    }
+
+    // Kick off jobs for simplifying the geometry.
+    const MeshSimplifier simplify({ .levelCount = mLodCount });
+    JobSystem* js = &mEngine->getJobSystem();
+    JobSystem::Job* parent = js->createJob();
+    for (Params& params : jobParams) {
+        Params* pptr = &params;
+        js->run(jobs::createJob(*js, parent, [pptr, &simplify] {
+            const cgltf_primitive& prim = *pptr->prim;
+            const cgltf_accessor* positions = nullptr;
+            for (cgltf_size aindex = 0; aindex < prim.attributes_count; ++aindex) {
+                if (prim.attributes[aindex].type == cgltf_attribute_type_position) {
+                    positions = prim.attributes[aindex].data;
+                }
+            }
+            if (!positions) {
+                return;
+            }
+            const cgltf_size indexCount = prim.indices->count;
+            const cgltf_size vertexCount = positions->count;
+            std::vector<uint32_t> indices(indexCount);
+            std::vector<float3> vertices(vertexCount);
+            if (cgltf_accessor_unpack_indices(prim.indices, indices.data(), sizeof(uint32_t),
+                    indexCount) != indexCount) {
+                return;
+            }
+            cgltf_accessor_unpack_floats(positions, &vertices[0].x, vertexCount * 3);
+            pptr->result = simplify(indices.data(), indexCount, vertices.data(), vertexCount);
+        }));
+    }
+    js->runAndWait(parent);
+
+    // Finally, upload the simplified indices to the GPU from the main thread.
+    for (Params& params : jobParams) {
+        MeshSimplifier::Result const& result = params.result;
+        if (result.levels.empty()) {
+            continue;
+        }
+        const size_t byteCount = result.indices.size() * sizeof(uint32_t);
+        uint32_t* data = (uint32_t*) malloc(byteCount);
+        memcpy(data, result.indices.data(), byteCount);
+        IndexBuffer* indices = IndexBuffer::Builder()
+                .indexCount(result.indices.size())
+                .bufferType(IndexBuffer::IndexType::UINT)
+                .build(*mEngine);
+        indices->setBuffer(*mEngine, IndexBuffer::BufferDescriptor(data, byteCount, FREE_CALLBACK));
+        asset->mIndexBuffers.push_back(indices);
+
+        PrimitiveLods& lods = *params.lods;
+        lods.lodIndices = indices;
+        lods.levels = FixedCapacityVector<PrimitiveLods::Level>(result.levels.size());
+        for (size_t i = 0, n = result.levels.size(); i < n; ++i) {
+            MeshSimplifier::Level const& level = result.levels[i];
+            lods.levels[i] = {
+                .offset = level.indexOffset,
+                .count = level.indexCount,
+                .screenSize = level.error > 0.0f ? kLodScreenError / level.error :
+                        std::numeric_limits<float>::max(),
+            };
+        }
+    }
+}
+
 void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     SYSTRACE_CALL();
 
@@ -737,29 +1064,37 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
         }
     }
 
-    // Kick off jobs for computing tangent frames.
+    // Kick off jobs for computing tangent frames. Each job allocates scratch space proportional to
+    // the size of its primitive, so to bound the working set on assets with many large meshes,
+    // the jobs run in batches of a few per thread.
     JobSystem* js = &mEngine->getJobSystem();
-    JobSystem::Job* parent = js->createJob();
-    for (Params& params : jobParams) {
-        Params* pptr = &params;
-        js->run(jobs::createJob(*js, parent, [pptr] { TangentsJob::run(pptr); }));
-    }
-    js->runAndWait(parent);
-
-    // Finally, upload quaternions to the GPU from the main thread.
-    for (Params& params : jobParams) {
-        if (params.context.vb) {
-            BufferObject* bo = BufferObject::Builder()
-                    .size(params.out.vertexCount * sizeof(short4)).build(*mEngine);
-            asset->mBufferObjects.push_back(bo);
-            bo->setBuffer(*mEngine, BufferDescriptor(
-                    params.out.results, bo->getByteCount(), FREE_CALLBACK));
-            params.context.vb->setBufferObjectAt(*mEngine, params.context.slot, bo);
-        } else {
-            assert_invariant(params.context.tb);
-            params.context.tb->setTangentsAt(*mEngine, params.in.morphTargetIndex,
-                    params.out.results, params.out.vertexCount, params.context.offset);
-            free(params.out.results);
+    const size_t batchSize = std::max(js->getThreadCount(), size_t(1)) * 2;
+    const DiskCache* cache = &mDiskCache;
+    for (size_t begin = 0, count = jobParams.size(); begin < count; begin += batchSize) {
+        const size_t end = std::min(begin + batchSize, count);
+        JobSystem::Job* parent = js->createJob();
+        for (size_t i = begin; i < end; ++i) {
+            Params* pptr = &jobParams[i];
+            js->run(jobs::createJob(*js, parent, [pptr, cache] { runTangentsJob(pptr, *cache); }));
+        }
+        js->runAndWait(parent);
+
+        // Upload quaternions to the GPU from the main thread.
+        for (size_t i = begin; i < end; ++i) {
+            Params& params = jobParams[i];
+            if (params.context.vb) {
+                BufferObject* bo = BufferObject::Builder()
+                        .size(params.out.vertexCount * sizeof(short4)).build(*mEngine);
+                asset->mBufferObjects.push_back(bo);
+                bo->setBuffer(*mEngine, BufferDescriptor(
+                        params.out.results, bo->getByteCount(), FREE_CALLBACK));
+                params.context.vb->setBufferObjectAt(*mEngine, params.context.slot, bo);
+            } else {
+                assert_invariant(params.context.tb);
+                params.context.tb->setTangentsAt(*mEngine, params.in.morphTargetIndex,
+                        params.out.results, params.out.vertexCount, params.context.offset);
+                free(params.out.results);
+            }
         }
     }
 }
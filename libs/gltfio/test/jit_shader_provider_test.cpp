@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Engine.h>
+#include <filament/Material.h>
+
+#include <gltfio/MaterialProvider.h>
+
+#include <utils/Path.h>
+
+#include <array>
+#include <string>
+
+#include <string.h>
+
+using namespace filament;
+using namespace filament::gltfio;
+using namespace utils;
+
+namespace {
+
+constexpr size_t kMaterialCount = 3;
+
+// Three configs that lead to three distinct materials.
+std::array<MaterialKey, kMaterialCount> createConfigs() {
+    std::array<MaterialKey, kMaterialCount> configs;
+    for (MaterialKey& config : configs) {
+        memset(&config, 0, sizeof(config));
+        config.alphaMode = AlphaMode::OPAQUE;
+    }
+    configs[1].unlit = true;
+    configs[2].hasVertexColors = true;
+    return configs;
+}
+
+} // anonymous namespace
+
+class JitShaderProviderTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        ASSERT_NE(mEngine, nullptr);
+        for (Path const& entry : mCacheDirectory.listContents()) {
+            Path(entry).unlinkFile();
+        }
+    }
+
+    void TearDown() override {
+        Engine::destroy(&mEngine);
+    }
+
+    // Announces all the configs, then requests them in the reverse order, such that the ones that
+    // were built in the background are waited for. Returns the names of the materials.
+    std::array<std::string, kMaterialCount> prepareAndGet(MaterialProvider* provider,
+            const char* const* labels) {
+        auto configs = createConfigs();
+        provider->prepareMaterials(configs.data(), labels, kMaterialCount);
+
+        std::array<std::string, kMaterialCount> names;
+        for (size_t i = kMaterialCount; i-- > 0;) {
+            UvMap uvmap{};
+            Material const* const material = provider->getMaterial(&configs[i], &uvmap, labels[i]);
+            EXPECT_NE(material, nullptr) << labels[i];
+            if (material) {
+                names[i] = material->getName();
+            }
+        }
+        EXPECT_EQ(provider->getMaterialsCount(), kMaterialCount);
+
+        // Requesting a material again returns the cached one.
+        UvMap uvmap{};
+        EXPECT_EQ(provider->getMaterial(&configs[0], &uvmap, labels[0]),
+                provider->getMaterials()[kMaterialCount - 1]);
+        EXPECT_EQ(provider->getMaterialsCount(), kMaterialCount);
+        return names;
+    }
+
+    Engine* mEngine = nullptr;
+    Path const mCacheDirectory = Path::getTemporaryDirectory() + "test_gltfio_material_cache";
+};
+
+TEST_F(JitShaderProviderTest, PrepareMaterials) { // NOLINT
+    const char* const labels[kMaterialCount] = { "first0", "first1", "first2" };
+    MaterialProvider* provider = createJitShaderProvider(mEngine, false, mCacheDirectory.c_str());
+    auto const names = prepareAndGet(provider, labels);
+    for (size_t i = 0; i < kMaterialCount; i++) {
+        EXPECT_EQ(names[i], labels[i]);
+    }
+    provider->destroyMaterials();
+    EXPECT_EQ(provider->getMaterialsCount(), 0);
+    delete provider;
+}
+
+TEST_F(JitShaderProviderTest, PendingMaterialsAreDestroyed) { // NOLINT
+    // The materials are never requested, so the provider must wait for their jobs on destruction.
+    const char* const labels[kMaterialCount] = { nullptr, nullptr, nullptr };
+    auto const configs = createConfigs();
+    MaterialProvider* provider = createJitShaderProvider(mEngine, false, mCacheDirectory.c_str());
+    provider->prepareMaterials(configs.data(), labels, kMaterialCount);
+    EXPECT_EQ(provider->getMaterialsCount(), 0);
+    provider->destroyMaterials();
+    delete provider;
+}
+
+TEST_F(JitShaderProviderTest, ReloadFromDiskCache) { // NOLINT
+    const char* const first[kMaterialCount] = { "first0", "first1", "first2" };
+    MaterialProvider* provider = createJitShaderProvider(mEngine, false, mCacheDirectory.c_str());
+    prepareAndGet(provider, first);
+    provider->destroyMaterials();
+    delete provider;
+
+    // The label is not a part of the cache key, so materials that are read back from the disk
+    // cache keep the names they were first built with.
+    const char* const second[kMaterialCount] = { "second0", "second1", "second2" };
+    provider = createJitShaderProvider(mEngine, false, mCacheDirectory.c_str());
+    auto const names = prepareAndGet(provider, second);
+    for (size_t i = 0; i < kMaterialCount; i++) {
+        EXPECT_EQ(names[i], first[i]);
+    }
+    provider->destroyMaterials();
+    delete provider;
+
+    // Without a cache, materials are built again.
+    provider = createJitShaderProvider(mEngine, false);
+    auto const rebuilt = prepareAndGet(provider, second);
+    for (size_t i = 0; i < kMaterialCount; i++) {
+        EXPECT_EQ(rebuilt[i], second[i]);
+    }
+    provider->destroyMaterials();
+    delete provider;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "OptimizeMeshJob.h"
+
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <array>
+#include <set>
+#include <vector>
+
+using namespace filament;
+using namespace filament::gltfio;
+using namespace filament::math;
+
+namespace {
+
+// A flat grid of quads, stored in a single buffer as a cgltf primitive with positions and indices.
+class GridPrimitive {
+public:
+    explicit GridPrimitive(uint32_t quadsPerSide) {
+        const uint32_t side = quadsPerSide + 1;
+        for (uint32_t y = 0; y < side; y++) {
+            for (uint32_t x = 0; x < side; x++) {
+                mPositions.push_back(float3(x, y, 0));
+            }
+        }
+        for (uint32_t y = 0; y < quadsPerSide; y++) {
+            for (uint32_t x = 0; x < quadsPerSide; x++) {
+                const uint32_t i = y * side + x;
+                mIndices.insert(mIndices.end(), { i, i + 1, i + side, i + 1, i + side + 1, i + side });
+            }
+        }
+
+        const size_t positionsSize = mPositions.size() * sizeof(float3);
+        const size_t indicesSize = mIndices.size() * sizeof(uint32_t);
+        mData.resize(positionsSize + indicesSize);
+        memcpy(mData.data(), mPositions.data(), positionsSize);
+        memcpy(mData.data() + positionsSize, mIndices.data(), indicesSize);
+
+        mBuffer.size = mData.size();
+        mBuffer.data = mData.data();
+
+        mViews[0].buffer = &mBuffer;
+        mViews[0].size = positionsSize;
+        mViews[1].buffer = &mBuffer;
+        mViews[1].offset = positionsSize;
+        mViews[1].size = indicesSize;
+
+        mPositionsAccessor.component_type = cgltf_component_type_r_32f;
+        mPositionsAccessor.type = cgltf_type_vec3;
+        mPositionsAccessor.count = mPositions.size();
+        mPositionsAccessor.stride = sizeof(float3);
+        mPositionsAccessor.buffer_view = &mViews[0];
+
+        mIndicesAccessor.component_type = cgltf_component_type_r_32u;
+        mIndicesAccessor.type = cgltf_type_scalar;
+        mIndicesAccessor.count = mIndices.size();
+        mIndicesAccessor.stride = sizeof(uint32_t);
+        mIndicesAccessor.buffer_view = &mViews[1];
+
+        mAttribute.type = cgltf_attribute_type_position;
+        mAttribute.data = &mPositionsAccessor;
+
+        mPrimitive.type = cgltf_primitive_type_triangles;
+        mPrimitive.indices = &mIndicesAccessor;
+        mPrimitive.attributes = &mAttribute;
+        mPrimitive.attributes_count = 1;
+    }
+
+    cgltf_primitive* getPrimitive() noexcept { return &mPrimitive; }
+
+    size_t getIndexCount() const noexcept { return mIndices.size(); }
+
+    // Returns the triangles of the primitive, as sorted sets of vertex positions.
+    std::multiset<std::array<float, 9>> getTriangles() const noexcept {
+        const float3* positions = (const float3*) mData.data();
+        const uint32_t* indices = (const uint32_t*) (mData.data() + mViews[1].offset);
+        std::multiset<std::array<float, 9>> triangles;
+        for (size_t i = 0; i < mIndices.size(); i += 3) {
+            std::array<float3, 3> corners = { positions[indices[i]], positions[indices[i + 1]],
+                    positions[indices[i + 2]] };
+            std::sort(corners.begin(), corners.end(), [](float3 a, float3 b) {
+                return a.x != b.x ? a.x < b.x : a.y < b.y;
+            });
+            std::array<float, 9> triangle{};
+            for (size_t c = 0; c < 3; c++) {
+                triangle[c * 3 + 0] = corners[c].x;
+                triangle[c * 3 + 1] = corners[c].y;
+                triangle[c * 3 + 2] = corners[c].z;
+            }
+            triangles.insert(triangle);
+        }
+        return triangles;
+    }
+
+    const uint32_t* getIndices() const noexcept {
+        return (const uint32_t*) (mData.data() + mViews[1].offset);
+    }
+
+private:
+    std::vector<float3> mPositions;
+    std::vector<uint32_t> mIndices;
+    std::vector<uint8_t> mData;
+    cgltf_buffer mBuffer{};
+    cgltf_buffer_view mViews[2]{};
+    cgltf_accessor mPositionsAccessor{};
+    cgltf_accessor mIndicesAccessor{};
+    cgltf_attribute mAttribute{};
+    cgltf_primitive mPrimitive{};
+};
+
+} // anonymous namespace
+
+TEST(OptimizeMeshJob, MeshletLimits) {
+    GridPrimitive grid(32);
+    const auto trianglesBefore = grid.getTriangles();
+
+    OptimizeMeshJob::Params params{{ grid.getPrimitive() }};
+    OptimizeMeshJob::run(&params);
+
+    const auto& meshlets = params.out.meshlets;
+    ASSERT_GT(meshlets.size(), 1u);
+
+    // Meshlets tile the index buffer and respect the vertex and triangle limits.
+    const uint32_t* indices = grid.getIndices();
+    uint32_t offset = 0;
+    for (const Meshlet& meshlet : meshlets) {
+        EXPECT_EQ(meshlet.indexOffset, offset);
+        EXPECT_EQ(meshlet.indexCount % 3, 0u);
+        EXPECT_LE(meshlet.indexCount, OptimizeMeshJob::kMaxMeshletTriangles * 3);
+        const std::set<uint32_t> vertices(indices + meshlet.indexOffset,
+                indices + meshlet.indexOffset + meshlet.indexCount);
+        EXPECT_LE(vertices.size(), OptimizeMeshJob::kMaxMeshletVertices);
+        EXPECT_GT(meshlet.radius, 0.0f);
+        offset += meshlet.indexCount;
+    }
+    EXPECT_EQ(offset, grid.getIndexCount());
+
+    // Vertices and indices are permuted, but the geometry is unchanged.
+    EXPECT_EQ(grid.getTriangles(), trianglesBefore);
+}
+
+TEST(OptimizeMeshJob, SkipsNonTriangleLists) {
+    GridPrimitive grid(4);
+    grid.getPrimitive()->indices->count -= 1;
+
+    OptimizeMeshJob::Params params{{ grid.getPrimitive() }};
+    OptimizeMeshJob::run(&params);
+    EXPECT_TRUE(params.out.meshlets.empty());
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/vec3.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+using namespace utils;
+
+// Creates a mip chain from a procedural environment with a few bright spots, which is
+// representative of the HDR inputs that cmgen prefilters.
+static void createEnvironment(JobSystem& js, size_t dim,
+        std::vector<Cubemap>& levels, std::vector<Image>& images) {
+    Image temp;
+    Cubemap cm = CubemapUtils::create(temp, dim);
+    for (size_t f = 0; f < 6; f++) {
+        const Cubemap::Face face = Cubemap::Face(f);
+        Image& image = cm.getImageForFace(face);
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                const float3 d = cm.getDirectionFor(face, x, y);
+                Cubemap::writeAt(image.getPixelRef(x, y), {
+                        0.5f + 0.5f * std::sin(d.x * 9.0f),
+                        0.5f + 0.5f * std::cos(d.y * 13.0f),
+                        d.z > 0.9f ? 20.0f : 0.1f });
+            }
+        }
+    }
+    cm.makeSeamless();
+    images.push_back(std::move(temp));
+    levels.push_back(std::move(cm));
+
+    while (dim > 1) {
+        dim >>= 1u;
+        Cubemap dst = CubemapUtils::create(temp, dim);
+        CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, levels.back());
+        dst.makeSeamless();
+        images.push_back(std::move(temp));
+        levels.push_back(std::move(dst));
+    }
+}
+
+// Arguments are the output dimension and the number of samples per texel.
+static void BM_roughnessFilter(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    std::vector<Cubemap> levels;
+    std::vector<Image> images;
+    createEnvironment(js, 256, levels, images);
+
+    const size_t dim = size_t(state.range(0));
+    const size_t numSamples = size_t(state.range(1));
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, dim);
+
+    for (auto _ : state) {
+        CubemapIBL::roughnessFilter(js, dst, levels, 0.5f, numSamples, float3{ 1, 1, 1 }, true);
+        benchmark::DoNotOptimize(image.getData());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * 6 * dim * dim));
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_roughnessFilter)
+        ->Args({ 64, 256 })
+        ->Args({ 128, 1024 })
+        ->Args({ 256, 1024 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+// Same as above with a precomputed sample table, which is how the runtime prefilters environments
+// (see Texture::generatePrefilterMipmap). Small sample counts are typical there.
+static void BM_roughnessFilterSampleTable(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    std::vector<Cubemap> levels;
+    std::vector<Image> images;
+    createEnvironment(js, 256, levels, images);
+
+    const size_t dim = size_t(state.range(0));
+    const size_t numSamples = size_t(state.range(1));
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, dim);
+    const CubemapIBL::SampleTable table = CubemapIBL::SampleTable::create(
+            0.5f, numSamples, levels[0].getDimensions(), levels.size(), true);
+
+    for (auto _ : state) {
+        CubemapIBL::roughnessFilter(js, dst, { levels.data(), uint32_t(levels.size()) },
+                table, float3{ 1, 1, 1 });
+        benchmark::DoNotOptimize(image.getData());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * 6 * dim * dim));
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_roughnessFilterSampleTable)
+        ->Args({ 128, 8 })
+        ->Args({ 256, 8 })
+        ->Args({ 256, 32 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+// Arguments are the cubemap dimension and the number of SH bands.
+static void BM_computeSH(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    std::vector<Cubemap> levels;
+    std::vector<Image> images;
+    const size_t dim = size_t(state.range(0));
+    createEnvironment(js, dim, levels, images);
+
+    const size_t numBands = size_t(state.range(1));
+    for (auto _ : state) {
+        auto sh = CubemapSH::computeSH(js, levels[0], numBands, true);
+        benchmark::DoNotOptimize(sh.get());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * 6 * dim * dim));
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_computeSH)
+        ->Args({ 256, 3 })
+        ->Args({ 256, 5 })
+        ->Args({ 1024, 3 })
+        ->Args({ 1024, 5 })
+        ->Args({ 2048, 3 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
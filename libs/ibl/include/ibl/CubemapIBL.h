@@ -44,6 +44,63 @@ class UTILS_PUBLIC CubemapIBL {
 public:
     typedef void (*Progress)(size_t, float, void*);
 
+    /**
+     * Importance samples of the GGX lobe used by roughnessFilter().
+     *
+     * A table only depends on the roughness, the sample count and the shape of the source mip
+     * chain, so it can be computed once and reused for every environment of the same size, or
+     * baked offline and loaded with deserialize().
+     */
+    class UTILS_PUBLIC SampleTable {
+    public:
+        //! Version of the serialized format, bumped whenever the format or the sampling changes.
+        static constexpr uint32_t VERSION = 1;
+
+        SampleTable() noexcept = default;
+
+        /**
+         * Computes the importance samples for the given roughness.
+         *
+         * @param linearRoughness   roughness, zero results in a table that samples the base level
+         * @param maxNumSamples     number of samples to draw, samples below the horizon are dropped
+         * @param baseDimension     dimension of the base level of the source environment
+         * @param levelCount        number of prefiltered lods of the source environment
+         * @param prefilter         whether to use prefiltered importance sampling
+         */
+        static SampleTable create(float linearRoughness, size_t maxNumSamples,
+                size_t baseDimension, size_t levelCount, bool prefilter);
+
+        //! Returns false for default-constructed tables and tables that failed to deserialize.
+        bool isValid() const noexcept { return mLevelCount != 0; }
+
+        size_t getSampleCount() const noexcept { return mSamples.size(); }
+        size_t getBaseDimension() const noexcept { return mBaseDimension; }
+        size_t getLevelCount() const noexcept { return mLevelCount; }
+
+        //! Serializes the table to a compact blob, in the byte order of the host.
+        std::vector<uint8_t> serialize() const;
+
+        //! Returns an invalid table if the blob is malformed or has a different VERSION.
+        static SampleTable deserialize(void const* data, size_t size);
+
+    private:
+        friend class CubemapIBL;
+
+        // be careful w/ the size of this structure, the smaller the better
+        struct Sample {
+            math::float3 L;
+            float brdf_NoL;
+            float lerp;
+            uint8_t l0;
+            uint8_t l1;
+        };
+
+        std::vector<Sample> mSamples;
+        float mLinearRoughness = 0.0f;
+        uint32_t mBaseDimension = 0;
+        uint32_t mLevelCount = 0;
+    };
+
     /**
      * Computes a roughness LOD using prefiltered importance sampling GGX
      *
@@ -63,6 +120,20 @@ public:
             float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
             Progress updater = nullptr, void* userdata = nullptr);
 
+    /**
+     * Computes a roughness LOD using a precomputed table of importance samples
+     *
+     * @param dst               the destination cubemap
+     * @param levels            a list of prefiltered lods of the source environment, which must
+     *                          match the base dimension and level count of the table
+     * @param samples           the importance samples, see SampleTable::create()
+     * @param updater           a callback for the caller to track progress
+     */
+    static void roughnessFilter(
+            utils::JobSystem& js, Cubemap& dst, const utils::Slice<Cubemap>& levels,
+            const SampleTable& samples, math::float3 mirror,
+            Progress updater = nullptr, void* userdata = nullptr);
+
     //! Computes the "DFG" term of the "split-sum" approximation and stores it in a 2D image
     static void DFG(utils::JobSystem& js, Image& dst, bool multiscatter, bool cloth);
 
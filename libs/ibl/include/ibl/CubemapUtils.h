@@ -48,6 +48,10 @@ public:
     using ScanlineProc = std::function<
             void(STATE& state, size_t y, Cubemap::Face f, Cubemap::Texel* data, size_t width)>;
 
+    template<typename STATE>
+    using SpanProc = std::function<void(STATE& state, size_t x, size_t y, Cubemap::Face f,
+            Cubemap::Texel* data, size_t width)>;
+
     template<typename STATE>
     using ReduceProc = std::function<void(STATE& state)>;
 
@@ -59,6 +63,27 @@ public:
             ReduceProc<STATE> reduce = [](STATE&) {},
             const STATE& prototype = STATE());
 
+    /**
+     * Process the cubemap using multithreading, visiting each face in square tiles.
+     *
+     * This is better suited than process() to filters that gather many samples around the
+     * direction of each texel, because the texels of a tile map to a small solid angle and
+     * therefore read from a small region of the source. Each job processes a horizontal band of
+     * tiles with its own copy of the prototype state. Bands are reduced in order, so the result
+     * doesn't depend on scheduling. The tile size is reduced for small cubemaps, so that there are
+     * enough bands to keep all threads busy.
+     *
+     * The proc is called for each tile row, data points to the texel at (x, y) and width is the
+     * number of texels to process.
+     */
+    template<typename STATE>
+    static void processTiled(Cubemap& cm,
+            utils::JobSystem& js,
+            SpanProc<STATE> proc,
+            ReduceProc<STATE> reduce = [](STATE&) {},
+            const STATE& prototype = STATE(),
+            size_t tileSize = 32);
+
     //! process the cubemap
     template<typename STATE>
     static void processSingleThreaded(Cubemap& cm,
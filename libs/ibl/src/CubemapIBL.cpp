@@ -24,13 +24,17 @@
 #include "CubemapUtilsImpl.h"
 
 #include <utils/JobSystem.h>
+#include <utils/debug.h>
 
 #include <math/mat3.h>
 #include <math/scalar.h>
 
-#include <random>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
+#include <string.h>
+
 using namespace filament::math;
 using namespace utils;
 
@@ -292,6 +296,18 @@ static float UTILS_UNUSED VisibilityAshikhmin(float NoV, float NoL, float /*a*/)
  *
  */
 
+// Returns a pseudo-random rotation angle in [-pi, pi] for the given texel, used to decorrelate
+// the sampling pattern of neighboring texels (maybe blue-noise instead would look even better).
+// Hashing the texel address rather than drawing from a random engine keeps the output independent
+// of the order in which texels are processed.
+static float randomAngle(Cubemap::Face f, size_t x, size_t y) {
+    uint32_t h = uint32_t(f) * 0x9E3779B9u ^ uint32_t(y) * 0x85EBCA6Bu ^ uint32_t(x) * 0xC2B2AE35u;
+    h = (h ^ (h >> 16u)) * 0x7FEB352Du;
+    h = (h ^ (h >> 15u)) * 0x846CA68Bu;
+    h = h ^ (h >> 16u);
+    return float(h >> 8u) * (2.0f * (float) F_PI / 16777216.0f) - (float) F_PI;
+}
+
 UTILS_ALWAYS_INLINE
 void CubemapIBL::roughnessFilter(
         utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
@@ -304,53 +320,32 @@ void CubemapIBL::roughnessFilter(
 void CubemapIBL::roughnessFilter(
         utils::JobSystem& js, Cubemap& dst, const utils::Slice<Cubemap>& levels,
         float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
-        Progress updater, void* userdata)
-{
-    const float numSamples = maxNumSamples;
-    const float inumSamples = 1.0f / numSamples;
-    const size_t maxLevel = levels.size()-1;
-    const float maxLevelf = maxLevel;
-    const Cubemap& base(levels[0]);
-    const size_t dim0 = base.getDimensions();
-    const float omegaP = (4.0f * (float) F_PI) / float(6 * dim0 * dim0);
-    std::atomic_uint progress = {0};
+        Progress updater, void* userdata) {
+    roughnessFilter(js, dst, levels,
+            SampleTable::create(linearRoughness, maxNumSamples, levels[0].getDimensions(),
+                    levels.size(), prefilter),
+            mirror, updater, userdata);
+}
 
+CubemapIBL::SampleTable CubemapIBL::SampleTable::create(float linearRoughness,
+        size_t maxNumSamples, size_t baseDimension, size_t levelCount, bool prefilter) {
+    SampleTable table;
+    table.mLinearRoughness = linearRoughness;
+    table.mBaseDimension = uint32_t(baseDimension);
+    table.mLevelCount = uint32_t(levelCount);
     if (linearRoughness == 0) {
-        auto scanline = [&]
-                (CubemapUtils::EmptyState&, size_t y, Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
-                    if (UTILS_UNLIKELY(updater)) {
-                        size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-                        updater(0, (float)p / ((float) dim * 6.0f), userdata);
-                    }
-                    const Cubemap& cm = levels[0];
-                    for (size_t x = 0; x < dim; ++x, ++data) {
-                        const float2 p(Cubemap::center(x, y));
-                        const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
-                        // FIXME: we should pick the proper LOD here and do trilinear filtering
-                        Cubemap::writeAt(data, cm.sampleAt(N));
-                    }
-        };
-        // at least 256 pixel cubemap before we use multithreading -- the overhead of launching
-        // jobs is too large compared to the work above.
-        if (dst.getDimensions() <= 256) {
-            CubemapUtils::processSingleThreaded<CubemapUtils::EmptyState>(
-                    dst, js, std::ref(scanline));
-        } else {
-            CubemapUtils::process<CubemapUtils::EmptyState>(dst, js, std::ref(scanline));
-        }
-        return;
+        // the base level is sampled directly, see roughnessFilter()
+        return table;
     }
 
-    // be careful w/ the size of this structure, the smaller the better
-    struct CacheEntry {
-        float3 L;
-        float brdf_NoL;
-        float lerp;
-        uint8_t l0;
-        uint8_t l1;
-    };
+    const float numSamples = maxNumSamples;
+    const float inumSamples = 1.0f / numSamples;
+    const size_t maxLevel = levelCount - 1;
+    const float maxLevelf = maxLevel;
+    const size_t dim0 = baseDimension;
+    const float omegaP = (4.0f * (float) F_PI) / float(6 * dim0 * dim0);
 
-    std::vector<CacheEntry> cache;
+    std::vector<Sample>& cache = table.mSamples;
     cache.reserve(maxNumSamples);
 
     // precompute everything that only depends on the sample #
@@ -411,56 +406,237 @@ void CubemapIBL::roughnessFilter(
     }
 
     // we can sample the cubemap in any order, sort by the weight, it could improve fp precision
-    std::sort(cache.begin(), cache.end(), [](CacheEntry const& lhs, CacheEntry const& rhs) {
+    std::sort(cache.begin(), cache.end(), [](Sample const& lhs, Sample const& rhs) {
         return lhs.brdf_NoL < rhs.brdf_NoL;
     });
 
+    return table;
+}
+
+namespace {
+
+// Layout of a serialized SampleTable, all fields are in host byte order.
+constexpr uint32_t kSampleTableMagic = 0x54534249; // "IBST"
+
+struct SampleTableHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sampleCount;
+    uint32_t baseDimension;
+    uint32_t levelCount;
+    float linearRoughness;
+};
+
+// L, brdf_NoL and lerp as floats, followed by l0 and l1
+constexpr size_t kSerializedSampleSize = 5 * sizeof(float) + 2;
+
+} // anonymous namespace
+
+std::vector<uint8_t> CubemapIBL::SampleTable::serialize() const {
+    const SampleTableHeader header{ kSampleTableMagic, VERSION, uint32_t(mSamples.size()),
+            mBaseDimension, mLevelCount, mLinearRoughness };
+    std::vector<uint8_t> blob(sizeof(header) + mSamples.size() * kSerializedSampleSize);
+    uint8_t* p = blob.data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (Sample const& sample : mSamples) {
+        const float values[5] = { sample.L.x, sample.L.y, sample.L.z, sample.brdf_NoL, sample.lerp };
+        memcpy(p, values, sizeof(values));
+        p[sizeof(values) + 0] = sample.l0;
+        p[sizeof(values) + 1] = sample.l1;
+        p += kSerializedSampleSize;
+    }
+    return blob;
+}
+
+CubemapIBL::SampleTable CubemapIBL::SampleTable::deserialize(void const* data, size_t size) {
+    SampleTableHeader header{};
+    if (size < sizeof(header)) {
+        return {};
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != kSampleTableMagic || header.version != VERSION ||
+            header.levelCount == 0 || header.levelCount > 256 ||
+            size != sizeof(header) + size_t(header.sampleCount) * kSerializedSampleSize) {
+        return {};
+    }
+
+    SampleTable table;
+    table.mLinearRoughness = header.linearRoughness;
+    table.mBaseDimension = header.baseDimension;
+    table.mLevelCount = header.levelCount;
+    table.mSamples.resize(header.sampleCount);
+    uint8_t const* p = static_cast<uint8_t const*>(data) + sizeof(header);
+    for (Sample& sample : table.mSamples) {
+        float values[5];
+        memcpy(values, p, sizeof(values));
+        sample = { { values[0], values[1], values[2] }, values[3], values[4],
+                p[sizeof(values) + 0], p[sizeof(values) + 1] };
+        if (sample.l0 >= header.levelCount || sample.l1 >= header.levelCount) {
+            return {};
+        }
+        p += kSerializedSampleSize;
+    }
+    return table;
+}
+
+void CubemapIBL::roughnessFilter(
+        utils::JobSystem& js, Cubemap& dst, const utils::Slice<Cubemap>& levels,
+        const SampleTable& samples, math::float3 mirror,
+        Progress updater, void* userdata)
+{
+    assert_invariant(samples.isValid());
+    assert_invariant(samples.getBaseDimension() == levels[0].getDimensions());
+    assert_invariant(samples.getLevelCount() == levels.size());
+
+    const size_t maxNumSamples = samples.getSampleCount();
+    std::atomic_uint progress = {0};
 
-    struct State {
-        // maybe blue-noise instead would look even better
-        std::default_random_engine gen;
-        std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
+    if (samples.mLinearRoughness == 0) {
+        auto scanline = [&]
+                (CubemapUtils::EmptyState&, size_t y, Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
+                    if (UTILS_UNLIKELY(updater)) {
+                        size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
+                        updater(0, (float)p / ((float) dim * 6.0f), userdata);
+                    }
+                    const Cubemap& cm = levels[0];
+                    for (size_t x = 0; x < dim; ++x, ++data) {
+                        const float2 p(Cubemap::center(x, y));
+                        const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+                        // FIXME: we should pick the proper LOD here and do trilinear filtering
+                        Cubemap::writeAt(data, cm.sampleAt(N));
+                    }
+        };
+        // at least 256 pixel cubemap before we use multithreading -- the overhead of launching
+        // jobs is too large compared to the work above.
+        if (dst.getDimensions() <= 256) {
+            CubemapUtils::processSingleThreaded<CubemapUtils::EmptyState>(
+                    dst, js, std::ref(scanline));
+        } else {
+            CubemapUtils::process<CubemapUtils::EmptyState>(dst, js, std::ref(scanline));
+        }
+        return;
+    }
+
+    std::vector<SampleTable::Sample> const& cache = samples.mSamples;
+
+    // Per-level constants needed to address the faces of each cubemap, so that the kernel below
+    // doesn't need to go through Cubemap's accessors for every sample.
+    struct LevelInfo {
+        float dim;
+        float upperBound;
+        Image const* faces[6];
     };
+    std::vector<LevelInfo> levelInfos(levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        const size_t dim = levels[i].getDimensions();
+        levelInfos[i].dim = float(dim);
+        levelInfos[i].upperBound = std::nextafter(float(dim), 0.0f);
+        for (size_t face = 0; face < 6; face++) {
+            levelInfos[i].faces[face] = &levels[i].getImageForFace(Cubemap::Face(face));
+        }
+    }
 
-    auto scanline = [&](State& state, size_t y,
-            Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
+    // Texels of a span are filtered kBatchSize at a time. All the per-texel math is laid out
+    // as structures of arrays, so the compiler can vectorize the loops over the batch: rotating the
+    // sample direction, selecting the cubemap face and computing the texture coordinates. Only the
+    // texel fetches remain scalar.
+    constexpr size_t kBatchSize = 8;
+
+    const float totalTexels = float(dst.getDimensions() * dst.getDimensions() * 6);
+    auto span = [&](CubemapUtils::EmptyState&, size_t x, size_t y,
+            Cubemap::Face f, Cubemap::Texel* data, size_t width) {
         if (UTILS_UNLIKELY(updater)) {
-            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-            updater(0, (float) p / ((float) dim * 6.0f), userdata);
+            size_t p = progress.fetch_add(width, std::memory_order_relaxed) + width;
+            updater(0, (float) p / totalTexels, userdata);
         }
-        mat3 R;
         const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+        for (size_t x0 = x; x0 < x + width; x0 += kBatchSize) {
+            const size_t count = std::min(kBatchSize, x + width - x0);
+
+            // rotation matrix of each texel, columns in SoA form
+            float r[9][kBatchSize] = {};
+            for (size_t i = 0; i < count; i++) {
+                const float2 p(Cubemap::center(x0 + i, y));
+                const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+
+                // center the cone around the normal (handle case of normal close to up), then
+                // rotate the tangent frame around the normal, which is the same as multiplying
+                // by mat3::rotation(angle, {0, 0, 1}) without building the matrix.
+                mat3 R;
+                const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                const double3 T = normalize(cross(up, N));
+                const double3 B = cross(N, T);
+                const double angle = randomAngle(f, x0 + i, y);
+                const double cs = std::cos(angle);
+                const double sn = std::sin(angle);
+                R[0] = T * cs + B * sn;
+                R[1] = B * cs - T * sn;
+                R[2] = N;
+
+                for (size_t c = 0; c < 3; c++) {
+                    r[c * 3 + 0][i] = float(R[c].x);
+                    r[c * 3 + 1][i] = float(R[c].y);
+                    r[c * 3 + 2][i] = float(R[c].z);
+                }
+            }
 
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
+            float li[3][kBatchSize] = {};
+            for (size_t sample = 0; sample < numSamples; sample++) {
+                const SampleTable::Sample& e = cache[sample];
+                const LevelInfo& level0 = levelInfos[e.l0];
+                const LevelInfo& level1 = levelInfos[e.l1];
+
+                // this is the batched equivalent of Cubemap::getAddressFor()
+                uint8_t face[kBatchSize];
+                float s[kBatchSize];
+                float t[kBatchSize];
+                for (size_t i = 0; i < kBatchSize; i++) {
+                    const float lx = r[0][i] * e.L.x + r[3][i] * e.L.y + r[6][i] * e.L.z;
+                    const float ly = r[1][i] * e.L.x + r[4][i] * e.L.y + r[7][i] * e.L.z;
+                    const float lz = r[2][i] * e.L.x + r[5][i] * e.L.y + r[8][i] * e.L.z;
+                    const float ax = std::abs(lx);
+                    const float ay = std::abs(ly);
+                    const float az = std::abs(lz);
+                    const bool isX = ax >= ay && ax >= az;
+                    const bool isY = !isX && ay >= ax && ay >= az;
+                    const float ma = isX ? ax : (isY ? ay : az);
+                    const float sc = isX ? (lx >= 0 ? -lz : lz) : (isY || lz >= 0 ? lx : -lx);
+                    const float tc = isY ? (ly >= 0 ? lz : -lz) : -ly;
+                    face[i] = isX ? (lx >= 0 ? 0 : 1) : (isY ? (ly >= 0 ? 2 : 3) : (lz >= 0 ? 4 : 5));
+                    s[i] = (sc * (1.0f / ma) + 1.0f) * 0.5f;
+                    t[i] = (tc * (1.0f / ma) + 1.0f) * 0.5f;
+                }
 
-            R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
+                for (size_t i = 0; i < count; i++) {
+                    const float u0 = std::min(s[i] * level0.dim, level0.upperBound);
+                    const float v0 = std::min(t[i] * level0.dim, level0.upperBound);
+                    const float u1 = std::min(s[i] * level1.dim, level1.upperBound);
+                    const float v1 = std::min(t[i] * level1.dim, level1.upperBound);
+                    float3 c = Cubemap::filterAt(*level0.faces[face[i]], u0, v0);
+                    c += e.lerp * (Cubemap::filterAt(*level1.faces[face[i]], u1, v1) - c);
+                    li[0][i] += c.r * e.brdf_NoL;
+                    li[1][i] += c.g * e.brdf_NoL;
+                    li[2][i] += c.b * e.brdf_NoL;
+                }
+            }
 
-            float3 Li = 0;
-            for (size_t sample = 0; sample < numSamples; sample++) {
-                const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
-                const Cubemap& cmBase = levels[e.l0];
-                const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0 * e.brdf_NoL;
+            for (size_t i = 0; i < count; i++, ++data) {
+                Cubemap::writeAt(data, Cubemap::Texel(li[0][i], li[1][i], li[2][i]));
             }
-            Cubemap::writeAt(data, Cubemap::Texel(Li));
         }
     };
 
     // don't use the jobsystem unless we have enough work per scanline -- or the overhead of
     // launching jobs will prevail.
     if (dst.getDimensions() * maxNumSamples <= 256) {
-        CubemapUtils::processSingleThreaded<State>(dst, js, std::ref(scanline));
+        CubemapUtils::processSingleThreaded<CubemapUtils::EmptyState>(dst, js,
+                [&](CubemapUtils::EmptyState& state, size_t y,
+                        Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
+                    span(state, 0, y, f, data, dim);
+                });
     } else {
-        CubemapUtils::process<State>(dst, js, std::ref(scanline));
+        CubemapUtils::processTiled<CubemapUtils::EmptyState>(dst, js, std::ref(span));
     }
 }
 
@@ -598,18 +774,19 @@ void CubemapIBL::diffuseIrradiance(JobSystem& js, Cubemap& dst, const std::vecto
         }
     }
 
-    CubemapUtils::process<CubemapUtils::EmptyState>(dst, js,
-            [&](CubemapUtils::EmptyState&, size_t y,
-                    Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
+    const float totalTexels = float(dst.getDimensions() * dst.getDimensions() * 6);
+    CubemapUtils::processTiled<CubemapUtils::EmptyState>(dst, js,
+            [&](CubemapUtils::EmptyState&, size_t x0, size_t y,
+                    Cubemap::Face f, Cubemap::Texel* data, size_t width) {
 
         if (updater) {
-            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-            updater(0, (float)p / ((float) dim * 6.0f), userdata);
+            size_t p = progress.fetch_add(width, std::memory_order_relaxed) + width;
+            updater(0, (float)p / totalTexels, userdata);
         }
 
         mat3 R;
         const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
+        for (size_t x = x0; x < x0 + width; ++x, ++data) {
             const float2 p(Cubemap::center(x, y));
             const float3 N(dst.getDirectionFor(f, p.x, p.y));
 
@@ -27,9 +27,12 @@
 
 #include <math/mat4.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <limits>
 #include <iomanip>
+#include <vector>
 
 using namespace filament::math;
 using namespace utils;
@@ -508,50 +511,207 @@ void CubemapSH::windowSH(std::unique_ptr<float3[]>& sh, size_t numBands, float c
     }
 }
 
+// Number of texels processed together by computeSH(). All per-texel data is stored as arrays of
+// this many lanes, which lets the compiler vectorize the SH basis evaluation and accumulation.
+static constexpr size_t kShBatchSize = 8;
+
+// Number of scanlines accumulated by a single job in computeSH(). This is fixed, rather than
+// derived from the thread count, so that partial sums are always reduced in the same order.
+static constexpr size_t kShRowsPerJob = 8;
+
+/*
+ * Batched version of computeShBasis(), evaluates the basis for kShBatchSize directions at once.
+ * SHb holds numCoefs rows of kShBatchSize lanes. See computeShBasis() for an explanation of the
+ * recursions below.
+ */
+static void computeShBasisBatch(
+        float* UTILS_RESTRICT SHb,
+        size_t numBands,
+        float const* UTILS_RESTRICT sx,
+        float const* UTILS_RESTRICT sy,
+        float const* UTILS_RESTRICT sz)
+{
+    constexpr size_t N = kShBatchSize;
+    auto row = [SHb](ssize_t m, size_t l) { return SHb + CubemapSH::getShIndex(m, l) * N; };
+
+    float Pml_2[N];
+    float Pml_1[N];
+
+    // handle m=0 separately, since it produces only one coefficient
+    for (size_t i = 0; i < N; i++) {
+        Pml_2[i] = 0;
+        Pml_1[i] = 1;
+        row(0, 0)[i] = 1;
+    }
+    for (size_t l = 1; l < numBands; l++) {
+        float* UTILS_RESTRICT const dst = row(0, l);
+        for (size_t i = 0; i < N; i++) {
+            const float Pml = ((2*l-1.0f)*Pml_1[i]*sz[i] - (l-1.0f)*Pml_2[i]) / l;
+            Pml_2[i] = Pml_1[i];
+            Pml_1[i] = Pml;
+            dst[i] = Pml;
+        }
+    }
+
+    float Pmm = 1;
+    for (size_t m = 1; m < numBands; m++) {
+        Pmm = (1.0f - 2*m) * Pmm;
+        for (size_t i = 0; i < N; i++) {
+            Pml_2[i] = Pmm;
+            Pml_1[i] = (2*m + 1.0f)*Pmm*sz[i];
+            row(-m, m)[i] = Pmm;
+            row( m, m)[i] = Pmm;
+        }
+        if (m+1 < numBands) {
+            for (size_t i = 0; i < N; i++) {
+                row(-m, m+1)[i] = Pml_1[i];
+                row( m, m+1)[i] = Pml_1[i];
+            }
+            for (size_t l = m+2; l < numBands; l++) {
+                float* UTILS_RESTRICT const dstN = row(-m, l);
+                float* UTILS_RESTRICT const dstP = row( m, l);
+                for (size_t i = 0; i < N; i++) {
+                    const float Pml = ((2*l - 1.0f)*Pml_1[i]*sz[i] - (l + m - 1.0f)*Pml_2[i]) / (l-m);
+                    Pml_2[i] = Pml_1[i];
+                    Pml_1[i] = Pml;
+                    dstN[i] = Pml;
+                    dstP[i] = Pml;
+                }
+            }
+        }
+    }
+
+    float Cm[N];
+    float Sm[N];
+    for (size_t i = 0; i < N; i++) {
+        Cm[i] = sx[i];
+        Sm[i] = sy[i];
+    }
+    for (size_t m = 1; m <= numBands; m++) {
+        for (size_t l = m; l < numBands; l++) {
+            float* UTILS_RESTRICT const dstN = row(-m, l);
+            float* UTILS_RESTRICT const dstP = row( m, l);
+            for (size_t i = 0; i < N; i++) {
+                dstN[i] *= Sm[i];
+                dstP[i] *= Cm[i];
+            }
+        }
+        for (size_t i = 0; i < N; i++) {
+            const float Cm1 = Cm[i] * sx[i] - Sm[i] * sy[i];
+            const float Sm1 = Sm[i] * sx[i] + Cm[i] * sy[i];
+            Cm[i] = Cm1;
+            Sm[i] = Sm1;
+        }
+    }
+}
+
 std::unique_ptr<float3[]> CubemapSH::computeSH(JobSystem& js, const Cubemap& cm, size_t numBands, bool irradiance) {
+    constexpr size_t N = kShBatchSize;
 
     const size_t numCoefs = numBands * numBands;
     std::unique_ptr<float3[]> SH(new float3[numCoefs]{});
 
-    struct State {
-        State() = default;
-        explicit State(size_t numCoefs) : numCoefs(numCoefs) { }
+    const size_t dim = cm.getDimensions();
+    const float scale = 2.0f / float(dim);
 
-        State& operator=(State const & rhs) {
-            SH.reset(new float3[rhs.numCoefs]{}); // NOLINT(modernize-make-unique)
-            SHb.reset(new float[rhs.numCoefs]{}); // NOLINT(modernize-make-unique)
-            return *this;
+    // The solid angle of a texel only depends on its position within the face, and is symmetric
+    // about the center of the face, so we only need to compute one quadrant.
+    const size_t half = (dim + 1) / 2;
+    std::vector<float> solidAngles(half * half);
+    for (size_t y = 0; y < half; y++) {
+        for (size_t x = 0; x < half; x++) {
+            solidAngles[y * half + x] = CubemapUtils::solidAngle(dim, x, y);
         }
-        size_t numCoefs = 0;
-        std::unique_ptr<float3[]> SH;
-        std::unique_ptr<float[]> SHb;
-    } prototype(numCoefs);
-
-    CubemapUtils::process<State>(const_cast<Cubemap&>(cm), js,
-            [&](State& state, size_t y, Cubemap::Face f, Cubemap::Texel const* data, size_t dim) {
-        for (size_t x=0 ; x<dim ; ++x, ++data) {
-
-            float3 s(cm.getDirectionFor(f, x, y));
+    }
+    auto solidAngleAt = [&solidAngles, dim, half](size_t x, size_t y) {
+        x = x < half ? x : dim - 1 - x;
+        y = y < half ? y : dim - 1 - y;
+        return solidAngles[y * half + x];
+    };
 
-            // sample a color
-            float3 color(Cubemap::sampleAt(data));
+    // Each job accumulates a fixed band of scanlines into its own slot, the slots are then
+    // summed in order. This makes the result independent of the number of threads.
+    const size_t bandsPerFace = (dim + kShRowsPerJob - 1) / kShRowsPerJob;
+    const size_t bandCount = 6 * bandsPerFace;
+    std::vector<float3> partials(bandCount * numCoefs);
+
+    auto processBand = [&](size_t band) {
+        const Cubemap::Face f = Cubemap::Face(band / bandsPerFace);
+        const size_t y0 = (band % bandsPerFace) * kShRowsPerJob;
+        const size_t y1 = std::min(y0 + kShRowsPerJob, dim);
+        const Image& image = cm.getImageForFace(f);
+
+        std::vector<float> SHb(numCoefs * N);
+        std::vector<float> sum(numCoefs * N * 3);
+        float* UTILS_RESTRICT const sumR = sum.data();
+        float* UTILS_RESTRICT const sumG = sumR + numCoefs * N;
+        float* UTILS_RESTRICT const sumB = sumG + numCoefs * N;
+
+        for (size_t y = y0; y < y1; y++) {
+            const float cy = 1 - ((y + 0.5f) * scale);
+            for (size_t x0 = 0; x0 < dim; x0 += N) {
+                const size_t count = std::min(N, dim - x0);
+
+                // compute the direction and weighted color of each texel, unused lanes get a
+                // zero weight.
+                float sx[N], sy[N], sz[N];
+                float r[N] = {}, g[N] = {}, b[N] = {};
+                for (size_t i = 0; i < N; i++) {
+                    const float cx = ((x0 + i + 0.5f) * scale) - 1;
+                    const float il = 1 / std::sqrt(cx * cx + cy * cy + 1);
+                    switch (f) {
+                        case Cubemap::Face::PX: sx[i] =   1; sy[i] = cy; sz[i] = -cx; break;
+                        case Cubemap::Face::NX: sx[i] =  -1; sy[i] = cy; sz[i] =  cx; break;
+                        case Cubemap::Face::PY: sx[i] =  cx; sy[i] =  1; sz[i] = -cy; break;
+                        case Cubemap::Face::NY: sx[i] =  cx; sy[i] = -1; sz[i] =  cy; break;
+                        case Cubemap::Face::PZ: sx[i] =  cx; sy[i] = cy; sz[i] =   1; break;
+                        case Cubemap::Face::NZ: sx[i] = -cx; sy[i] = cy; sz[i] =  -1; break;
+                    }
+                    sx[i] *= il;
+                    sy[i] *= il;
+                    sz[i] *= il;
+                }
+                for (size_t i = 0; i < count; i++) {
+                    const float w = solidAngleAt(x0 + i, y);
+                    const float3 color(Cubemap::sampleAt(image.getPixelRef(x0 + i, y)));
+                    r[i] = color.r * w;
+                    g[i] = color.g * w;
+                    b[i] = color.b * w;
+                }
 
-            // take solid angle into account
-            color *= CubemapUtils::solidAngle(dim, x, y);
+                computeShBasisBatch(SHb.data(), numBands, sx, sy, sz);
 
-            computeShBasis(state.SHb.get(), numBands, s);
+                // apply coefficients to the sampled colors
+                for (size_t c = 0; c < numCoefs; c++) {
+                    float const* UTILS_RESTRICT const basis = SHb.data() + c * N;
+                    for (size_t i = 0; i < N; i++) {
+                        sumR[c * N + i] += r[i] * basis[i];
+                        sumG[c * N + i] += g[i] * basis[i];
+                        sumB[c * N + i] += b[i] * basis[i];
+                    }
+                }
+            }
+        }
 
-            // apply coefficients to the sampled color
-            for (size_t i=0 ; i<numCoefs ; i++) {
-                state.SH[i] += color * state.SHb[i];
+        float3* const partial = partials.data() + band * numCoefs;
+        for (size_t c = 0; c < numCoefs; c++) {
+            for (size_t i = 0; i < N; i++) {
+                partial[c] += float3{ sumR[c * N + i], sumG[c * N + i], sumB[c * N + i] };
             }
         }
-    },
-    [&](State& state) {
-        for (size_t i=0 ; i<numCoefs ; i++) {
-            SH[i] += state.SH[i];
+    };
+
+    JobSystem::Job* parent = js.createJob();
+    for (size_t band = 0; band < bandCount; band++) {
+        js.run(jobs::createJob(js, parent, [&processBand, band]() { processBand(band); }));
+    }
+    js.runAndWait(parent);
+
+    for (size_t band = 0; band < bandCount; band++) {
+        for (size_t c = 0; c < numCoefs; c++) {
+            SH[c] += partials[band * numCoefs + c];
         }
-    }, prototype);
+    }
 
     // precompute the scaling factor K
     std::vector<float> K = Ki(numBands);
@@ -587,11 +747,11 @@ void CubemapSH::renderSH(JobSystem& js, Cubemap& cm,
         float3 min = std::numeric_limits<float>::max();
     } prototype;
 
-    CubemapUtils::process<State>(cm, js,
-            [&](State& state, size_t y,
-                    Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
+    CubemapUtils::processTiled<State>(cm, js,
+            [&](State& state, size_t x0, size_t y,
+                    Cubemap::Face f, Cubemap::Texel* data, size_t width) {
                 std::vector<float> SHb(numCoefs);
-                for (size_t x = 0; x < dim; ++x, ++data) {
+                for (size_t x = x0; x < x0 + width; ++x, ++data) {
                     float3 s(cm.getDirectionFor(f, x, y));
                     computeShBasis(SHb.data(), numBands, s);
                     float3 c = 0;
@@ -22,6 +22,9 @@
 #include <utils/compiler.h>
 #include <utils/JobSystem.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace filament {
 namespace ibl {
 
@@ -85,6 +88,71 @@ void CubemapUtils::process(
     }
 }
 
+template<typename STATE>
+void CubemapUtils::processTiled(
+        Cubemap& cm,
+        utils::JobSystem& js,
+        CubemapUtils::SpanProc<STATE> proc,
+        ReduceProc<STATE> reduce,
+        const STATE& prototype,
+        size_t tileSize) {
+    using namespace utils;
+
+    const size_t dim = cm.getDimensions();
+
+    // we want a few bands per thread so that work-stealing can balance the load, but tiles smaller
+    // than 8x8 wouldn't improve locality anymore.
+    const size_t minBandCount = std::max(js.getThreadCount(), size_t(1)) * 4;
+    tileSize = std::max(tileSize, size_t(1));
+    while (tileSize > 8 && 6 * ((dim + tileSize - 1) / tileSize) < minBandCount) {
+        tileSize /= 2;
+    }
+
+    const size_t bandsPerFace = (dim + tileSize - 1) / tileSize;
+    std::vector<STATE> states(6 * bandsPerFace);
+    for (STATE& s : states) {
+        s = prototype;
+    }
+
+    struct Context {
+        Cubemap& cm;
+        CubemapUtils::SpanProc<STATE>& proc;
+        std::vector<STATE>& states;
+        size_t dim;
+        size_t tileSize;
+        size_t bandsPerFace;
+    } context{ cm, proc, states, dim, tileSize, bandsPerFace };
+
+    JobSystem::Job* parent = js.createJob();
+    for (size_t band = 0; band < states.size(); band++) {
+        auto bandJob = [&context, band]() {
+            const size_t dim = context.dim;
+            const size_t tileSize = context.tileSize;
+            const Cubemap::Face f = (Cubemap::Face)(band / context.bandsPerFace);
+            const size_t y0 = (band % context.bandsPerFace) * tileSize;
+            const size_t y1 = std::min(y0 + tileSize, dim);
+            Image& image(context.cm.getImageForFace(f));
+            STATE& s = context.states[band];
+            for (size_t x = 0; x < dim; x += tileSize) {
+                const size_t width = std::min(tileSize, dim - x);
+                for (size_t y = y0; y < y1; y++) {
+                    Cubemap::Texel* data = static_cast<Cubemap::Texel*>(image.getPixelRef(x, y));
+                    context.proc(s, x, y, f, data, width);
+                }
+            }
+        };
+        // not need to signal here, since we're just scheduling work
+        js.run(jobs::createJob(js, parent, bandJob));
+    }
+
+    // wait for all our threads to finish
+    js.runAndWait(parent);
+
+    for (STATE& s : states) {
+        reduce(s);
+    }
+}
+
 template<typename STATE>
 void CubemapUtils::processSingleThreaded(
         Cubemap& cm,
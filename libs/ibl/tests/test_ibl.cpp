@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <gtest/gtest.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/scalar.h>
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+using namespace utils;
+
+class IblTest : public testing::Test {};
+
+// A smooth synthetic environment, such that filtering results converge quickly with the number of
+// samples and can be compared against a reference within a tight tolerance.
+static float3 environment(float3 d) {
+    return { 0.5f + 0.4f * d.x, 0.5f + 0.3f * d.y * d.z, 0.25f + 0.2f * d.z * d.z };
+}
+
+// Creates the mip chain of the synthetic environment.
+static void createEnvironment(JobSystem& js, size_t dim,
+        std::vector<Cubemap>& levels, std::vector<Image>& images) {
+    Image temp;
+    Cubemap cm = CubemapUtils::create(temp, dim);
+    for (size_t f = 0; f < 6; f++) {
+        const Cubemap::Face face = Cubemap::Face(f);
+        Image& image = cm.getImageForFace(face);
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                Cubemap::writeAt(image.getPixelRef(x, y),
+                        environment(cm.getDirectionFor(face, x, y)));
+            }
+        }
+    }
+    cm.makeSeamless();
+    images.push_back(std::move(temp));
+    levels.push_back(std::move(cm));
+
+    while (dim > 1) {
+        dim >>= 1u;
+        Cubemap dst = CubemapUtils::create(temp, dim);
+        CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, levels.back());
+        dst.makeSeamless();
+        images.push_back(std::move(temp));
+        levels.push_back(std::move(dst));
+    }
+}
+
+// Straightforward per-texel GGX filter, as roughnessFilter() computed it before texels were
+// batched: Er = sum(L(l) * <n.l>) / sum(<n.l>) over importance samples of the base level.
+static float3 referenceRoughnessFilter(Cubemap const& src, float3 N, float linearRoughness,
+        size_t numSamples) {
+    const float3 up = std::abs(N.z) < 0.999f ? float3{ 0, 0, 1 } : float3{ 1, 0, 0 };
+    const float3 T = normalize(cross(up, N));
+    const float3 B = cross(N, T);
+    const float a = linearRoughness;
+    float3 sum = 0;
+    float weight = 0;
+    for (size_t i = 0; i < numSamples; i++) {
+        // Hammersley point set
+        uint32_t bits = uint32_t(i);
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        const float2 u{ float(i) / float(numSamples), float(bits) * 2.3283064365386963e-10f };
+
+        const float phi = 2.0f * f::PI * u.x;
+        const float cosTheta2 = (1 - u.y) / (1 + (a + 1) * ((a - 1) * u.y));
+        const float cosTheta = std::sqrt(cosTheta2);
+        const float sinTheta = std::sqrt(1 - cosTheta2);
+        const float3 H{ sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+        const float NoL = 2 * H.z * H.z - 1;
+        if (NoL > 0) {
+            const float3 L{ 2 * H.z * H.x, 2 * H.z * H.y, NoL };
+            const float3 l = T * L.x + B * L.y + N * L.z;
+            sum += src.filterAt(l) * NoL;
+            weight += NoL;
+        }
+    }
+    return sum / weight;
+}
+
+static std::vector<float3> readPixels(Cubemap const& cm) {
+    const size_t dim = cm.getDimensions();
+    std::vector<float3> pixels;
+    pixels.reserve(6 * dim * dim);
+    for (size_t f = 0; f < 6; f++) {
+        Image const& image = cm.getImageForFace(Cubemap::Face(f));
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                pixels.push_back(Cubemap::sampleAt(image.getPixelRef(x, y)));
+            }
+        }
+    }
+    return pixels;
+}
+
+TEST_F(IblTest, RoughnessFilterMatchesReference) { // NOLINT
+    JobSystem js;
+    js.adopt();
+
+    std::vector<Cubemap> levels;
+    std::vector<Image> images;
+    createEnvironment(js, 32, levels, images);
+
+    // 12 is not a multiple of the batch size, which exercises partial batches.
+    for (size_t dim : { 16, 12 }) {
+        for (float roughness : { 0.2f, 0.6f }) {
+            Image image;
+            Cubemap dst = CubemapUtils::create(image, dim);
+            CubemapIBL::roughnessFilter(js, dst, levels, roughness, 1024, float3{ 1, 1, 1 },
+                    false);
+
+            float maxError = 0;
+            for (size_t f = 0; f < 6; f++) {
+                const Cubemap::Face face = Cubemap::Face(f);
+                Image const& faceImage = dst.getImageForFace(face);
+                for (size_t y = 0; y < dim; y++) {
+                    for (size_t x = 0; x < dim; x++) {
+                        const float3 expected = referenceRoughnessFilter(levels[0],
+                                dst.getDirectionFor(face, x, y), roughness, 1024);
+                        const float3 actual = Cubemap::sampleAt(faceImage.getPixelRef(x, y));
+                        const float3 error = abs(actual - expected);
+                        maxError = std::max({ maxError, error.x, error.y, error.z });
+                    }
+                }
+            }
+            EXPECT_LT(maxError, 0.01f) << "dim " << dim << ", roughness " << roughness;
+        }
+    }
+
+    js.emancipate();
+}
+
+TEST_F(IblTest, RoughnessFilterIsDeterministic) { // NOLINT
+    std::vector<float3> results[2];
+    for (size_t threadCount : { 1, 4 }) {
+        JobSystem js(threadCount);
+        js.adopt();
+
+        std::vector<Cubemap> levels;
+        std::vector<Image> images;
+        createEnvironment(js, 64, levels, images);
+
+        Image image;
+        Cubemap dst = CubemapUtils::create(image, 32);
+        CubemapIBL::roughnessFilter(js, dst, levels, 0.5f, 64, float3{ 1, 1, 1 }, true);
+        results[threadCount == 1 ? 0 : 1] = readPixels(dst);
+
+        js.emancipate();
+    }
+    ASSERT_EQ(results[0].size(), results[1].size());
+    EXPECT_EQ(0, memcmp(results[0].data(), results[1].data(),
+            results[0].size() * sizeof(float3)));
+}
+
+TEST_F(IblTest, ComputeSHRecoversRenderedCoefficients) { // NOLINT
+    JobSystem js;
+    js.adopt();
+
+    // renderSH() evaluates the scalar SH basis, which computeSH() must invert. Note that renderSH()
+    // also scales its output by 1/pi.
+    constexpr size_t numBands = 3;
+    std::unique_ptr<float3[]> sh(new float3[numBands * numBands]);
+    for (size_t i = 0; i < numBands * numBands; i++) {
+        sh[i] = float3{ 1.0f / float(i + 1), 0.5f - 0.1f * float(i), 0.25f * float(i % 3) };
+    }
+
+    Image image;
+    Cubemap cm = CubemapUtils::create(image, 64);
+    CubemapSH::renderSH(js, cm, sh, numBands);
+
+    std::unique_ptr<float3[]> result = CubemapSH::computeSH(js, cm, numBands, false);
+    for (size_t i = 0; i < numBands * numBands; i++) {
+        const float3 expected = sh[i] * f::ONE_OVER_PI;
+        EXPECT_NEAR(result[i].x, expected.x, 1e-4f) << "coefficient " << i;
+        EXPECT_NEAR(result[i].y, expected.y, 1e-4f) << "coefficient " << i;
+        EXPECT_NEAR(result[i].z, expected.z, 1e-4f) << "coefficient " << i;
+    }
+
+    js.emancipate();
+}
+
+TEST_F(IblTest, ComputeSHIsDeterministic) { // NOLINT
+    constexpr size_t numBands = 5;
+    std::unique_ptr<float3[]> results[2];
+    for (size_t threadCount : { 1, 4 }) {
+        JobSystem js(threadCount);
+        js.adopt();
+
+        std::vector<Cubemap> levels;
+        std::vector<Image> images;
+        createEnvironment(js, 128, levels, images);
+        results[threadCount == 1 ? 0 : 1] = CubemapSH::computeSH(js, levels[0], numBands, true);
+
+        js.emancipate();
+    }
+    EXPECT_EQ(0, memcmp(results[0].get(), results[1].get(),
+            numBands * numBands * sizeof(float3)));
+}
+
+TEST_F(IblTest, SampleTableRoundTrip) { // NOLINT
+    JobSystem js;
+    js.adopt();
+
+    std::vector<Cubemap> levels;
+    std::vector<Image> images;
+    createEnvironment(js, 32, levels, images);
+    const utils::Slice<Cubemap> slice{ levels.data(), uint32_t(levels.size()) };
+
+    const CubemapIBL::SampleTable table = CubemapIBL::SampleTable::create(
+            0.4f, 32, levels[0].getDimensions(), levels.size(), true);
+    const std::vector<uint8_t> blob = table.serialize();
+
+    const CubemapIBL::SampleTable copy = CubemapIBL::SampleTable::deserialize(
+            blob.data(), blob.size());
+    ASSERT_TRUE(copy.isValid());
+    EXPECT_EQ(copy.getSampleCount(), table.getSampleCount());
+    EXPECT_EQ(copy.getBaseDimension(), table.getBaseDimension());
+    EXPECT_EQ(copy.getLevelCount(), table.getLevelCount());
+    EXPECT_EQ(copy.serialize(), blob);
+
+    // Both tables must produce the exact same output.
+    Image image0, image1;
+    Cubemap dst0 = CubemapUtils::create(image0, 8);
+    Cubemap dst1 = CubemapUtils::create(image1, 8);
+    CubemapIBL::roughnessFilter(js, dst0, slice, table, float3{ 1, 1, 1 });
+    CubemapIBL::roughnessFilter(js, dst1, slice, copy, float3{ 1, 1, 1 });
+    const std::vector<float3> pixels0 = readPixels(dst0);
+    const std::vector<float3> pixels1 = readPixels(dst1);
+    EXPECT_EQ(0, memcmp(pixels0.data(), pixels1.data(), pixels0.size() * sizeof(float3)));
+
+    // Truncated blobs and blobs from a different version are rejected.
+    EXPECT_FALSE(CubemapIBL::SampleTable::deserialize(blob.data(), blob.size() - 1).isValid());
+    EXPECT_FALSE(CubemapIBL::SampleTable::deserialize(blob.data(), 4).isValid());
+    std::vector<uint8_t> other = blob;
+    const uint32_t version = CubemapIBL::SampleTable::VERSION + 1;
+    memcpy(other.data() + sizeof(uint32_t), &version, sizeof(version));
+    EXPECT_FALSE(CubemapIBL::SampleTable::deserialize(other.data(), other.size()).isValid());
+
+    js.emancipate();
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/ImageSampler.h>
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace image;
+using namespace utils;
+
+static LinearImage createImage(uint32_t size, uint32_t channels) {
+    LinearImage image(size, size, channels);
+    float* data = image.getPixelRef();
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                *data++ = 0.5f + 0.5f * std::sin(float(x * (c + 1)) * 0.05f + float(y) * 0.03f);
+            }
+        }
+    }
+    return image;
+}
+
+// Arguments are the source dimension and the filter. Throughput is reported in source pixels.
+static void BM_generateMipmaps(benchmark::State& state) {
+    const uint32_t size = uint32_t(state.range(0));
+    const Filter filter = Filter(state.range(1));
+    const LinearImage source = createImage(size, 3);
+    const uint32_t count = getMipmapCount(source);
+    std::vector<LinearImage> mips(count);
+    for (auto _ : state) {
+        generateMipmaps(source, filter, mips.data(), count);
+        benchmark::DoNotOptimize(mips[0].getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+}
+
+static void BM_generateMipmapsJobSystem(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const uint32_t size = uint32_t(state.range(0));
+    const Filter filter = Filter(state.range(1));
+    const LinearImage source = createImage(size, 3);
+    const uint32_t count = getMipmapCount(source);
+    std::vector<LinearImage> mips(count);
+    for (auto _ : state) {
+        generateMipmaps(js, source, filter, mips.data(), count);
+        benchmark::DoNotOptimize(mips[0].getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+
+    js.emancipate();
+}
+
+// Arguments are the source dimension, the target dimension and the filter.
+static void BM_resampleImage(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const LinearImage source = createImage(uint32_t(state.range(0)), 3);
+    const uint32_t size = uint32_t(state.range(1));
+    const Filter filter = Filter(state.range(2));
+    for (auto _ : state) {
+        LinearImage result = resampleImage(js, source, size, size, ImageSampler {
+            .horizontalFilter = filter,
+            .verticalFilter = filter
+        });
+        benchmark::DoNotOptimize(result.getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_generateMipmaps)
+        ->Args({ 1024, int(Filter::BOX) })
+        ->Args({ 1024, int(Filter::LANCZOS) })
+        ->Args({ 2048, int(Filter::MITCHELL) })
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_generateMipmapsJobSystem)
+        ->Args({ 1024, int(Filter::BOX) })
+        ->Args({ 1024, int(Filter::LANCZOS) })
+        ->Args({ 2048, int(Filter::MITCHELL) })
+        ->Args({ 4096, int(Filter::LANCZOS) })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+BENCHMARK(BM_resampleImage)
+        ->Args({ 1024, 2048, int(Filter::MITCHELL) })
+        ->Args({ 4096, 1000, int(Filter::LANCZOS) })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
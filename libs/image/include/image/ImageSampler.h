@@ -21,6 +21,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 /**
@@ -107,6 +111,15 @@ UTILS_PUBLIC
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         const ImageSampler& sampler);
 
+/**
+ * Multithreaded variant of resampleImage. The rows of each filtering pass are distributed across
+ * the given job system, which must have been adopted by the calling thread. The result is
+ * identical to the single-threaded variant.
+ */
+UTILS_PUBLIC
+LinearImage resampleImage(utils::JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler);
+
 /**
  * Resizes the given linear image using a simplified API that takes target dimensions and filter.
  */
@@ -145,6 +158,15 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 UTILS_PUBLIC
 void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount);
 
+/**
+ * Multithreaded variant of generateMipmaps. All miplevels are resampled together, with their rows
+ * distributed across the given job system, which must have been adopted by the calling thread.
+ * The result is identical to the single-threaded variant.
+ */
+UTILS_PUBLIC
+void generateMipmaps(utils::JobSystem& js, const LinearImage& source, Filter, LinearImage* result,
+        uint32_t mipCount);
+
 /**
  * Returns the number of miplevels it would take to downsample the given image down to 1x1. This
  * number does not include the original image (i.e. mip 0).
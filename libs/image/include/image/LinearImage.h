@@ -19,6 +19,7 @@
 
 #include <utils/compiler.h>
 
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -40,6 +41,10 @@ namespace image {
  * By convention, we do not use channel major order (i.e. planar). However we provide a free
  * function in ImageOps to combine planar data. Pixels are stored such that the row stride is simply
  * width * channels * sizeof(float).
+ *
+ * Pixel data normally lives on the heap. For huge textures, large images can instead be backed by
+ * memory-mapped scratch files (see setScratchDirectory), which allows the operating system to page
+ * out the rows that are not currently being processed.
  */
 class UTILS_PUBLIC LinearImage {
 public:
@@ -79,7 +84,7 @@ public:
      * Gets a pointer to the pixel data at the given column and row. (not bounds checked)
      */
     float* getPixelRef(uint32_t column, uint32_t row) {
-        return mData + (column + row * mWidth) * mChannels;
+        return mData + (column + size_t(row) * mWidth) * mChannels;
     }
 
     template<typename T>
@@ -91,7 +96,7 @@ public:
      * Gets a pointer to the immutable pixel data at the given column and row. (not bounds checked)
      */
     float const* getPixelRef(uint32_t column, uint32_t row) const {
-        return mData + (column + row * mWidth) * mChannels;
+        return mData + (column + size_t(row) * mWidth) * mChannels;
     }
 
     template<typename T>
@@ -105,6 +110,29 @@ public:
     void reset() { *this = LinearImage(); }
     bool isValid() const { return mData; }
 
+    /**
+     * Returns true if the pixel data is backed by a memory-mapped scratch file.
+     */
+    bool isFileBacked() const;
+
+    /**
+     * Hints that the given rows will not be accessed again soon. If the image is backed by a
+     * scratch file, their pages are dropped from the working set and read back on demand.
+     * Otherwise this does nothing.
+     */
+    void releaseRows(uint32_t row, uint32_t count) const;
+
+    /**
+     * Makes subsequently allocated images whose pixel data occupies at least the given number of
+     * bytes use memory-mapped scratch files in the given directory rather than heap memory. The
+     * files are deleted as soon as they are created, so they never outlive the process. Pass null
+     * to go back to heap allocations.
+     *
+     * This is not thread safe, it should be called before any images are created. It has no
+     * effect on platforms without memory-mapped files.
+     */
+    static void setScratchDirectory(const char* directory, size_t minimumBytes = 64u << 20u);
+
 private:
 
     struct SharedReference;
@@ -21,14 +21,18 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 using namespace image;
+using namespace utils;
 
 namespace {
 
@@ -97,20 +101,28 @@ const FilterFunction Lanczos {
     .boundingRadius = 1
 };
 
-// Describes a Multiply-Add operation: target[targetIndex] += source[sourceIndex] * weight.
-// This allows us to cache the weights computed by evaluation of the filter function, as well as
-// the indices that are generated from careful alignment of sample and target samples.
+// A single tap of a resampling filter: target += source[sourceIndex] * weight.
 // We allow signed source indices to accommodate external source samples whose values depend
 // on the wrap-mode configuration in the sampler.
-struct MadInstruction {
-    uint32_t targetIndex;
+struct FilterTap {
     int32_t sourceIndex;
     float weight;
 };
 
-using MadProgram = std::vector<MadInstruction>;
+// Polyphase representation of a 1D resampling filter. The taps that contribute to target sample
+// "i" are stored contiguously in taps[offsets[i]] through taps[offsets[i + 1] - 1], in order of
+// increasing source index. The filter function is evaluated once per image rather than once per
+// row, and both resampling passes can walk the taps in a cache-friendly order.
+struct FilterTable {
+    std::vector<uint32_t> offsets;
+    std::vector<FilterTap> taps;
+};
+
+// Number of target rows resampled together. Larger bands filter fewer source rows twice, but
+// need more scratch memory. This is also the smallest amount of work given to a job.
+constexpr uint32_t kRowsPerBand = 32;
 
-// Generates a list of MAD instructions that transforms a row of samples of length "nsource"
+// Generates the table of filter taps that transforms a row of samples of length "nsource"
 // into a sequence of length "ntarget" using the given filter function.
 //
 // The given left / right floats define a source range within [0,1] such that 0 is at the left edge
@@ -121,8 +133,8 @@ using MadProgram = std::vector<MadInstruction>;
 //    d....delta (i.e. the normalized width of a single pixel square)
 //    x....normalized coord in [0..1] where 0/1 are the outer edges of the range.
 //    i....integer index where 0 is the left-most pixel and n-1 is the right-most pixel.
-void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float right,
-        FilterFunction filter, float radiusMultiplier, MadProgram* result) {
+void generateFilterTable(uint32_t ntarget, uint32_t nsource, float left, float right,
+        FilterFunction filter, float radiusMultiplier, FilterTable* result) {
     const float dtarget = 1.0f / ntarget;
     const float fnsource = float(nsource) * (right - left);
     const bool minifying = float(ntarget) < fnsource;
@@ -132,20 +144,28 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     // the [0,1] domain. If this were a huge number, the filtered results would look the same, but
     // the filter would perform very poorly because it would be iterating over a lot more samples
     // than necessary.
-    const float filterBounds = domainScale * std::abs(filter.boundingRadius);
+    const float filterBounds = std::abs(filter.boundingRadius) / domainScale;
+
+    result->offsets.clear();
+    result->taps.clear();
+    result->offsets.reserve(ntarget + 1);
 
     // Iterate through target samples. "xtarget" points to the center of each target pixel.
     float xtarget = dtarget / 2.0f;
     for (uint32_t itarget = 0; itarget < ntarget; ++itarget, xtarget += dtarget) {
+        result->offsets.push_back(uint32_t(result->taps.size()));
 
         // For this particular target pixel, we'll be accumulating a count and sum so that we can
         // adjust the weights afterwards. This allows us to reject some of the source samples.
         uint32_t count = 0;
         float sum = 0;
 
-        // Iterate through source samples that lie within the bounded region.
-        const auto isource_lower = int32_t((xtarget - filterBounds) * nsource);
-        const auto isource_upper = int32_t(std::ceil((xtarget + filterBounds) * nsource));
+        // Iterate through source samples that lie within the bounded region, after mapping it
+        // from the source range back to the full image.
+        const float xlower = left + (xtarget - filterBounds) * (right - left);
+        const float xupper = left + (xtarget + filterBounds) * (right - left);
+        const auto isource_lower = int32_t(xlower * nsource);
+        const auto isource_upper = int32_t(std::ceil(xupper * nsource));
         for (int32_t isource = isource_lower; isource <= isource_upper; ++isource) {
             const float xsource = (((isource + 0.5f) / nsource) - left) / (right - left);
             const bool outside_image = isource < 0 || isource >= int32_t(nsource);
@@ -156,38 +176,21 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
             const float t = domainScale * std::abs(xsource - xtarget);
             const float weight = filter.fn(t);
             if (weight != 0) {
-                result->push_back({itarget, isource, weight});
+                result->taps.push_back({isource, weight});
                 sum += weight;
                 ++count;
             }
         }
 
-        // Normalize the set of weights that were recently appended to the MAD program.
+        // Normalize the set of weights that were recently appended to the table.
         if (sum != 0) {
-            MadInstruction* mad = result->data() + result->size() - count;
-            for (uint32_t i = 0; i < count; ++i, ++mad) {
-                mad->weight /= sum;
+            FilterTap* tap = result->taps.data() + result->taps.size() - count;
+            for (uint32_t i = 0; i < count; ++i, ++tap) {
+                tap->weight /= sum;
             }
         }
     }
-}
-
-// Transforms a MAD program intended for single-channel data into a program intended for
-// multi-channel data.
-void expandMadProgram(uint32_t nchannels, MadProgram* program) {
-    if (nchannels == 1) {
-        return;
-    }
-    MadProgram result;
-    result.reserve(program->size() * nchannels);
-    for (auto mad : *program) {
-        mad.sourceIndex *= nchannels;
-        mad.targetIndex *= nchannels;
-        for (uint32_t j = 0; j < nchannels; ++j, ++mad.sourceIndex, ++mad.targetIndex) {
-            result.push_back(mad);
-        }
-    }
-    program->swap(result);
+    result->offsets.push_back(uint32_t(result->taps.size()));
 }
 
 FilterFunction createFilterFunction(Filter ftype) {
@@ -207,75 +210,242 @@ FilterFunction createFilterFunction(Filter ftype) {
     return fn;
 }
 
+Filter resolveFilter(Filter filter, uint32_t ntarget, uint32_t nsource) {
+    if (filter == Filter::DEFAULT) {
+        return ntarget > nsource ? Filter::MITCHELL : Filter::LANCZOS;
+    }
+    return filter;
+}
+
 template <class VecT>
-void normalizeImpl(LinearImage& image) {
-    const uint32_t width = image.getWidth(), height = image.getHeight();
-    auto vecs = (VecT*) image.getPixelRef();
-    for (uint32_t n = 0; n < width * height; ++n) {
+void normalizeRow(float* data, uint32_t width) {
+    auto vecs = (VecT*) data;
+    for (uint32_t n = 0; n < width; ++n) {
         vecs[n] = normalize(vecs[n]);
     }
 }
 
-void normalize(LinearImage& image) {
-    FILAMENT_CHECK_PRECONDITION(image.getChannels() == 3 || image.getChannels() == 4)
-            << "Must be a 3 or 4 channel image";
-    if (image.getChannels() == 3) {
-      normalizeImpl< filament::math::float3>(image);
+void normalizeRow(float* data, uint32_t width, uint32_t nchan) {
+    if (nchan == 3) {
+        normalizeRow<filament::math::float3>(data, width);
     } else {
-      normalizeImpl< filament::math::float4>(image);
+        normalizeRow<filament::math::float4>(data, width);
     }
 }
 
-LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
-    const uint32_t swidth = source.getWidth();
-    const uint32_t sheight = source.getHeight();
-    const uint32_t nchan = source.getChannels();
-    const bool mag = twidth > swidth;
-    if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
-    const FilterFunction hfn = createFilterFunction(filter);
-
-    // Generate a flat list of multiply-add (MAD) instructions.
-    program->clear();
-    generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
-
-    // Allocate the target image.
-    LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
-
-    // The MIN filter is special because it starts with non-zero values and ignores filter weights.
-    if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
+// Applies the filter table to a single row of interleaved samples. NCHAN is the number of
+// channels when known at compile time, which lets the compiler unroll the inner loop, or zero.
+template <uint32_t NCHAN>
+void filterRow(FilterTable const& table, bool minimum, uint32_t channels,
+        float const* UTILS_RESTRICT source, float* UTILS_RESTRICT target) {
+    const uint32_t nchan = NCHAN ? NCHAN : channels;
+    const uint32_t ntarget = uint32_t(table.offsets.size() - 1);
+    uint32_t const* offsets = table.offsets.data();
+    FilterTap const* taps = table.taps.data();
+    for (uint32_t itarget = 0; itarget < ntarget; ++itarget, target += nchan) {
+        FilterTap const* tap = taps + offsets[itarget];
+        FilterTap const* const end = taps + offsets[itarget + 1];
+
+        // The MIN filter is special because it starts with non-zero values and ignores weights.
+        if (minimum) {
+            for (uint32_t c = 0; c < nchan; ++c) {
+                target[c] = std::numeric_limits<float>::max();
+            }
+            for (; tap != end; ++tap) {
+                float const* src = source + tap->sourceIndex * int32_t(nchan);
+                for (uint32_t c = 0; c < nchan; ++c) {
+                    target[c] = std::min(src[c], target[c]);
+                }
+            }
+            continue;
         }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
+
+        for (uint32_t c = 0; c < nchan; ++c) {
+            target[c] = 0;
+        }
+        for (; tap != end; ++tap) {
+            float const* src = source + tap->sourceIndex * int32_t(nchan);
+            const float weight = tap->weight;
+            for (uint32_t c = 0; c < nchan; ++c) {
+                target[c] += src[c] * weight;
             }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
         }
-        return result;
     }
+}
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+void filterRow(FilterTable const& table, bool minimum, uint32_t nchan,
+        float const* source, float* target) {
+    switch (nchan) {
+        case 1: filterRow<1>(table, minimum, nchan, source, target); break;
+        case 3: filterRow<3>(table, minimum, nchan, source, target); break;
+        case 4: filterRow<4>(table, minimum, nchan, source, target); break;
+        default: filterRow<0>(table, minimum, nchan, source, target); break;
+    }
+}
+
+// Resamples an image with two separable passes. The horizontal pass filters source rows into a
+// scratch buffer that has the target width, and the vertical pass then blends whole rows of the
+// scratch buffer into each target row, which avoids transposing the image.
+//
+// Target rows are produced in bands, and each band only runs the horizontal pass over the source
+// rows that it depends on. The scratch memory therefore scales with the width of the image
+// rather than its area, and bands can be distributed across jobs without synchronization. Rows
+// at the boundary between two bands are filtered horizontally by both.
+class Resampler {
+public:
+    Resampler(const LinearImage& source, uint32_t width, uint32_t height,
+            const ImageSampler& sampler)
+            : mSource(source),
+              mResult(width, height, source.getChannels()) {
+        FILAMENT_CHECK_PRECONDITION(sampler.east.mode == Boundary::EXCLUDE &&
+                sampler.north.mode == Boundary::EXCLUDE &&
+                sampler.west.mode == Boundary::EXCLUDE &&
+                sampler.south.mode == Boundary::EXCLUDE)
+                << "Not yet implemented.";
+        const Region& region = sampler.sourceRegion;
+        const float radius = sampler.filterRadiusMultiplier;
+        mHorizontalFilter = resolveFilter(sampler.horizontalFilter, width, source.getWidth());
+        mVerticalFilter = resolveFilter(sampler.verticalFilter, height, source.getHeight());
+        FILAMENT_CHECK_PRECONDITION((mHorizontalFilter != Filter::GAUSSIAN_NORMALS &&
+                mVerticalFilter != Filter::GAUSSIAN_NORMALS) ||
+                source.getChannels() == 3 || source.getChannels() == 4)
+                << "Must be a 3 or 4 channel image";
+        generateFilterTable(width, source.getWidth(), region.left, region.right,
+                createFilterFunction(mHorizontalFilter), radius, &mHorizontalTable);
+        generateFilterTable(height, source.getHeight(), region.top, region.bottom,
+                createFilterFunction(mVerticalFilter), radius, &mVerticalTable);
+    }
+
+    uint32_t getTargetHeight() const noexcept { return mResult.getHeight(); }
+    LinearImage const& getResult() const noexcept { return mResult; }
+
+    // Produces the given range of target rows.
+    void resampleRows(uint32_t row, uint32_t count) noexcept {
+        const uint32_t nchan = mResult.getChannels();
+        const uint32_t width = mResult.getWidth();
+        const size_t rowSize = size_t(width) * nchan;
+        uint32_t const* offsets = mVerticalTable.offsets.data();
+        FilterTap const* taps = mVerticalTable.taps.data();
+
+        // Determine the range of source rows that contribute to this band.
+        FilterTap const* const bandBegin = taps + offsets[row];
+        FilterTap const* const bandEnd = taps + offsets[row + count];
+        int32_t lower = std::numeric_limits<int32_t>::max();
+        int32_t upper = std::numeric_limits<int32_t>::min();
+        for (FilterTap const* tap = bandBegin; tap != bandEnd; ++tap) {
+            lower = std::min(lower, tap->sourceIndex);
+            upper = std::max(upper, tap->sourceIndex);
+        }
+
+        // Horizontal pass over the source rows of this band.
+        std::vector<float> scratch;
+        if (lower <= upper) {
+            const bool minimum = mHorizontalFilter == Filter::MINIMUM;
+            scratch.resize(size_t(upper - lower + 1) * rowSize);
+            float* target = scratch.data();
+            for (int32_t srow = lower; srow <= upper; ++srow, target += rowSize) {
+                filterRow(mHorizontalTable, minimum, nchan, mSource.getPixelRef(0, srow), target);
+                if (mHorizontalFilter == Filter::GAUSSIAN_NORMALS) {
+                    normalizeRow(target, width, nchan);
+                }
+            }
+        }
+
+        // Vertical pass, blending rows of the scratch buffer into target rows.
+        const bool minimum = mVerticalFilter == Filter::MINIMUM;
+        for (uint32_t end = row + count; row < end; ++row) {
+            float* UTILS_RESTRICT target = mResult.getPixelRef(0, row);
+            FilterTap const* tap = taps + offsets[row];
+            FilterTap const* const tapEnd = taps + offsets[row + 1];
+            if (minimum) {
+                std::fill_n(target, rowSize, std::numeric_limits<float>::max());
+                for (; tap != tapEnd; ++tap) {
+                    float const* UTILS_RESTRICT src =
+                            scratch.data() + size_t(tap->sourceIndex - lower) * rowSize;
+                    for (size_t i = 0; i < rowSize; ++i) {
+                        target[i] = std::min(src[i], target[i]);
+                    }
+                }
+                continue;
+            }
+            std::fill_n(target, rowSize, 0.0f);
+            for (; tap != tapEnd; ++tap) {
+                float const* UTILS_RESTRICT src =
+                        scratch.data() + size_t(tap->sourceIndex - lower) * rowSize;
+                const float weight = tap->weight;
+                for (size_t i = 0; i < rowSize; ++i) {
+                    target[i] += src[i] * weight;
+                }
+            }
+            if (mVerticalFilter == Filter::GAUSSIAN_NORMALS) {
+                normalizeRow(target, width, nchan);
+            }
         }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
     }
 
-    // Perform post processing for the current pass.
-    if (filter == Filter::GAUSSIAN_NORMALS) {
-        normalize(result);
+private:
+    const LinearImage& mSource;
+    LinearImage mResult;
+    Filter mHorizontalFilter;
+    Filter mVerticalFilter;
+    FilterTable mHorizontalTable;
+    FilterTable mVerticalTable;
+};
+
+// Resamples every image in bands of rows. When a job system is given, the bands of all images
+// are distributed across its threads at once, such that the small images of a mip chain are
+// processed alongside the large ones.
+void runResamplers(JobSystem* js, Resampler* resamplers, size_t count) {
+    if (!js) {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t height = resamplers[i].getTargetHeight();
+            for (uint32_t row = 0; row < height; row += kRowsPerBand) {
+                resamplers[i].resampleRows(row, std::min(kRowsPerBand, height - row));
+            }
+        }
+        return;
+    }
+
+    JobSystem::Job* parent = js->createJob();
+    for (size_t i = 0; i < count; ++i) {
+        Resampler* resampler = resamplers + i;
+        js->run(jobs::parallel_for(*js, parent, 0, resampler->getTargetHeight(),
+                [resampler](uint32_t row, uint32_t n) { resampler->resampleRows(row, n); },
+                jobs::CountSplitter<kRowsPerBand>()));
+    }
+    js->runAndWait(parent);
+}
+
+LinearImage resampleImageImpl(JobSystem* js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
+    Resampler resampler(source, width, height, sampler);
+    runResamplers(js, &resampler, 1);
+    return resampler.getResult();
+}
+
+// Generates the given number of mipmaps (not including the base level) using the given filter.
+// Unlike traditional mipmap generation, our implementation generates all levels from the original
+// image, under the premise that this produces a higher quality result. Since levels do not
+// depend on each other, they are all resampled together.
+void generateMipmapsImpl(JobSystem* js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    mips = std::min(mips, getMipmapCount(source));
+    std::vector<Resampler> resamplers;
+    resamplers.reserve(mips);
+    uint32_t width = source.getWidth();
+    uint32_t height = source.getHeight();
+    for (uint32_t n = 0; n < mips; ++n) {
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+        resamplers.emplace_back(source, width, height, ImageSampler {
+            .horizontalFilter = filter,
+            .verticalFilter = filter
+        });
+    }
+    runResamplers(js, resamplers.data(), resamplers.size());
+    for (uint32_t n = 0; n < mips; ++n) {
+        result[n] = resamplers[n].getResult();
     }
-    return result;
 }
 
 } // anonymous namespace
@@ -288,22 +458,12 @@ SingleSample::~SingleSample() {
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         const ImageSampler& sampler) {
-    FILAMENT_CHECK_PRECONDITION(sampler.east.mode == Boundary::EXCLUDE &&
-            sampler.north.mode == Boundary::EXCLUDE && sampler.west.mode == Boundary::EXCLUDE &&
-            sampler.south.mode == Boundary::EXCLUDE)
-            << "Not yet implemented.";
-    const auto hfilter = sampler.horizontalFilter;
-    const auto vfilter = sampler.verticalFilter;
-    const float radius = sampler.filterRadiusMultiplier;
-    const float left = sampler.sourceRegion.left;
-    const float top = sampler.sourceRegion.top;
-    const float right = sampler.sourceRegion.right;
-    const float bottom = sampler.sourceRegion.bottom;
-    MadProgram program;
-    LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
-    return result;
+    return resampleImageImpl(nullptr, source, width, height, sampler);
+}
+
+LinearImage resampleImage(JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
+    return resampleImageImpl(&js, source, width, height, sampler);
 }
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
@@ -321,31 +481,29 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
     const float top = y - radius / source.getHeight();
     const float right = x + radius / source.getWidth();
     const float bottom = y + radius / source.getHeight();
-    MadProgram program;
-    LinearImage row = transpose(resampleImage1D(source, &program, 1, filter, left, right, radius));
-    row = resampleImage1D(row, &program, 1, filter, top, bottom, radius);
+    LinearImage sample = resampleImage(source, 1, 1, ImageSampler {
+        .horizontalFilter = filter,
+        .verticalFilter = filter,
+        .sourceRegion = { left, top, right, bottom },
+        .filterRadiusMultiplier = radius
+    });
     if (!result->data) {
         result->data = new float[source.getChannels()];
     }
     float* dst = result->data;
-    float const* src = row.getPixelRef();
+    float const* src = sample.getPixelRef();
     for (uint32_t c = 0; c < source.getChannels(); ++c) {
         dst[c] = src[c];
     }
 }
 
-// Generates the given number of mipmaps (not including the base level) using the given filter.
-// Unlike traditional mipmap generation, our implementation generates all levels from the original
-// image, under the premise that this produces a higher quality result.
 void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
-    mips = std::min(mips, getMipmapCount(source));
-    uint32_t width = source.getWidth();
-    uint32_t height = source.getHeight();
-    for (uint32_t n = 0; n < mips; ++n) {
-        width = std::max(width >> 1u, 1u);
-        height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
-    }
+    generateMipmapsImpl(nullptr, source, filter, result, mips);
+}
+
+void generateMipmaps(JobSystem& js, const LinearImage& source, Filter filter, LinearImage* result,
+        uint32_t mips) {
+    generateMipmapsImpl(&js, source, filter, result, mips);
 }
 
 uint32_t getMipmapCount(const LinearImage& source) {
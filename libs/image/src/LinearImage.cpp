@@ -18,17 +18,76 @@
 
 #include <cstring> // for memset
 #include <memory>
+#include <string>
+
+#if !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#define IMAGE_HAS_SCRATCH_FILES 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define IMAGE_HAS_SCRATCH_FILES 0
+#endif
 
 namespace image  {
 
+namespace {
+
+struct ScratchConfig {
+    std::string directory;
+    size_t minimumBytes = 0;
+};
+
+ScratchConfig& getScratchConfig() {
+    static ScratchConfig config;
+    return config;
+}
+
+// Returns a zero-filled mapping of the given size backed by an anonymous scratch file, or null.
+float* mapScratchFile(size_t size) {
+#if IMAGE_HAS_SCRATCH_FILES
+    std::string path = getScratchConfig().directory + "/linearimage-XXXXXX";
+    int fd = mkstemp(path.data());
+    if (fd < 0) {
+        return nullptr;
+    }
+    unlink(path.c_str());
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, off_t(size)) == 0) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    return data == MAP_FAILED ? nullptr : (float*) data;
+#else
+    return nullptr;
+#endif
+}
+
+} // anonymous namespace
+
 struct LinearImage::SharedReference {
     SharedReference(uint32_t width, uint32_t height, uint32_t channels) {
-        const uint32_t nfloats = width * height * channels;
+        const size_t nfloats = size_t(width) * height * channels;
+        const size_t size = sizeof(float) * nfloats;
+        ScratchConfig const& config = getScratchConfig();
+        if (!config.directory.empty() && size > 0 && size >= config.minimumBytes) {
+            float* floats = mapScratchFile(size);
+            if (floats) {
+                pixels = std::shared_ptr<float>(floats, [size](float* floats) {
+#if IMAGE_HAS_SCRATCH_FILES
+                    munmap(floats, size);
+#endif
+                });
+                mappedSize = size;
+                return;
+            }
+        }
         float* floats = new float[nfloats];
-        memset(floats, 0, sizeof(float) * nfloats);
+        memset(floats, 0, size);
         pixels = std::shared_ptr<float>(floats, std::default_delete<float[]>());
     }
     std::shared_ptr<float> pixels;
+    size_t mappedSize = 0;
 };
 
 LinearImage::~LinearImage() {
@@ -58,4 +117,32 @@ LinearImage& LinearImage::operator=(const LinearImage& that) {
     return *this;
 }
 
+bool LinearImage::isFileBacked() const {
+    return mDataRef && mDataRef->mappedSize > 0;
+}
+
+void LinearImage::releaseRows(uint32_t row, uint32_t count) const {
+#if IMAGE_HAS_SCRATCH_FILES
+    if (!isFileBacked()) {
+        return;
+    }
+    // Only whole pages that lie within the rows can be released.
+    const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = uintptr_t(getPixelRef(0, row));
+    const uintptr_t end = uintptr_t(getPixelRef(0, row + count));
+    const uintptr_t first = (begin + pageSize - 1) & ~(pageSize - 1);
+    const uintptr_t last = end & ~(pageSize - 1);
+    if (first < last) {
+        // The mapping is shared, so dirty pages are kept in the file rather than discarded.
+        madvise((void*) first, last - first, MADV_DONTNEED);
+    }
+#endif
+}
+
+void LinearImage::setScratchDirectory(const char* directory, size_t minimumBytes) {
+    ScratchConfig& config = getScratchConfig();
+    config.directory = directory ? directory : "";
+    config.minimumBytes = minimumBytes;
+}
+
 }  // namespace image
@@ -26,13 +26,18 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -362,6 +367,307 @@ TEST_F(ImageTest, Mipmaps) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, MipmapsJobSystem) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    // Use a non-square, non-power-of-two image so that each pass has partial jobs.
+    LinearImage src(300, 100, 3);
+    float* data = src.getPixelRef();
+    for (uint32_t i = 0, n = 300 * 100 * 3; i < n; ++i) {
+        data[i] = float(i % 31) / 31.0f;
+    }
+
+    const uint32_t count = getMipmapCount(src);
+    for (Filter filter : { Filter::BOX, Filter::LANCZOS, Filter::GAUSSIAN_NORMALS,
+            Filter::MINIMUM }) {
+        vector<LinearImage> expected(count);
+        vector<LinearImage> actual(count);
+        generateMipmaps(src, filter, expected.data(), count);
+        generateMipmaps(js, src, filter, actual.data(), count);
+        for (uint32_t index = 0; index < count; ++index) {
+            const uint32_t size = expected[index].getWidth() * expected[index].getHeight() * 3;
+            ASSERT_EQ(actual[index].getWidth(), expected[index].getWidth());
+            ASSERT_EQ(actual[index].getHeight(), expected[index].getHeight());
+            ASSERT_EQ(memcmp(actual[index].getPixelRef(), expected[index].getPixelRef(),
+                    size * sizeof(float)), 0);
+        }
+    }
+
+    js.emancipate();
+}
+
+TEST_F(ImageTest, ScratchStorage) { // NOLINT
+    LinearImage heap(300, 100, 3);
+    ASSERT_FALSE(heap.isFileBacked());
+
+    const utils::Path directory = utils::Path::getTemporaryDirectory();
+    LinearImage::setScratchDirectory(directory.c_str(), 0);
+    LinearImage mapped(300, 100, 3);
+    LinearImage::setScratchDirectory(nullptr);
+
+#if !defined(WIN32)
+    ASSERT_TRUE(mapped.isFileBacked());
+#endif
+    float* data = mapped.getPixelRef();
+    for (uint32_t i = 0, n = 300 * 100 * 3; i < n; ++i) {
+        ASSERT_EQ(data[i], 0.0f);
+        data[i] = float(i % 17) / 17.0f;
+    }
+    memcpy(heap.getPixelRef(), data, 300 * 100 * 3 * sizeof(float));
+
+    // Released rows must keep their contents.
+    mapped.releaseRows(0, 100);
+    ASSERT_EQ(memcmp(mapped.getPixelRef(), heap.getPixelRef(), 300 * 100 * 3 * sizeof(float)), 0);
+
+    LinearImage expected = resampleImage(heap, 77, 33, Filter::LANCZOS);
+    LinearImage actual = resampleImage(mapped, 77, 33, Filter::LANCZOS);
+    ASSERT_EQ(memcmp(expected.getPixelRef(), actual.getPixelRef(), 77 * 33 * 3 * sizeof(float)), 0);
+}
+
+TEST_F(ImageTest, Diff) { // NOLINT
+    LinearImage golden(100, 70, 3);
+    float* data = golden.getPixelRef();
+    for (uint32_t i = 0, n = 100 * 70 * 3; i < n; ++i) {
+        data[i] = float(i % 13) / 13.0f;
+    }
+    LinearImage result(100, 70, 3);
+    memcpy(result.getPixelRef(), data, 100 * 70 * 3 * sizeof(float));
+
+    DiffOptions options;
+    options.tileSize = 32;
+    options.heatmap = true;
+    DiffResult same = computeDiff(result, golden, options);
+    ASSERT_TRUE(same.passed());
+    ASSERT_TRUE(same.complete);
+    ASSERT_EQ(same.tileCountX, 4);
+    ASSERT_EQ(same.tileCountY, 3);
+    ASSERT_EQ(same.tiles.size(), 12);
+    ASSERT_EQ(same.tiles[11].width, 4);
+    ASSERT_EQ(same.tiles[11].height, 6);
+    ASSERT_EQ(same.maxError, 0.0f);
+
+    // Perturb one channel of two pixels, the second one within epsilon.
+    result.getPixelRef(40, 10)[1] += 0.5f;
+    result.getPixelRef(99, 69)[2] -= 0.01f;
+    options.epsilon = 0.1f;
+
+    utils::JobSystem js;
+    js.adopt();
+    DiffResult serial = computeDiff(result, golden, options);
+    DiffResult parallel = computeDiff(result, golden, options, &js);
+    js.emancipate();
+
+    for (DiffResult const* diff : { &serial, &parallel }) {
+        ASSERT_TRUE(diff->comparable);
+        ASSERT_FALSE(diff->passed());
+        ASSERT_EQ(diff->failingPixels, 1);
+        EXPECT_FLOAT_EQ(diff->maxError, 0.5f);
+        EXPECT_FLOAT_EQ(diff->meanError, 0.51f / (100 * 70 * 3));
+        ASSERT_EQ(diff->tiles[1].failingPixels, 1);
+        EXPECT_FLOAT_EQ(diff->tiles[1].maxError, 0.5f);
+        EXPECT_NEAR(diff->tiles[11].maxError, 0.01f, 1e-6f);
+        EXPECT_FLOAT_EQ(diff->heatmap.getPixelRef(40, 10)[0], 0.5f);
+        ASSERT_EQ(diff->heatmap.getPixelRef(41, 10)[0], 0.0f);
+    }
+
+    // Mismatched dimensions cannot be compared.
+    ASSERT_FALSE(computeDiff(transpose(result), golden).comparable);
+
+    // Stop early when too many pixels fail.
+    clearToValue(result, 2.0f);
+    options.maxFailingPixels = 10;
+    DiffResult partial = computeDiff(result, golden, options);
+    ASSERT_FALSE(partial.complete);
+    ASSERT_LT(partial.failingPixels, 100 * 70);
+}
+
+// Builds a Radiance HDR file in memory, with either flat or run-length encoded scanlines.
+static string makeHdr(uint32_t width, uint32_t height, vector<uint8_t> const& rgbe, bool rle) {
+    string hdr = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) +
+            " +X " + std::to_string(width) + "\n";
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t const* row = rgbe.data() + y * width * 4;
+        if (!rle) {
+            hdr.append((char const*) row, width * 4);
+            continue;
+        }
+        hdr += { 2, 2, char(width >> 8), char(width & 0xff) };
+        for (uint32_t c = 0; c < 4; c++) {
+            uint32_t x = 0;
+            while (x < width) {
+                // Emit a run for 3 or more equal bytes, a literal otherwise.
+                uint32_t run = 1;
+                while (x + run < width && run < 127 &&
+                        row[(x + run) * 4 + c] == row[x * 4 + c]) {
+                    run++;
+                }
+                if (run >= 3) {
+                    hdr += { char(128 + run), char(row[x * 4 + c]) };
+                    x += run;
+                    continue;
+                }
+                uint32_t count = 0;
+                while (x + count < width && count < 128) {
+                    count++;
+                    if (x + count + 2 < width &&
+                            row[(x + count) * 4 + c] == row[(x + count + 1) * 4 + c] &&
+                            row[(x + count) * 4 + c] == row[(x + count + 2) * 4 + c]) {
+                        break;
+                    }
+                }
+                hdr += char(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    hdr += char(row[(x + i) * 4 + c]);
+                }
+                x += count;
+            }
+        }
+    }
+    return hdr;
+}
+
+TEST_F(ImageTest, DecodeHdr) { // NOLINT
+    // Width is at least 8, otherwise scanlines cannot be run-length encoded.
+    const uint32_t width = 16, height = 3;
+    const uint8_t exponents[width] = {
+            0, 1, 2, 3, 64, 120, 128, 129, 136, 140, 200, 255, 128, 128, 128, 128 };
+    vector<uint8_t> rgbe(width * height * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t* texel = &rgbe[(y * width + x) * 4];
+            // The first byte must not be 2, or the flat file would look run-length encoded.
+            texel[0] = uint8_t(x * 37 + y * 11 + 1);
+            texel[1] = x < 8 ? 200 : uint8_t(x * y);
+            texel[2] = uint8_t(y * 29 + x);
+            texel[3] = exponents[x];
+        }
+    }
+
+    for (bool rle : { false, true }) {
+        istringstream stream(makeHdr(width, height, rgbe, rle));
+        LinearImage image = ImageDecoder::decode(stream, "test.hdr");
+        ASSERT_EQ(image.getWidth(), width);
+        ASSERT_EQ(image.getHeight(), height);
+        ASSERT_EQ(image.getChannels(), 3);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint8_t const* texel = &rgbe[(y * width + x) * 4];
+                float const* pixel = image.getPixelRef(x, y);
+                for (uint32_t c = 0; c < 3; c++) {
+                    const float expected = texel[3] == 0 ? 0.0f :
+                            std::ldexp(float(texel[c]) + 0.5f, int(texel[3]) - 136);
+                    ASSERT_EQ(pixel[c], expected) << "rle " << rle << " at " << x << ", " << y;
+                }
+            }
+        }
+    }
+}
+
+// Builds a single-part, tiled, uncompressed OpenEXR file in memory, with FLOAT B, G and R channels.
+// tinyexr can only write scanline files.
+static string makeTiledExr(uint32_t width, uint32_t height, uint32_t tileSize,
+        std::function<float(uint32_t x, uint32_t y, uint32_t c)> const& value) {
+    string exr;
+    auto put = [&exr](auto v) { exr.append((char const*) &v, sizeof(v)); };
+    auto attribute = [&](char const* name, char const* type, string const& data) {
+        exr.append(name, strlen(name) + 1);
+        exr.append(type, strlen(type) + 1);
+        put(int32_t(data.size()));
+        exr += data;
+    };
+    auto bytes = [](std::initializer_list<int32_t> values) {
+        return string((char const*) values.begin(), values.size() * sizeof(int32_t));
+    };
+
+    put(uint32_t(20000630));
+    exr += { 2, 2, 0, 0 }; // version 2, tiled
+
+    string channels;
+    for (char const* name : { "B", "G", "R" }) {
+        channels.append(name, 2);
+        channels += bytes({ 2 }); // FLOAT
+        channels += { 0, 0, 0, 0 };
+        channels += bytes({ 1, 1 });
+    }
+    channels += char(0);
+    const int32_t xmax = int32_t(width - 1), ymax = int32_t(height - 1);
+    attribute("channels", "chlist", channels);
+    attribute("compression", "compression", string(1, 0));
+    attribute("dataWindow", "box2i", bytes({ 0, 0, xmax, ymax }));
+    attribute("displayWindow", "box2i", bytes({ 0, 0, xmax, ymax }));
+    attribute("lineOrder", "lineOrder", string(1, 0));
+    attribute("pixelAspectRatio", "float", bytes({ 0x3f800000 }));
+    attribute("screenWindowCenter", "v2f", bytes({ 0, 0 }));
+    attribute("screenWindowWidth", "float", bytes({ 0x3f800000 }));
+    attribute("tiles", "tiledesc", bytes({ int32_t(tileSize), int32_t(tileSize) }) + char(0));
+    exr += char(0);
+
+    const uint32_t tilesX = (width + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (height + tileSize - 1) / tileSize;
+    string tiles;
+    vector<uint64_t> offsets;
+    const size_t tableEnd = exr.size() + tilesX * tilesY * sizeof(uint64_t);
+    for (uint32_t ty = 0; ty < tilesY; ty++) {
+        for (uint32_t tx = 0; tx < tilesX; tx++) {
+            // Tiles on the right and bottom edges are partial.
+            const uint32_t w = std::min(tileSize, width - tx * tileSize);
+            const uint32_t h = std::min(tileSize, height - ty * tileSize);
+            offsets.push_back(tableEnd + tiles.size());
+            tiles += bytes({ int32_t(tx), int32_t(ty), 0, 0, int32_t(w * h * 3 * sizeof(float)) });
+            for (uint32_t y = ty * tileSize; y < ty * tileSize + h; y++) {
+                for (uint32_t c : { 2, 1, 0 }) {
+                    for (uint32_t x = tx * tileSize; x < tx * tileSize + w; x++) {
+                        const float v = value(x, y, c);
+                        tiles.append((char const*) &v, sizeof(v));
+                    }
+                }
+            }
+        }
+    }
+    for (uint64_t offset : offsets) {
+        put(offset);
+    }
+    return exr + tiles;
+}
+
+TEST_F(ImageTest, DecodeExr) { // NOLINT
+    auto value = [](uint32_t x, uint32_t y, uint32_t c) {
+        return float(x) + 10.0f * float(y) + 0.25f * float(c);
+    };
+
+    auto check = [&value](LinearImage const& image, uint32_t width, uint32_t height) {
+        ASSERT_EQ(image.getWidth(), width);
+        ASSERT_EQ(image.getHeight(), height);
+        ASSERT_EQ(image.getChannels(), 3);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    ASSERT_EQ(image.getPixelRef(x, y)[c], value(x, y, c)) << x << ", " << y;
+                }
+            }
+        }
+    };
+
+    // Tiled, with partial tiles on both edges.
+    istringstream tiled(makeTiledExr(5, 3, 2, value));
+    check(ImageDecoder::decode(tiled, "tiled.exr"), 5, 3);
+
+    // Scanlines, round-tripped through the encoder.
+    LinearImage source(7, 4, 3);
+    for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 7; x++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                source.getPixelRef(x, y)[c] = value(x, y, c);
+            }
+        }
+    }
+    std::stringstream scanlines;
+    ASSERT_TRUE(ImageEncoder::encode(scanlines, ImageEncoder::Format::EXR, source, "",
+            "scanlines.exr"));
+    check(ImageDecoder::decode(scanlines, "scanlines.exr"), 7, 4);
+}
+
 TEST_F(ImageTest, Ktx) { // NOLINT
     uint8_t foo[] = {1, 2, 3};
     uint8_t* data;
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <imageio/ImageDiffer.h>
+
+#include <image/ImageOps.h>
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+using namespace image;
+using namespace utils;
+
+static LinearImage createImage(uint32_t size, uint32_t channels, float offset) {
+    LinearImage image(size, size, channels);
+    float* data = image.getPixelRef();
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                const float phase = float(x * (c + 1)) * 0.05f + float(y) * 0.03f;
+                *data++ = offset + 0.5f + 0.25f * std::sin(phase);
+            }
+        }
+    }
+    return image;
+}
+
+// Arguments are the image dimension and the channel count. The images differ everywhere but stay
+// within epsilon, which is the common case for a passing golden image and forces a full scan.
+// Throughput is reported in pixels.
+static void BM_compare(benchmark::State& state) {
+    const uint32_t size = uint32_t(state.range(0));
+    const uint32_t channels = uint32_t(state.range(1));
+    const LinearImage result = createImage(size, channels, 0.001f);
+    const LinearImage golden = createImage(size, channels, 0.0f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compare(result, golden, 0.01f));
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+}
+
+static void BM_computeDiff(benchmark::State& state) {
+    const uint32_t size = uint32_t(state.range(0));
+    const uint32_t channels = uint32_t(state.range(1));
+    const LinearImage result = createImage(size, channels, 0.001f);
+    const LinearImage golden = createImage(size, channels, 0.0f);
+    DiffOptions options;
+    options.epsilon = 0.01f;
+    for (auto _ : state) {
+        DiffResult diff = computeDiff(result, golden, options);
+        benchmark::DoNotOptimize(diff.maxError);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+}
+
+static void BM_computeDiffJobSystem(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const uint32_t size = uint32_t(state.range(0));
+    const uint32_t channels = uint32_t(state.range(1));
+    const LinearImage result = createImage(size, channels, 0.001f);
+    const LinearImage golden = createImage(size, channels, 0.0f);
+    DiffOptions options;
+    options.epsilon = 0.01f;
+    options.heatmap = state.range(2) != 0;
+    for (auto _ : state) {
+        DiffResult diff = computeDiff(result, golden, options, &js);
+        benchmark::DoNotOptimize(diff.maxError);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_compare)
+        ->Args({ 1024, 3 })
+        ->Args({ 2048, 4 })
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_computeDiff)
+        ->Args({ 1024, 3 })
+        ->Args({ 2048, 4 })
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_computeDiffJobSystem)
+        ->Args({ 1024, 3, 0 })
+        ->Args({ 2048, 4, 0 })
+        ->Args({ 2048, 4, 1 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
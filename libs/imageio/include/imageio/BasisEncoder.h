@@ -27,6 +27,7 @@ namespace image {
 
 struct BasisEncoderBuilderImpl;
 struct BasisEncoderImpl;
+struct BasisJobPoolImpl;
 
 class UTILS_PUBLIC BasisEncoder {
 public:
@@ -35,6 +36,54 @@ public:
         ETC1S,
     };
 
+    /**
+     * Trades encoding speed for quality. DEFAULT matches the defaults of the basisu tool.
+     *
+     * For UASTC this selects the pack level, for ETC1S it selects both the compression level and
+     * the quality level.
+     */
+    enum class Quality {
+        FASTEST,
+        FAST,
+        DEFAULT,
+        HIGH,
+        HIGHEST,
+    };
+
+    /**
+     * Statistics gathered by encode(), useful to balance the work of batch pipelines.
+     */
+    struct Stats {
+        /** Time spent converting the miplevels to the format expected by BasisU. */
+        uint64_t conversionNanoseconds;
+        /** Time spent compressing and writing the KTX2 data. */
+        uint64_t compressionNanoseconds;
+    };
+
+    /**
+     * Pool of worker threads that can be shared by several encoders, which avoids spawning new
+     * threads for every texture.
+     *
+     * Encoders that share a pool must call encode() one at a time, since each encoder waits for
+     * all the jobs in the pool to complete. The pool must outlive the encoders that use it.
+     */
+    class UTILS_PUBLIC JobPool {
+    public:
+        /**
+         * Creates a pool with the given total number of threads, including the calling thread.
+         * Zero selects the number of hardware threads.
+         */
+        explicit JobPool(size_t threadCount = 0);
+        ~JobPool() noexcept;
+
+    private:
+        JobPool(const JobPool&) = delete;
+        JobPool& operator=(const JobPool&) = delete;
+        BasisJobPoolImpl* mImpl;
+        friend struct BasisEncoderBuilderImpl;
+        friend class BasisEncoder;
+    };
+
     class Builder {
     public:
         /**
@@ -100,10 +149,28 @@ public:
         /**
          * Initializes the basis encoder with the given number of jobs.
          *
+         * This is ignored when a shared job pool is specified.
+         *
          * default value: 4
          */
         Builder& jobs(size_t count) noexcept;
 
+        /**
+         * Uses the given job pool instead of creating one for this encoder.
+         *
+         * The pool is also used to convert all miplevels in parallel.
+         *
+         * default value: null
+         */
+        Builder& jobPool(JobPool* pool) noexcept;
+
+        /**
+         * Selects the speed / quality trade-off.
+         *
+         * default value: DEFAULT
+         */
+        Builder& quality(Quality quality) noexcept;
+
         /**
          * Supresses status messages.
          *
@@ -114,7 +181,8 @@ public:
         /**
          * Submits image data in linear floating-point format.
          *
-         * This must be called for every miplevel.
+         * This must be called for every miplevel. The conversion to the BasisU format is deferred
+         * to build(), which converts all miplevels in parallel.
          */
         Builder& miplevel(size_t mipIndex, size_t layerIndex, const LinearImage& image) noexcept;
 
@@ -157,6 +225,11 @@ public:
      */
     uint8_t const* getKtx2Data() const noexcept;
 
+    /**
+     * Returns the statistics gathered by build() and encode().
+     */
+    Stats getStats() const noexcept;
+
 private:
     BasisEncoder(BasisEncoderImpl*) noexcept;
     BasisEncoder(const BasisEncoder&) = delete;
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMAGE_BATCHMANIFEST_H_
+#define IMAGE_BATCHMANIFEST_H_
+
+#include <utils/compiler.h>
+#include <utils/ContentHasher.h>
+#include <utils/Path.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace image {
+
+/**
+ * List of work items for the batch mode of command line tools such as mipgen and cmgen.
+ *
+ * Each line of the manifest describes one item as a list of whitespace separated fields, empty
+ * lines and lines that start with '#' are ignored. The meaning of the fields is up to the tool.
+ *
+ * The manifest also remembers the content hash of every item that was processed successfully,
+ * in a stamp file that lives next to the manifest. This allows tools to skip items whose inputs
+ * and options have not changed since the last run. Delete the stamp file to force a full rebuild.
+ */
+class UTILS_PUBLIC BatchManifest {
+public:
+    using Entry = std::vector<std::string>;
+    using Hash = utils::ContentHasher::Digest;
+
+    explicit BatchManifest(const utils::Path& path);
+
+    // Returns false if the manifest could not be read.
+    bool isValid() const noexcept { return mValid; }
+
+    std::vector<Entry> const& getEntries() const noexcept { return mEntries; }
+
+    // Computes a hash of the contents of the given file, combined with the given seed.
+    // Returns an empty hash if the file cannot be read.
+    static Hash hashFile(const utils::Path& path, Hash const& seed);
+
+    // Computes a hash of the given string.
+    static Hash hashString(const std::string& str) noexcept;
+
+    // Returns true if the item identified by the given key was last processed with this hash.
+    bool isUpToDate(const std::string& key, Hash const& hash) const;
+
+    // Records that the item identified by the given key has been processed with this hash.
+    void setUpToDate(const std::string& key, Hash const& hash);
+
+    // Writes the stamp file, returns false on failure.
+    bool saveStamps() const;
+
+private:
+    utils::Path mStampPath;
+    std::vector<Entry> mEntries;
+    std::unordered_map<std::string, Hash> mStamps;
+    bool mValid = false;
+};
+
+} // namespace image
+
+#endif /* IMAGE_BATCHMANIFEST_H_ */
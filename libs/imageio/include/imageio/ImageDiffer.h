@@ -16,8 +16,18 @@
 
 #include <image/LinearImage.h>
 
+#include <utils/compiler.h>
 #include <utils/Path.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 enum class ComparisonMode {
@@ -26,6 +36,59 @@ enum class ComparisonMode {
     UPDATE,
 };
 
+struct DiffOptions {
+    // A pixel fails when the absolute difference of any of its channels exceeds this value.
+    float epsilon = 0.0f;
+
+    // Statistics are gathered over square tiles of this size.
+    uint32_t tileSize = 256;
+
+    // Stops comparing once more than this many pixels have failed. Zero compares all pixels.
+    size_t maxFailingPixels = 0;
+
+    // Produces a single-channel image holding the largest channel error of each pixel.
+    bool heatmap = false;
+};
+
+// Statistics of a single tile. Errors are absolute per-channel differences.
+struct DiffTile {
+    uint32_t left;
+    uint32_t top;
+    uint32_t width;
+    uint32_t height;
+    float maxError;
+    float meanError;
+    size_t failingPixels;
+};
+
+struct DiffResult {
+    // False if the images do not have the same dimensions and channel count.
+    bool comparable = false;
+
+    // False if comparison stopped early because of DiffOptions::maxFailingPixels, in which case
+    // the statistics only cover part of the image.
+    bool complete = true;
+
+    float maxError = 0.0f;
+    float meanError = 0.0f;
+    size_t failingPixels = 0;
+
+    // Tiles are stored in row-major order.
+    uint32_t tileCountX = 0;
+    uint32_t tileCountY = 0;
+    std::vector<DiffTile> tiles;
+
+    // Only valid if DiffOptions::heatmap was set, pixels that were not compared are zero.
+    LinearImage heatmap;
+
+    bool passed() const noexcept { return comparable && failingPixels == 0; }
+};
+
+// Compares two images tile by tile. The tiles are processed in parallel when a job system is
+// given. Unless the comparison stops early, the statistics do not depend on the scheduling.
+UTILS_PUBLIC DiffResult computeDiff(const LinearImage& result, const LinearImage& golden,
+        const DiffOptions& options = {}, utils::JobSystem* js = nullptr);
+
 // Saves an image to disk or does a load-and-compare, depending on comparison mode.
 // This makes it easy for unit tests to have compare / update commands.
 // The passed-in image is the "result image" and the expected image is the "golden image".
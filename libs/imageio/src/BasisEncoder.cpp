@@ -20,6 +20,12 @@
 #include <image/ImageOps.h>
 #include <utils/debug.h>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warray-bounds"
 #include <basisu_comp.h>
@@ -29,8 +35,27 @@ namespace image {
 
 using Builder = BasisEncoder::Builder;
 
+using Clock = std::chrono::steady_clock;
+
+static uint64_t nanosecondsSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+struct BasisJobPoolImpl {
+    basisu::job_pool pool;
+};
+
+// A miplevel whose conversion to 8-bit is deferred until build() time.
+struct PendingLevel {
+    LinearImage image;
+    basisu::image* target;
+};
+
 struct BasisEncoderBuilderImpl {
     basisu::basis_compressor_params params = {};
+    std::vector<PendingLevel> levels;
+    BasisEncoder::JobPool* pool = nullptr;
+    BasisEncoder::Quality quality = BasisEncoder::Quality::DEFAULT;
     bool grayscale = false;
     bool linear = false;
     bool normals = false;
@@ -41,10 +66,41 @@ struct BasisEncoderBuilderImpl {
 
 struct BasisEncoderImpl {
     basisu::basis_compressor* encoder;
-    basisu::job_pool* jobs;
+    basisu::job_pool* jobs; // owned by the encoder, unless a shared pool was specified
+    BasisEncoder::Stats stats;
     bool quiet;
 };
 
+BasisEncoder::JobPool::JobPool(size_t threadCount) : mImpl(new BasisJobPoolImpl{
+        basisu::job_pool(uint32_t(threadCount ? threadCount :
+                std::max(1u, std::thread::hardware_concurrency()))) }) {
+}
+
+BasisEncoder::JobPool::~JobPool() noexcept { delete mImpl; }
+
+static void convertLevel(const BasisEncoderBuilderImpl& builder, const PendingLevel& level) {
+    const LinearImage& floatImage = level.image;
+    basisu::image* basisImage = level.target;
+
+    LinearImage sourceImage = builder.normals ? vectorsToColors(floatImage) : floatImage;
+
+    const bool applyTransferFunction = !builder.linear;
+
+    if (builder.grayscale) {
+        std::unique_ptr<uint8_t[]> data = applyTransferFunction ?
+            fromLinearTosRGB<uint8_t, 1>(sourceImage) : fromLinearToGrayscale<uint8_t>(sourceImage);
+        basisImage->init(data.get(), floatImage.getWidth(), floatImage.getHeight(), 1);
+    } else if (sourceImage.getChannels() == 4) {
+        std::unique_ptr<uint8_t[]> data = applyTransferFunction ?
+            fromLinearTosRGB<uint8_t, 4>(sourceImage) : fromLinearToRGB<uint8_t, 4>(sourceImage);
+        basisImage->init(data.get(), floatImage.getWidth(), floatImage.getHeight(), 4);
+    } else {
+        std::unique_ptr<uint8_t[]> data = applyTransferFunction ?
+            fromLinearTosRGB<uint8_t, 3>(sourceImage) : fromLinearToRGB<uint8_t, 3>(sourceImage);
+        basisImage->init(data.get(), floatImage.getWidth(), floatImage.getHeight(), 3);
+    }
+}
+
 Builder::Builder(size_t mipCount, size_t layerCount) noexcept : mImpl(new BasisEncoderBuilderImpl) {
     const bool multiple = mImpl->params.m_source_images.size() > 1;
     mImpl->params.m_tex_type = multiple ? basist::cBASISTexType2DArray : basist::cBASISTexType2D;
@@ -86,28 +142,15 @@ Builder& Builder::miplevel(size_t level, size_t layer, const LinearImage& floatI
     }
     basisu::image* basisImage = level == 0 ? &basisBaseLevel : &basisMipmaps[level - 1];
 
-    LinearImage sourceImage = mImpl->normals ? vectorsToColors(floatImage) : floatImage;
-
-    const bool applyTransferFunction = !mImpl->linear;
-
-    if (mImpl->grayscale) {
-        std::unique_ptr<uint8_t[]> data = applyTransferFunction ?
-            fromLinearTosRGB<uint8_t, 1>(sourceImage) : fromLinearToGrayscale<uint8_t>(sourceImage);
-        basisImage->init(data.get(), floatImage.getWidth(), floatImage.getHeight(), 1);
-    } else if (sourceImage.getChannels() == 4) {
-        std::unique_ptr<uint8_t[]> data = applyTransferFunction ?
-            fromLinearTosRGB<uint8_t, 4>(sourceImage) : fromLinearToRGB<uint8_t, 4>(sourceImage);
-        basisImage->init(data.get(), floatImage.getWidth(), floatImage.getHeight(), 4);
-    } else if (sourceImage.getChannels() == 3) {
-        std::unique_ptr<uint8_t[]> data = applyTransferFunction ?
-            fromLinearTosRGB<uint8_t, 3>(sourceImage) : fromLinearToRGB<uint8_t, 3>(sourceImage);
-        basisImage->init(data.get(), floatImage.getWidth(), floatImage.getHeight(), 3);
-    } else {
+    const size_t channels = floatImage.getChannels();
+    if (!mImpl->grayscale && channels != 3 && channels != 4) {
         assert_invariant(false);
         mImpl->error = true;
         return *this;
     }
 
+    // LinearImage has reference semantics, so this does not copy the pixels.
+    mImpl->levels.push_back({ floatImage, basisImage });
     return *this;
 }
 
@@ -146,6 +189,16 @@ Builder& Builder::jobs(size_t count) noexcept {
     return *this;
 }
 
+Builder& Builder::jobPool(JobPool* pool) noexcept {
+    mImpl->pool = pool;
+    return *this;
+}
+
+Builder& Builder::quality(Quality quality) noexcept {
+    mImpl->quality = quality;
+    return *this;
+}
+
 Builder& Builder::quiet(bool enabled) noexcept {
     mImpl->quiet = enabled;
     return *this;
@@ -161,7 +214,18 @@ BasisEncoder* Builder::build() {
     auto& params = mImpl->params;
 
     params.m_status_output = !mImpl->quiet;
-    params.m_pJob_pool = new basisu::job_pool(mImpl->jobs);
+    params.m_pJob_pool = mImpl->pool ? &mImpl->pool->mImpl->pool :
+            new basisu::job_pool(uint32_t(std::max(size_t(1), mImpl->jobs)));
+    basisu::job_pool* const ownedPool = mImpl->pool ? nullptr : params.m_pJob_pool;
+
+    // Convert all miplevels at once, they are independent of each other.
+    const Clock::time_point conversionStart = Clock::now();
+    for (auto const& level : mImpl->levels) {
+        params.m_pJob_pool->add_job([this, &level]() { convertLevel(*mImpl, level); });
+    }
+    params.m_pJob_pool->wait_for_all();
+    mImpl->levels.clear();
+    const uint64_t conversionNanoseconds = nanosecondsSince(conversionStart);
     params.m_create_ktx2_file = true;
     params.m_ktx2_uastc_supercompression = basist::KTX2_SS_ZSTANDARD;
 
@@ -171,8 +235,20 @@ BasisEncoder* Builder::build() {
     // SHOULD know about this, since in some scenarios it needs to interpolate between colors.
     params.m_ktx2_srgb_transfer_func = !mImpl->linear;
 
-    // Select the same quality that the basis tool selects by default (midpoint of range).
-    params.m_quality_level = 128;
+    // The DEFAULT rung selects the same settings as the basis tool (midpoint of the quality range
+    // and default compression level), every other rung moves both speed and quality one step.
+    struct Rung { uint32_t uastcLevel; int etc1sLevel; int etc1sQuality; };
+    static constexpr Rung kLadder[] = {
+        { basisu::cPackUASTCLevelFastest,  0,  64 },
+        { basisu::cPackUASTCLevelFaster,   1,  96 },
+        { basisu::cPackUASTCLevelDefault,  2, 128 },
+        { basisu::cPackUASTCLevelSlower,   3, 192 },
+        { basisu::cPackUASTCLevelVerySlow, 5, 255 },
+    };
+    const Rung& rung = kLadder[size_t(mImpl->quality)];
+    params.m_pack_uastc_flags = rung.uastcLevel;
+    params.m_compression_level = rung.etc1sLevel;
+    params.m_quality_level = rung.etc1sQuality;
 
     // This is the default zstd compression level used by the basisu cmdline cool.
     params.m_ktx2_zstd_supercompression_level = 6;
@@ -188,12 +264,14 @@ BasisEncoder* Builder::build() {
     if (!encoder->init(params)) {
         assert_invariant(false);
         delete encoder;
+        delete ownedPool;
         return nullptr;
     }
 
     return new BasisEncoder(new BasisEncoderImpl {
         .encoder = encoder,
-        .jobs = params.m_pJob_pool,
+        .jobs = ownedPool,
+        .stats = { .conversionNanoseconds = conversionNanoseconds },
         .quiet = mImpl->quiet,
     });
 }
@@ -218,7 +296,9 @@ BasisEncoder& BasisEncoder::operator=(BasisEncoder&& that) noexcept {
 
 bool BasisEncoder::encode() {
     using namespace basisu;
+    const Clock::time_point start = Clock::now();
     basis_compressor::error_code ec = mImpl->encoder->process();
+    mImpl->stats.compressionNanoseconds = nanosecondsSince(start);
     switch (ec)
     {
     case basis_compressor::cECSuccess:
@@ -271,4 +351,8 @@ uint8_t const* BasisEncoder::getKtx2Data() const noexcept {
     return mImpl->encoder->get_output_ktx2_file().data();
 }
 
+BasisEncoder::Stats BasisEncoder::getStats() const noexcept {
+    return mImpl->stats;
+}
+
 } // namespace image
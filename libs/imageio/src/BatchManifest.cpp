@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <imageio/BatchManifest.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace image {
+
+namespace {
+
+// Stamps are stored as 32 hexadecimal digits, most significant first.
+constexpr size_t kHashDigits = 32;
+
+bool parseHash(const std::string& text, BatchManifest::Hash* hash) {
+    if (text.size() != kHashDigits) {
+        return false;
+    }
+    char* end = nullptr;
+    hash->high = strtoull(text.substr(0, kHashDigits / 2).c_str(), &end, 16);
+    if (*end) {
+        return false;
+    }
+    hash->low = strtoull(text.substr(kHashDigits / 2).c_str(), &end, 16);
+    return !*end;
+}
+
+} // anonymous namespace
+
+BatchManifest::BatchManifest(const utils::Path& path)
+        : mStampPath(path.getPath() + ".stamps") {
+    std::ifstream in(path.getPath());
+    if (!in) {
+        return;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        std::string field;
+        while (fields >> field) {
+            entry.push_back(field);
+        }
+        if (!entry.empty() && entry[0][0] != '#') {
+            mEntries.push_back(std::move(entry));
+        }
+    }
+    mValid = true;
+
+    std::ifstream stamps(mStampPath.getPath());
+    std::string text;
+    std::string key;
+    while (stamps >> text >> key) {
+        Hash hash;
+        if (parseHash(text, &hash)) {
+            mStamps[key] = hash;
+        }
+    }
+}
+
+BatchManifest::Hash BatchManifest::hashFile(const utils::Path& path, Hash const& seed) {
+    std::ifstream in(path.getPath(), std::ios::binary);
+    if (!in) {
+        return {};
+    }
+    constexpr size_t kBufferSize = 1u << 16u;
+    std::unique_ptr<char[]> buffer(new char[kBufferSize]);
+    utils::ContentHasher hasher;
+    hasher.add(seed);
+    while (in) {
+        in.read(buffer.get(), kBufferSize);
+        hasher.add(buffer.get(), size_t(in.gcount()));
+    }
+    return hasher.get();
+}
+
+BatchManifest::Hash BatchManifest::hashString(const std::string& str) noexcept {
+    return utils::ContentHasher().add(str.data(), str.size()).get();
+}
+
+bool BatchManifest::isUpToDate(const std::string& key, Hash const& hash) const {
+    auto iter = mStamps.find(key);
+    return hash != Hash{} && iter != mStamps.end() && iter->second == hash;
+}
+
+void BatchManifest::setUpToDate(const std::string& key, Hash const& hash) {
+    mStamps[key] = hash;
+}
+
+bool BatchManifest::saveStamps() const {
+    std::ofstream out(mStampPath.getPath(), std::ios::trunc);
+    char text[kHashDigits + 1];
+    for (auto const& [key, hash] : mStamps) {
+        snprintf(text, sizeof(text), "%016llx%016llx",
+                (unsigned long long) hash.high, (unsigned long long) hash.low);
+        out << text << " " << key << "\n";
+    }
+    return bool(out);
+}
+
+} // namespace image
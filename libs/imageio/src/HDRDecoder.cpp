@@ -22,6 +22,7 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <cstring>
 #include <limits>
 #include <memory>
@@ -58,6 +59,99 @@ HDRDecoder::HDRDecoder(std::istream& stream)
 
 HDRDecoder::~HDRDecoder() = default;
 
+namespace {
+
+using filament::math::float3;
+
+// Number of rows decoded before they are handed back to the image, see LinearImage::releaseRows().
+constexpr uint32_t kBandHeight = 64;
+
+// Reads the pixel data in large blocks, rather than issuing a stream read for every run-length
+// byte, which dominates the decoding time of large images otherwise.
+class BufferedReader {
+public:
+    explicit BufferedReader(std::istream& stream) : mStream(stream) { }
+
+    bool read(void* dst, size_t size) {
+        uint8_t* out = (uint8_t*) dst;
+        while (size > 0) {
+            if (mHead == mTail && !fill()) {
+                return false;
+            }
+            const size_t n = std::min(size, mTail - mHead);
+            memcpy(out, mBuffer + mHead, n);
+            mHead += n;
+            out += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    // Returns a pointer to the next `size` bytes without consuming them, or null at the end of
+    // the stream. `size` must be small.
+    uint8_t const* peek(size_t size) {
+        if (mTail - mHead < size) {
+            memmove(mBuffer, mBuffer + mHead, mTail - mHead);
+            mTail -= mHead;
+            mHead = 0;
+            mStream.read((char*) mBuffer + mTail, std::streamsize(sizeof(mBuffer) - mTail));
+            mTail += size_t(mStream.gcount());
+            if (mTail < size) {
+                return nullptr;
+            }
+        }
+        return mBuffer + mHead;
+    }
+
+private:
+    bool fill() {
+        mStream.read((char*) mBuffer, sizeof(mBuffer));
+        mHead = 0;
+        mTail = size_t(mStream.gcount());
+        return mTail > 0;
+    }
+
+    std::istream& mStream;
+    size_t mHead = 0;
+    size_t mTail = 0;
+    uint8_t mBuffer[64 * 1024];
+};
+
+// Returns 2^(e - 128) / 256, i.e. the scale applied to the (rgb + 0.5) mantissas of an RGBE texel,
+// or 0 when e is 0. The float is assembled directly from the exponent, rather than calling
+// ldexp() or doing a table lookup, so that the loops below are branchless and vectorize. The
+// result is bit-identical to the ldexp() formulation, including for denormals.
+inline float rgbeScale(uint32_t e) noexcept {
+    // biased exponent of 2^(e - 128) is e - 1, and e == 1 is the largest denormal, 2^-127
+    const uint32_t bits = e > 1 ? (e - 1) << 23 : e << 22;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return scale * (1.0f / 256.0f);
+}
+
+void decodeInterleaved(float3* UTILS_RESTRICT dst, uint8_t const* UTILS_RESTRICT rgbe,
+        size_t width) noexcept {
+    for (size_t x = 0; x < width; x++, rgbe += 4) {
+        const float scale = rgbeScale(rgbe[3]);
+        dst[x].r = (float(rgbe[0]) + 0.5f) * scale;
+        dst[x].g = (float(rgbe[1]) + 0.5f) * scale;
+        dst[x].b = (float(rgbe[2]) + 0.5f) * scale;
+    }
+}
+
+void decodePlanar(float3* UTILS_RESTRICT dst, uint8_t const* UTILS_RESTRICT r,
+        uint8_t const* UTILS_RESTRICT g, uint8_t const* UTILS_RESTRICT b,
+        uint8_t const* UTILS_RESTRICT e, size_t width) noexcept {
+    for (size_t x = 0; x < width; x++) {
+        const float scale = rgbeScale(e[x]);
+        dst[x].r = (float(r[x]) + 0.5f) * scale;
+        dst[x].g = (float(g[x]) + 0.5f) * scale;
+        dst[x].b = (float(b[x]) + 0.5f) * scale;
+    }
+}
+
+} // anonymous namespace
+
 LinearImage HDRDecoder::decode() {
     float gamma;
     float exposure;
@@ -68,6 +162,10 @@ LinearImage HDRDecoder::decode() {
         do {
             char format[128];
             mStream.getline(buf, sizeof(buf), 0xa);
+            if (!mStream) {
+                slog.e << "invalid header" << io::endl;
+                return {};
+            }
             if (buf[0] == '#') continue;
             sscanf(buf, "FORMAT=%127s", format); // NOLINT
             sscanf(buf, "GAMMA=%f", &gamma); // NOLINT
@@ -83,63 +181,88 @@ LinearImage HDRDecoder::decode() {
     if (sx == '-') image = (image);
     if (sy == '+') image = verticalFlip(image);
 
+    // Scanlines are decoded straight into the image. Memory-mapped images are written back one
+    // band at a time, which keeps the working set small for very large panoramas.
+    auto endRow = [&image](uint32_t y) {
+        if ((y + 1) % kBandHeight == 0) {
+            image.releaseRows(y + 1 - kBandHeight, kBandHeight);
+        }
+    };
+
+    BufferedReader reader(mStream);
+
     // Allocate memory to hold one row of decoded pixel data.
     std::unique_ptr<uint8_t[]> rgbe(new uint8_t[width * 4]);
 
     // First, test for non-RLE images.
-    const auto pos = mStream.tellg();
-    mStream.read((char*) rgbe.get(), 3);
-    mStream.seekg(pos);
+    uint8_t const* head = reader.peek(3);
+    if (!head) {
+        slog.e << "missing pixel data" << io::endl;
+        return {};
+    }
 
-    if (rgbe[0] != 0x2 || rgbe[1] != 0x2 || (rgbe[2] & 0x80) || width < 8 || width > 32767) {
+    if (head[0] != 0x2 || head[1] != 0x2 || (head[2] & 0x80) || width < 8 || width > 32767) {
         for (uint32_t y = 0; y < height; y++) {
-            filament::math::float3* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
-            mStream.read((char*) rgbe.get(), width * 4);
-            // (rgb/256) * 2^(e-128)
-            size_t pixel = 0;
-            for (size_t x = 0; x < width; x++, pixel += 4) {
-                if (rgbe[pixel + 3] == 0.0f) {
-                    dst[x] = filament::math::float3{0.0f};
-                } else {
-                    filament::math::float3 v(rgbe[pixel], rgbe[pixel + 1], rgbe[pixel + 2]);
-                    dst[x] = (v + 0.5f) * std::ldexp(1.0f, rgbe[pixel + 3] - (128 + 8));
-                }
+            float3* dst = reinterpret_cast<float3*>(image.getPixelRef(0, y));
+            if (!reader.read(rgbe.get(), width * 4)) {
+                slog.e << "truncated pixel data" << io::endl;
+                return {};
             }
+            decodeInterleaved(dst, rgbe.get(), width);
+            endRow(y);
         }
     } else {
         for (uint32_t y = 0; y < height; y++) {
-            uint16_t magic;
-            mStream.read((char*) &magic, 2);
-            if (magic != 0x0202) {
+            uint8_t header[4];
+            if (!reader.read(header, 4)) {
+                slog.e << "truncated pixel data" << io::endl;
+                return {};
+            }
+
+            if (header[0] != 0x2 || header[1] != 0x2) {
                 slog.e << "invalid scanline (magic)" << io::endl;
                 return {};
             }
 
             uint16_t w;
-            mStream.read((char*) &w, 2);
+            memcpy(&w, header + 2, 2);
             if (ntohs(w) != width) {
                 slog.e << "invalid scanline (width)" << io::endl;
                 return {};
             }
 
-            char* d = (char*) rgbe.get();
+            uint8_t* d = rgbe.get();
             for (size_t p = 0; p < 4; p++) {
                 size_t num_bytes = 0;
                 while (num_bytes < width) {
-                    uint8_t rle_count;
-                    mStream.read((char*) &rle_count, 1);
+                    uint8_t packet[2];
+                    if (!reader.read(packet, 1)) {
+                        slog.e << "truncated pixel data" << io::endl;
+                        return {};
+                    }
+                    const size_t rle_count = packet[0];
                     if (rle_count > 128) {
-                        char v;
-                        mStream.read(&v, 1);
-                        memset(d, v, size_t(rle_count - 128));
-                        d += rle_count - 128;
-                        num_bytes += rle_count - 128;
+                        const size_t count = std::min(rle_count - 128, width - num_bytes);
+                        if (!reader.read(packet + 1, 1)) {
+                            slog.e << "truncated pixel data" << io::endl;
+                            return {};
+                        }
+                        memset(d, packet[1], count);
+                        d += count;
+                        num_bytes += count;
                     } else {
                         if (rle_count == 0) {
                             slog.e << "run length is zero" << io::endl;
                             return {};
                         }
-                        mStream.read(d, rle_count);
+                        if (rle_count > width - num_bytes) {
+                            slog.e << "run length overflows scanline" << io::endl;
+                            return {};
+                        }
+                        if (!reader.read(d, rle_count)) {
+                            slog.e << "truncated pixel data" << io::endl;
+                            return {};
+                        }
                         d += rle_count;
                         num_bytes += rle_count;
                     }
@@ -150,16 +273,9 @@ LinearImage HDRDecoder::decode() {
             uint8_t const* g = &rgbe[width];
             uint8_t const* b = &rgbe[2 * width];
             uint8_t const* e = &rgbe[3 * width];
-            filament::math::float3* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
-            // (rgb/256) * 2^(e-128)
-            for (size_t x = 0; x < width; x++, r++, g++, b++, e++) {
-                if (e[0] == 0.0f) {
-                    dst[x] = filament::math::float3{0.0f};
-                } else {
-                    filament::math::float3 v(r[0], g[0], b[0]);
-                    dst[x] = (v + 0.5f) * std::ldexp(1.0f, e[0] - (128 + 8));
-                }
-            }
+            float3* dst = reinterpret_cast<float3*>(image.getPixelRef(0, y));
+            decodePlanar(dst, r, g, b, e, width);
+            endRow(y);
         }
     }
 
@@ -18,6 +18,7 @@
 
 #include <imageio/ImageDecoder.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring> // for memcmp
 #include <iostream> // for cerr
@@ -447,25 +448,87 @@ EXRDecoder::EXRDecoder(std::istream& stream, const std::string& sourceName)
 
 EXRDecoder::~EXRDecoder() = default;
 
+namespace {
+
+// Copies the remainder of the stream into memory, with a single allocation when the stream size
+// is known.
+std::vector<unsigned char> readRemainder(std::istream& stream) {
+    std::vector<unsigned char> src;
+    const std::streampos start = stream.tellg();
+    if (start != std::streampos(-1) && stream.seekg(0, std::ios::end)) {
+        const std::streampos end = stream.tellg();
+        stream.seekg(start);
+        if (end != std::streampos(-1) && end >= start) {
+            src.resize(size_t(end - start));
+            stream.read(reinterpret_cast<char*>(src.data()), std::streamsize(src.size()));
+            src.resize(size_t(stream.gcount()));
+            return src;
+        }
+    }
+    stream.clear();
+    unsigned char buffer[4096];
+    while (stream.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) {
+        src.insert(src.end(), &buffer[0], &buffer[4096]);
+    }
+    src.insert(src.end(), &buffer[0], &buffer[stream.gcount()]);
+    return src;
+}
+
+// Frees the tinyexr structures however decode() exits.
+struct EXRScope {
+    EXRHeader header;
+    EXRImage image;
+    EXRScope() { InitEXRHeader(&header); InitEXRImage(&image); }
+    ~EXRScope() { FreeEXRImage(&image); FreeEXRHeader(&header); }
+};
+
+// Interleaves a block of planar float channels into the RGB destination image.
+void copyChannels(LinearImage& image, float const* r, float const* g, float const* b,
+        uint32_t srcStride, uint32_t x0, uint32_t y0, uint32_t width, uint32_t height) {
+    for (uint32_t y = 0; y < height; y++) {
+        filament::math::float3* UTILS_RESTRICT dst =
+                reinterpret_cast<filament::math::float3*>(image.getPixelRef(x0, y0 + y));
+        const size_t offset = size_t(y) * srcStride;
+        for (uint32_t x = 0; x < width; x++) {
+            dst[x] = { r[offset + x], g[offset + x], b[offset + x] };
+        }
+    }
+}
+
+} // anonymous namespace
+
+// Unlike LoadEXRFromMemory(), the decoded channels are written straight into the LinearImage,
+// which avoids an intermediate RGBA copy of the whole image. The compressed chunks themselves are
+// decompressed in parallel by tinyexr (see TINYEXR_USE_THREAD).
 LinearImage EXRDecoder::decode() {
     try {
         // copy the EXR data in memory
-        std::vector<unsigned char> src;
-        unsigned char buffer[4096];
-        while (mStream.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) {
-            src.insert(src.end(), &buffer[0], &buffer[4096]);
-        }
-        src.insert(src.end(), &buffer[0], &buffer[mStream.gcount()]);
+        std::vector<unsigned char> src = readRemainder(mStream);
 
-        int width;
-        int height;
-        float* rgba;
-        const char* error;
+        const char* error = nullptr;
+        EXRVersion version;
+        EXRScope exr;
 
-        int ret = LoadEXRFromMemory(&rgba, &width, &height, src.data(), src.size(), &error);
+        int ret = ParseEXRVersionFromMemory(&version, src.data(), src.size());
+        if (ret == TINYEXR_SUCCESS) {
+            ret = ParseEXRHeaderFromMemory(&exr.header, &version, src.data(), src.size(), &error);
+        }
+        if (ret == TINYEXR_SUCCESS) {
+            // Read HALF channels as FLOAT.
+            for (int i = 0; i < exr.header.num_channels; i++) {
+                if (exr.header.pixel_types[i] == TINYEXR_PIXELTYPE_HALF) {
+                    exr.header.requested_pixel_types[i] = TINYEXR_PIXELTYPE_FLOAT;
+                }
+            }
+            ret = LoadEXRImageFromMemory(&exr.image, &exr.header, src.data(), src.size(), &error);
+        }
         if (ret != TINYEXR_SUCCESS) {
-            std::cerr << "Could not decode OpenEXR: " << error << std::endl;
-            FreeEXRErrorMessage(error);
+            std::cerr << "Could not decode OpenEXR: " << (error ? error : "invalid file")
+                      << std::endl;
+            if (error) {
+                FreeEXRErrorMessage(error);
+            }
+            mStream.clear();
             mStream.seekg(mStreamStartPos);
             return LinearImage();
         }
@@ -473,22 +536,46 @@ LinearImage EXRDecoder::decode() {
         src.clear();
         src.shrink_to_fit();
 
-        LinearImage image((uint32_t) width, (uint32_t) height, 3);
-
-        size_t i = 0;
-        for (uint32_t y = 0; y < height; y++) {
-            for (uint32_t x = 0; x < width; x++) {
-                filament::math::float3& pixel =
-                        *reinterpret_cast< filament::math::float3*>(image.getPixelRef(x, y));
-                pixel.r = rgba[i++];
-                pixel.g = rgba[i++];
-                pixel.b = rgba[i++];
-                // skip alpha
-                i++;
+        // Grayscale images are replicated to all channels, otherwise R, G and B are required.
+        int idxR = 0, idxG = 0, idxB = 0;
+        if (exr.header.num_channels > 1) {
+            idxR = idxG = idxB = -1;
+            for (int c = 0; c < exr.header.num_channels; c++) {
+                const char* name = exr.header.channels[c].name;
+                if (!strcmp(name, "R")) idxR = c;
+                else if (!strcmp(name, "G")) idxG = c;
+                else if (!strcmp(name, "B")) idxB = c;
+            }
+            if (idxR < 0 || idxG < 0 || idxB < 0) {
+                std::cerr << "Could not decode OpenEXR: R, G or B channel not found" << std::endl;
+                mStream.seekg(mStreamStartPos);
+                return LinearImage();
             }
         }
 
-        free(rgba);
+        const uint32_t width = (uint32_t) exr.image.width;
+        const uint32_t height = (uint32_t) exr.image.height;
+        LinearImage image(width, height, 3);
+
+        if (exr.header.tiled) {
+            const uint32_t tileWidth = (uint32_t) exr.header.tile_size_x;
+            const uint32_t tileHeight = (uint32_t) exr.header.tile_size_y;
+            for (int t = 0; t < exr.image.num_tiles; t++) {
+                EXRTile const& tile = exr.image.tiles[t];
+                float const* const* planes = reinterpret_cast<float const* const*>(tile.images);
+                const uint32_t x0 = uint32_t(tile.offset_x) * tileWidth;
+                const uint32_t y0 = uint32_t(tile.offset_y) * tileHeight;
+                if (x0 >= width || y0 >= height) {
+                    continue;
+                }
+                copyChannels(image, planes[idxR], planes[idxG], planes[idxB], tileWidth,
+                        x0, y0, std::min(tileWidth, width - x0), std::min(tileHeight, height - y0));
+            }
+        } else {
+            float const* const* planes = reinterpret_cast<float const* const*>(exr.image.images);
+            copyChannels(image, planes[idxR], planes[idxG], planes[idxB], width,
+                    0, 0, width, height);
+        }
 
         return image;
     } catch(std::runtime_error& e) {
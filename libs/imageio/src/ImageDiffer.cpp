@@ -20,12 +20,169 @@
 #include <image/ImageOps.h>
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <fstream>
 
 namespace image {
 
+namespace {
+
+// Reductions are spread over this many independent accumulators, which lets the compiler
+// vectorize them without reassociating floating point math.
+constexpr size_t kLanes = 8;
+
+struct RowStats {
+    float maxError;
+    float errorSum;
+    size_t failingPixels;
+};
+
+// Computes the absolute difference of every channel of a row of pixels, and stores the largest
+// difference of each pixel in "pixelErrors". C is the channel count, or 0 for any channel count.
+template<size_t C>
+RowStats diffRow(float const* UTILS_RESTRICT a, float const* UTILS_RESTRICT b,
+        float* UTILS_RESTRICT pixelErrors, size_t width, size_t channels, float epsilon) noexcept {
+    const size_t c = C ? C : channels;
+
+    auto diffPixel = [a, b, c](size_t x, float& sum) {
+        float const* pa = a + x * c;
+        float const* pb = b + x * c;
+        float e = 0.0f;
+        for (size_t k = 0; k < c; ++k) {
+            const float d = std::abs(pa[k] - pb[k]);
+            e = std::max(e, d);
+            sum += d;
+        }
+        return e;
+    };
+
+    float sum[kLanes] = {};
+    float maxError[kLanes] = {};
+    uint32_t failing[kLanes] = {};
+    size_t x = 0;
+    for (; x + kLanes <= width; x += kLanes) {
+        for (size_t l = 0; l < kLanes; ++l) {
+            const float e = diffPixel(x + l, sum[l]);
+            pixelErrors[x + l] = e;
+            maxError[l] = std::max(maxError[l], e);
+            failing[l] += e > epsilon ? 1u : 0u;
+        }
+    }
+    for (; x < width; ++x) {
+        const float e = diffPixel(x, sum[0]);
+        pixelErrors[x] = e;
+        maxError[0] = std::max(maxError[0], e);
+        failing[0] += e > epsilon ? 1u : 0u;
+    }
+
+    RowStats stats{ 0.0f, 0.0f, 0 };
+    for (size_t l = 0; l < kLanes; ++l) {
+        stats.maxError = std::max(stats.maxError, maxError[l]);
+        stats.errorSum += sum[l];
+        stats.failingPixels += failing[l];
+    }
+    return stats;
+}
+
+using DiffRowFn = RowStats(*)(float const*, float const*, float*, size_t, size_t, float);
+
+DiffRowFn selectDiffRow(size_t channels) noexcept {
+    switch (channels) {
+        case 1: return diffRow<1>;
+        case 3: return diffRow<3>;
+        case 4: return diffRow<4>;
+        default: return diffRow<0>;
+    }
+}
+
+} // anonymous namespace
+
+DiffResult computeDiff(const LinearImage& result, const LinearImage& golden,
+        const DiffOptions& options, utils::JobSystem* js) {
+    DiffResult diff;
+    const uint32_t width = result.getWidth();
+    const uint32_t height = result.getHeight();
+    const uint32_t channels = result.getChannels();
+    if (golden.getWidth() != width || golden.getHeight() != height ||
+            golden.getChannels() != channels || !result.isValid()) {
+        return diff;
+    }
+    diff.comparable = true;
+
+    const uint32_t tileSize = std::max(options.tileSize, 1u);
+    diff.tileCountX = (width + tileSize - 1) / tileSize;
+    diff.tileCountY = (height + tileSize - 1) / tileSize;
+    diff.tiles.resize(size_t(diff.tileCountX) * diff.tileCountY);
+    if (options.heatmap) {
+        diff.heatmap = LinearImage(width, height, 1);
+        std::fill_n(diff.heatmap.getPixelRef(), size_t(width) * height, 0.0f);
+    }
+
+    const DiffRowFn diffRowFn = selectDiffRow(channels);
+    std::atomic<size_t> failingPixels{ 0 };
+    std::atomic<bool> stopped{ false };
+
+    auto diffTiles = [&](uint32_t start, uint32_t count) {
+        std::vector<float> pixelErrors(options.heatmap ? 0 : tileSize);
+        for (uint32_t index = start; index < start + count; ++index) {
+            DiffTile& tile = diff.tiles[index];
+            tile.left = (index % diff.tileCountX) * tileSize;
+            tile.top = (index / diff.tileCountX) * tileSize;
+            tile.width = std::min(tileSize, width - tile.left);
+            tile.height = std::min(tileSize, height - tile.top);
+            tile.maxError = 0.0f;
+            tile.meanError = 0.0f;
+            tile.failingPixels = 0;
+            double errorSum = 0.0;
+            for (uint32_t y = tile.top; y < tile.top + tile.height; ++y) {
+                if (stopped.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                const size_t offset = (size_t(y) * width + tile.left) * channels;
+                float* errors = options.heatmap ?
+                        diff.heatmap.getPixelRef(tile.left, y) : pixelErrors.data();
+                const RowStats row = diffRowFn(result.getPixelRef() + offset,
+                        golden.getPixelRef() + offset, errors, tile.width,
+                        channels, options.epsilon);
+                tile.maxError = std::max(tile.maxError, row.maxError);
+                tile.failingPixels += row.failingPixels;
+                errorSum += row.errorSum;
+                if (row.failingPixels && options.maxFailingPixels &&
+                        failingPixels.fetch_add(row.failingPixels, std::memory_order_relaxed) +
+                        row.failingPixels > options.maxFailingPixels) {
+                    stopped.store(true, std::memory_order_relaxed);
+                }
+            }
+            tile.meanError = float(errorSum / (double(tile.width) * tile.height * channels));
+        }
+    };
+
+    const uint32_t tileCount = uint32_t(diff.tiles.size());
+    if (js) {
+        auto* job = utils::jobs::parallel_for(*js, nullptr, 0, tileCount, std::cref(diffTiles),
+                utils::jobs::CountSplitter<1>());
+        js->runAndWait(job);
+    } else {
+        diffTiles(0, tileCount);
+    }
+
+    // Reduce in tile order such that the result is deterministic.
+    double errorSum = 0.0;
+    for (DiffTile const& tile : diff.tiles) {
+        diff.maxError = std::max(diff.maxError, tile.maxError);
+        diff.failingPixels += tile.failingPixels;
+        errorSum += double(tile.meanError) * tile.width * tile.height * channels;
+    }
+    diff.meanError = float(errorSum / (double(width) * height * channels));
+    diff.complete = !stopped.load();
+    return diff;
+}
+
 // TODO: Remove special treatment of 1-channel data.
 void updateOrCompare(LinearImage limgResult, const utils::Path& fnameGolden,
         ComparisonMode mode, float epsilon) {
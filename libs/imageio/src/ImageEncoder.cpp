@@ -368,45 +368,46 @@ bool PNGEncoder::encode(const LinearImage& image) {
 
         png_write_info(mPNG, mInfo);
 
-        std::unique_ptr<png_bytep[]> row_pointers(new png_bytep[height]);
-        std::unique_ptr<uint8_t[]> data;
-
-        uint32_t dstChannels;
-        if (srcChannels == 1) {
-            dstChannels = 1;
-            data = fromLinearToGrayscale<uint8_t>(image);
-        } else {
-            dstChannels = getChannelsCount(colorType);
+        uint32_t dstChannels = srcChannels == 1 ? 1 : getChannelsCount(colorType);
+        auto convert = [this, srcChannels, dstChannels](const LinearImage& band) {
+            if (srcChannels == 1) {
+                return fromLinearToGrayscale<uint8_t>(band);
+            }
             switch (mFormat) {
                 case PixelFormat::RGBM:
-                    data = fromLinearToRGBM<uint8_t>(image);
-                    break;
+                    return fromLinearToRGBM<uint8_t>(band);
                 case PixelFormat::RGB_10_11_11_REV:
-                    data = fromLinearToRGB_10_11_11_REV(image);
-                    break;
+                    return fromLinearToRGB_10_11_11_REV(band);
                 case PixelFormat::sRGB:
-                    if (dstChannels == 4) {
-                        data = fromLinearTosRGB<uint8_t, 4>(image);
-                    } else {
-                        data = fromLinearTosRGB<uint8_t, 3>(image);
-                    }
-                    break;
+                    return dstChannels == 4 ? fromLinearTosRGB<uint8_t, 4>(band) :
+                            fromLinearTosRGB<uint8_t, 3>(band);
                 case PixelFormat::LINEAR_RGB:
-                    if (dstChannels == 4) {
-                        data = fromLinearToRGB<uint8_t, 4>(image);
-                    } else {
-                        data = fromLinearToRGB<uint8_t, 3>(image);
-                    }
-                    break;
+                    return dstChannels == 4 ? fromLinearToRGB<uint8_t, 4>(band) :
+                            fromLinearToRGB<uint8_t, 3>(band);
             }
+            return std::unique_ptr<uint8_t[]>();
+        };
+
+        // Convert and write the image in bands of rows, such that the 8-bit copy of the image
+        // scales with its width rather than its area.
+        constexpr size_t kRowsPerBand = 64;
+        std::unique_ptr<png_bytep[]> row_pointers(new png_bytep[kRowsPerBand]);
+        LinearImage band;
+        for (size_t y = 0; y < height; y += kRowsPerBand) {
+            const size_t rows = std::min(kRowsPerBand, height - y);
+            if (band.getHeight() != rows) {
+                band = LinearImage(uint32_t(width), uint32_t(rows), uint32_t(srcChannels));
+            }
+            memcpy(band.getPixelRef(), image.getPixelRef(0, uint32_t(y)),
+                    sizeof(float) * width * rows * srcChannels);
+            std::unique_ptr<uint8_t[]> data = convert(band);
+            for (size_t row = 0; row < rows; row++) {
+                row_pointers[row] = reinterpret_cast<png_bytep>
+                        (&data[row * width * dstChannels * sizeof(uint8_t)]);
+            }
+            png_write_rows(mPNG, row_pointers.get(), png_uint_32(rows));
+            image.releaseRows(uint32_t(y), uint32_t(rows));
         }
-
-        for (size_t y = 0; y < height; y++) {
-            row_pointers[y] = reinterpret_cast<png_bytep>
-                    (&data[y * width * dstChannels * sizeof(uint8_t)]);
-        }
-
-        png_write_image(mPNG, row_pointers.get());
         png_write_end(mPNG, mInfo);
         mStream.flush();
     } catch (std::runtime_error& e) {
@@ -123,17 +123,51 @@ class Ktx2Reader {
              */
             Texture* getTexture() const noexcept;
 
+            /**
+             * Returns the number of miplevels in the texture.
+             */
+            uint32_t getLevelCount() const noexcept;
+
             /**
              * Loads all mipmaps from the KTX2 file and transcodes them to the resolved format.
              *
-             * This does not return until all mipmaps have been transcoded. This is typically
-             * called from a background thread.
+             * Levels are transcoded from smallest to largest. This does not return until all
+             * mipmaps have been transcoded. This is typically called from a background thread.
              */
             Result doTranscoding();
 
+            /**
+             * Transcodes a single miplevel to the resolved format.
+             *
+             * This can be called concurrently for different levels of the same texture, which
+             * allows clients to spread the transcoding of large textures across several threads.
+             * Each level must be transcoded only once.
+             */
+            Result doTranscoding(uint32_t levelIndex);
+
+            /**
+             * Statistics gathered while transcoding, useful for profiling asset loading.
+             */
+            struct Stats {
+                /** Sum of the time spent transcoding each level, across all threads. */
+                uint64_t transcodeNanoseconds;
+                /** Largest amount of transcoded data that was awaiting upload at any time. */
+                size_t peakPendingBytes;
+            };
+
+            /**
+             * Returns the statistics gathered so far. This can be called from any thread.
+             */
+            Stats getStats() const noexcept;
+
             /**
              * Uploads pending mipmaps to the texture.
              *
+             * Pending levels are uploaded from smallest to largest, stopping at the first level
+             * that has not been transcoded yet; it and the larger levels are uploaded by a later
+             * call. Transcoded buffers are handed to Texture::setImage() along with a release
+             * callback, so they are not copied.
+             *
              * This can safely be called while doTranscoding() is still working in another thread.
              * Since this calls Texture::setImage(), it should be called from the foreground thread;
              * see "Thread safety" in the documentation for filament::Engine.
@@ -21,7 +21,9 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <vector>
 
 #pragma clang diagnostic push
@@ -169,8 +171,13 @@ public:
             mTexture(texture), mEngine(engine), mTranscoder(transcoder),
             mSourceBuffer(std::move(buf)) {}
     Texture* getTexture() const noexcept { return mTexture; }
+    uint32_t getLevelCount() const noexcept { return mTranscoder->get_levels(); }
     Result doTranscoding();
+    Result doTranscoding(uint32_t levelIndex);
     void uploadImages();
+    Stats getStats() const noexcept {
+        return { mTranscodeNanoseconds.load(), mPeakPendingBytes.load() };
+    }
 
 protected:
     ~FAsync();
@@ -183,6 +190,14 @@ private:
     // miplevel in the texture.
     TranscoderResult mTranscoderResults[KTX2_MAX_SUPPORTED_LEVEL_COUNT] = {};
 
+    // Number of levels uploaded so far, counting from the smallest one. Only accessed by the
+    // foreground thread.
+    uint32_t mUploadedLevelCount = 0;
+
+    std::atomic<uint64_t> mTranscodeNanoseconds = 0;
+    std::atomic<size_t> mPendingBytes = 0;
+    std::atomic<size_t> mPeakPendingBytes = 0;
+
     Texture* const mTexture;
     Engine& mEngine;
 
@@ -273,31 +288,59 @@ FAsync::~FAsync() {
 }
 
 Result FAsync::doTranscoding() {
-    ktx2_transcoder_state basisThreadState;
-    basisThreadState.clear();
-    for (uint32_t levelIndex = 0, n = mTranscoder->get_levels(); levelIndex < n; levelIndex++) {
-        Texture::PixelBufferDescriptor* pbd;
-        Result result = transcodeImageLevel(*mTranscoder, basisThreadState, mTexture->getFormat(),
-                levelIndex, &pbd);
+    // Smaller levels are transcoded first so that a low-resolution version of the texture can be
+    // displayed as early as possible.
+    for (uint32_t levelIndex = mTranscoder->get_levels(); levelIndex-- > 0;) {
+        Result result = doTranscoding(levelIndex);
         if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
             return result;
         }
-        mTranscoderResults[levelIndex].store(pbd);
     }
     return Result::SUCCESS;
 }
 
+Result FAsync::doTranscoding(uint32_t levelIndex) {
+    using clock = std::chrono::steady_clock;
+    assert_invariant(levelIndex < mTranscoder->get_levels());
+
+    // The transcoder state holds scratch memory that cannot be shared across threads.
+    ktx2_transcoder_state basisThreadState;
+    basisThreadState.clear();
+
+    const auto start = clock::now();
+    Texture::PixelBufferDescriptor* pbd;
+    Result result = transcodeImageLevel(*mTranscoder, basisThreadState, mTexture->getFormat(),
+            levelIndex, &pbd);
+    mTranscodeNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start).count();
+    if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
+        return result;
+    }
+
+    const size_t pending = (mPendingBytes += pbd->size);
+    size_t peak = mPeakPendingBytes.load();
+    while (pending > peak && !mPeakPendingBytes.compare_exchange_weak(peak, pending)) {}
+
+    mTranscoderResults[levelIndex].store(pbd);
+    return Result::SUCCESS;
+}
+
 void FAsync::uploadImages() {
-    size_t levelIndex = 0;
+    // Texture restricts sampling to the range of levels that have been set, so levels are only
+    // uploaded in a contiguous run from the smallest one. Uploading a level past a gap would let
+    // the sampler read the missing levels in between.
+    const uint32_t levelCount = mTranscoder->get_levels();
     UTILS_NOUNROLL
-    for (TranscoderResult& level : mTranscoderResults) {
-        Texture::PixelBufferDescriptor* pbd = level.load();
-        if (pbd) {
-            level.store(nullptr);
-            mTexture->setImage(mEngine, levelIndex, std::move(*pbd));
-            delete pbd;
+    while (mUploadedLevelCount < levelCount) {
+        const uint32_t levelIndex = levelCount - 1 - mUploadedLevelCount;
+        Texture::PixelBufferDescriptor* pbd = mTranscoderResults[levelIndex].exchange(nullptr);
+        if (!pbd) {
+            break;
         }
-        ++levelIndex;
+        mPendingBytes -= pbd->size;
+        mTexture->setImage(mEngine, levelIndex, std::move(*pbd));
+        delete pbd;
+        mUploadedLevelCount++;
     }
 }
 
@@ -430,10 +473,22 @@ Texture* Async::getTexture() const noexcept {
     return static_cast<FAsync const*>(this)->getTexture();
 }
 
+uint32_t Async::getLevelCount() const noexcept {
+    return static_cast<FAsync const*>(this)->getLevelCount();
+}
+
 Result Async::doTranscoding() {
     return static_cast<FAsync*>(this)->doTranscoding();
 }
 
+Result Async::doTranscoding(uint32_t levelIndex) {
+    return static_cast<FAsync*>(this)->doTranscoding(levelIndex);
+}
+
+Async::Stats Async::getStats() const noexcept {
+    return static_cast<FAsync const*>(this)->getStats();
+}
+
 void Async::uploadImages() {
     return static_cast<FAsync*>(this)->uploadImages();
 }
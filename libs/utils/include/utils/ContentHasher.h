@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_CONTENTHASHER_H
+#define TNT_UTILS_CONTENTHASHER_H
+
+#include <utils/compiler.h>
+
+#include <string_view>
+#include <type_traits>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace utils {
+
+/**
+ * Incrementally computes a 128-bit hash of one or more spans of data, suitable for identifying
+ * content, e.g. as the key of an on-disk cache. This is a streaming implementation of
+ * MurmurHash3_x64_128: the digest only depends on the concatenation of the spans, not on how the
+ * data was split across calls to add().
+ *
+ * This is not a cryptographic hash, but with 128 bits, accidental collisions are negligible.
+ */
+class UTILS_PUBLIC ContentHasher {
+public:
+    struct Digest {
+        uint64_t low = 0;
+        uint64_t high = 0;
+
+        bool operator==(Digest const& rhs) const noexcept {
+            return low == rhs.low && high == rhs.high;
+        }
+        bool operator!=(Digest const& rhs) const noexcept { return !operator==(rhs); }
+    };
+
+    explicit ContentHasher(uint64_t seed = 0) noexcept : mH1(seed), mH2(seed) {}
+
+    ContentHasher& add(const void* data, size_t size) noexcept;
+
+    ContentHasher& add(std::string_view text) noexcept { return add(text.data(), text.size()); }
+
+    template<typename T>
+    ContentHasher& add(const T& value) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>,
+                "Only the bytes of trivially copyable types can be hashed.");
+        return add(&value, sizeof(T));
+    }
+
+    // Returns the digest of everything added so far. More data can be added afterwards.
+    Digest get() const noexcept;
+
+private:
+    void processBlock(const uint8_t* block) noexcept;
+
+    uint64_t mH1;
+    uint64_t mH2;
+    uint64_t mLength = 0;
+    uint8_t mPending[16] = {};
+    size_t mPendingSize = 0;
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_CONTENTHASHER_H
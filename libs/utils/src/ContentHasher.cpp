@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/ContentHasher.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace utils {
+
+namespace {
+
+constexpr uint64_t kC1 = 0x87c37b91114253d5ull;
+constexpr uint64_t kC2 = 0x4cf5ad432745937full;
+
+inline uint64_t rotl(uint64_t x, int r) noexcept {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix(uint64_t k) noexcept {
+    k ^= k >> 33u;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33u;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33u;
+    return k;
+}
+
+inline uint64_t mixK1(uint64_t k1) noexcept {
+    return rotl(k1 * kC1, 31) * kC2;
+}
+
+inline uint64_t mixK2(uint64_t k2) noexcept {
+    return rotl(k2 * kC2, 33) * kC1;
+}
+
+} // anonymous namespace
+
+void ContentHasher::processBlock(const uint8_t* block) noexcept {
+    uint64_t k1, k2;
+    memcpy(&k1, block, sizeof(k1));
+    memcpy(&k2, block + sizeof(k1), sizeof(k2));
+
+    mH1 ^= mixK1(k1);
+    mH1 = rotl(mH1, 27) + mH2;
+    mH1 = mH1 * 5 + 0x52dce729;
+
+    mH2 ^= mixK2(k2);
+    mH2 = rotl(mH2, 31) + mH1;
+    mH2 = mH2 * 5 + 0x38495ab5;
+}
+
+ContentHasher& ContentHasher::add(const void* data, size_t size) noexcept {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    mLength += size;
+
+    // Complete the block left over by the previous call, if any.
+    if (mPendingSize > 0) {
+        const size_t n = std::min(size, sizeof(mPending) - mPendingSize);
+        memcpy(mPending + mPendingSize, bytes, n);
+        mPendingSize += n;
+        bytes += n;
+        size -= n;
+        if (mPendingSize < sizeof(mPending)) {
+            return *this;
+        }
+        processBlock(mPending);
+        mPendingSize = 0;
+    }
+
+    for (; size >= sizeof(mPending); size -= sizeof(mPending), bytes += sizeof(mPending)) {
+        processBlock(bytes);
+    }
+
+    memcpy(mPending, bytes, size);
+    mPendingSize = size;
+    return *this;
+}
+
+ContentHasher::Digest ContentHasher::get() const noexcept {
+    uint64_t h1 = mH1;
+    uint64_t h2 = mH2;
+
+    // The tail is read as two little-endian words, as in the reference implementation.
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    for (size_t i = mPendingSize; i-- > 8;) {
+        k2 = (k2 << 8u) | mPending[i];
+    }
+    for (size_t i = std::min(mPendingSize, size_t(8)); i-- > 0;) {
+        k1 = (k1 << 8u) | mPending[i];
+    }
+    if (mPendingSize > 8) {
+        h2 ^= mixK2(k2);
+    }
+    if (mPendingSize > 0) {
+        h1 ^= mixK1(k1);
+    }
+
+    h1 ^= mLength;
+    h2 ^= mLength;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    return { h1, h2 };
+}
+
+} // namespace utils
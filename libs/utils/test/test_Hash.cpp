@@ -16,8 +16,11 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/ContentHasher.h>
 #include <utils/Hash.h>
 
+#include <string_view>
+
 using namespace utils;
 
 TEST(HashTest, murmur) {
@@ -50,3 +53,29 @@ TEST(HashTest, murmur) {
     EXPECT_EQ(result4, result7);
     EXPECT_NE(result4, result8);
 }
+
+TEST(HashTest, ContentHasher) {
+    // Reference value of MurmurHash3_x64_128 with a seed of 0.
+    const std::string_view text = "The quick brown fox jumps over the lazy dog";
+    const ContentHasher::Digest digest = ContentHasher().add(text).get();
+    EXPECT_EQ(digest.low, 0xe34bbc7bbc071b6cull);
+    EXPECT_EQ(digest.high, 0x7a433ca9c49a9347ull);
+
+    // The digest doesn't depend on how the data is split.
+    for (size_t split = 0; split <= text.size(); split++) {
+        ContentHasher hasher;
+        hasher.add(text.substr(0, split)).add(text.substr(split));
+        EXPECT_EQ(hasher.get(), digest);
+    }
+
+    // Getting the digest doesn't prevent adding more data.
+    ContentHasher hasher;
+    hasher.add(text.substr(0, 20));
+    const ContentHasher::Digest partial = hasher.get();
+    EXPECT_EQ(hasher.add(text.substr(20)).get(), digest);
+    EXPECT_NE(partial, digest);
+
+    EXPECT_EQ(ContentHasher().get(), ContentHasher::Digest{});
+    EXPECT_NE(ContentHasher(1).add(text).get(), digest);
+    EXPECT_NE(ContentHasher().add(text.substr(1)).get(), digest);
+}
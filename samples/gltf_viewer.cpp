@@ -136,6 +136,7 @@ struct App {
     std::string messageBoxText;
     std::string settingsFile;
     std::string batchFile;
+    std::string programArchiveFile;
 
     AutomationSpec* automationSpec = nullptr;
     AutomationEngine* automationEngine = nullptr;
@@ -202,6 +203,10 @@ static void printUsage(char* name) {
         "       Vulkan backend allows user to choose their GPU.\n"
         "       You can provide the index of the GPU or\n"
         "       a substring to match against the device name\n\n"
+        "   --program-archive=<path>, -p <path>\n"
+        "       Load program binaries from the given archive if it exists, and write all the\n"
+        "       program binaries compiled during the run back to it on exit.\n"
+        "       Combine with --batch to capture the programs of all the materials used\n\n"
     );
     const std::string from("SHOWCASE");
     for (size_t pos = usage.find(from); pos != std::string::npos; pos = usage.find(from, pos)) {
@@ -216,7 +221,7 @@ static std::ifstream::pos_type getFileSize(const char* filename) {
 }
 
 static int handleCommandLineArguments(int argc, char* argv[], App* app) {
-    static constexpr const char* OPTSTR = "ha:f:i:usc:rt:b:evg:";
+    static constexpr const char* OPTSTR = "ha:f:i:usc:rt:b:evg:p:";
     static const struct option OPTIONS[] = {
         { "help",            no_argument,          nullptr, 'h' },
         { "api",             required_argument,    nullptr, 'a' },
@@ -232,6 +237,7 @@ static int handleCommandLineArguments(int argc, char* argv[], App* app) {
         { "settings",        required_argument,    nullptr, 't' },
         { "split-view",      no_argument,          nullptr, 'v' },
         { "vulkan-gpu-hint", required_argument,    nullptr, 'g' },
+        { "program-archive", required_argument,    nullptr, 'p' },
         { nullptr, 0, nullptr, 0 }
     };
     int opt;
@@ -317,6 +323,10 @@ static int handleCommandLineArguments(int argc, char* argv[], App* app) {
                 app->config.vulkanGPUHint = arg;
                 break;
             }
+            case 'p': {
+                app->programArchiveFile = arg;
+                break;
+            }
         }
     }
     if (app->config.headless && app->batchFile.empty()) {
@@ -326,6 +336,40 @@ static int handleCommandLineArguments(int argc, char* argv[], App* app) {
     return optind;
 }
 
+static void loadProgramArchive(const char* filename, Engine::ProgramBinaryArchive* out) {
+    auto contentSize = getFileSize(filename);
+    if (contentSize <= 0) {
+        // No archive yet, it will be created on exit.
+        return;
+    }
+    std::ifstream in(filename, std::ifstream::binary | std::ifstream::in);
+    std::vector<char> data(static_cast<unsigned long>(contentSize));
+    if (!in.read(data.data(), contentSize) || !out->load(data.data(), data.size())) {
+        std::cerr << "Unable to load program archive: " << filename << std::endl;
+        return;
+    }
+    std::cout << "Loaded " << out->getEntryCount() << " program binaries from " << filename
+              << std::endl;
+}
+
+static void saveProgramArchive(const char* filename,
+        Engine::ProgramBinaryArchive const& archive) {
+    std::vector<char> data(archive.getSerializedSize());
+    size_t const size = archive.serialize(data.data(), data.size());
+    if (!size) {
+        // Don't truncate the existing archive if there is nothing valid to replace it with.
+        std::cerr << "Unable to serialize program archive: " << filename << std::endl;
+        return;
+    }
+    std::ofstream out(filename, std::ofstream::binary | std::ofstream::trunc);
+    if (!out.write(data.data(), static_cast<std::streamsize>(size))) {
+        std::cerr << "Unable to write program archive: " << filename << std::endl;
+        return;
+    }
+    std::cout << "Wrote " << archive.getEntryCount() << " program binaries to " << filename
+              << std::endl;
+}
+
 static bool loadSettings(const char* filename, Settings* out) {
     auto contentSize = getFileSize(filename);
     if (contentSize <= 0) {
@@ -1201,7 +1245,17 @@ int main(int argc, char** argv) {
         }
     });
 
+    Engine::ProgramBinaryArchive programArchive;
+    if (!app.programArchiveFile.empty()) {
+        loadProgramArchive(app.programArchiveFile.c_str(), &programArchive);
+        app.config.programBinaryArchive = &programArchive;
+    }
+
     filamentApp.run(app.config, setup, cleanup, gui, preRender, postRender);
 
+    if (!app.programArchiveFile.empty()) {
+        saveProgramArchive(app.programArchiveFile.c_str(), programArchive);
+    }
+
     return 0;
 }
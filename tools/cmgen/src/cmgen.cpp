@@ -23,6 +23,7 @@
 #include <ibl/Image.h>
 #include <ibl/utilities.h>
 
+#include <imageio/BatchManifest.h>
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
@@ -36,6 +37,8 @@
 #include <math/scalar.h>
 #include <math/vec4.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
@@ -108,6 +111,9 @@ static size_t g_num_samples = 1024;
 
 static bool g_mirror = false;
 
+static utils::Path g_batch_manifest;
+static std::string g_options_key;
+
 // -----------------------------------------------------------------------------------------------
 
 static void generateMipmaps(utils::JobSystem& js, std::vector<Cubemap>& levels,
@@ -150,6 +156,7 @@ static void printUsage(char* name) {
             "Usages:\n"
             "    CMGEN [options] <input-file>\n"
             "    CMGEN [options] <uv[N]>\n"
+            "    CMGEN [options] --batch=<manifest>\n"
             "\n"
             "Supported input formats:\n"
             "    PNG, 8 and 16 bits\n"
@@ -184,6 +191,10 @@ static void printUsage(char* name) {
             "       Also applies to DFG LUT\n\n"
             "   --deploy=dir, -x dir\n"
             "       Generate everything needed for deployment into <dir>\n\n"
+            "   --batch=manifest, -B manifest\n"
+            "       Process every input file listed in <manifest>, one per line, with the same\n"
+            "       options. Inputs that have not changed since the last run are skipped, delete\n"
+            "       <manifest>.stamps to process all of them again\n\n"
             "   --extract=dir\n"
             "       Extract faces of the cubemap into <dir>\n\n"
             "   --extract-blur=roughness\n"
@@ -244,7 +255,7 @@ static void license() {
 }
 
 static int handleCommandLineArgments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hqidt:f:c:s:x:w:S:";
+    static constexpr const char* OPTSTR = "hqidt:f:c:s:x:w:S:B:";
     static const struct option OPTIONS[] = {
             { "help",                       no_argument, nullptr, 'h' },
             { "license",                    no_argument, nullptr, 'l' },
@@ -271,6 +282,7 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             { "ibl-min-lod-size",     required_argument, nullptr, 'S' },
             { "ibl-samples",          required_argument, nullptr, 'k' },
             { "deploy",               required_argument, nullptr, 'x' },
+            { "batch",                required_argument, nullptr, 'B' },
             { "no-mirror",                  no_argument, nullptr, 'm' },
             { "debug",                      no_argument, nullptr, 'd' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
@@ -283,6 +295,10 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
     bool ktx_format_requested = false;
     while ((opt = getopt_long(argc, argv, OPTSTR, OPTIONS, &option_index)) >= 0) {
         std::string arg(optarg ? optarg : "");
+        if (opt != 'B' && opt != 'q') {
+            // Options that affect the output are part of the hash of each batch item.
+            g_options_key += char(opt) + arg + "\n";
+        }
         switch (opt) {
             default:
             case 'h':
@@ -452,6 +468,9 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             case 'm':
                 g_mirror = true;
                 break;
+            case 'B':
+                g_batch_manifest = arg;
+                break;
         }
     }
 
@@ -474,78 +493,78 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
     return optind;
 }
 
-int main(int argc, char* argv[]) {
-    utils::JobSystem js;
-    js.adopt();
-
-    int option_index = handleCommandLineArgments(argc, argv);
-    int num_args = argc - option_index;
-    if (!g_dfg && num_args < 1) {
-        printUsage(argv[0]);
-        return 1;
-    }
-
-    if (g_dfg) {
-        if (!g_quiet) {
-            std::cout << "Generating IBL DFG LUT..." << std::endl;
-        }
-        size_t size = g_output_size ? g_output_size : DFG_LUT_DEFAULT_SIZE;
-        iblLutDfg(js, g_dfg_filename, size, g_dfg_multiscatter, g_dfg_cloth);
-        if (num_args < 1) return 0;
-    }
+// Wall clock time spent in each stage, in seconds.
+struct StageTimings {
+    double decode = 0;
+    double cubemap = 0;
+    double process = 0;
+};
 
-    std::string command(argv[option_index]);
-    utils::Path iname(command);
+using Clock = std::chrono::steady_clock;
 
-    if (g_deploy) {
-        utils::Path sh_dir = g_deploy_dir;
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
 
-        // KTX files are self-contained and do not need to live in a subfolder.
-        if (g_type != OutputType::KTX) {
-            sh_dir += iname.getNameWithoutExtension();
-        }
+// Decodes the input image, returns an invalid image if the file does not exist or is not RGB.
+static LinearImage decodeInput(const utils::Path& iname) {
+    if (!iname.exists()) {
+        return {};
+    }
+    std::ifstream input_stream(iname.getPath(), std::ios::binary);
+    LinearImage linputImage = ImageDecoder::decode(input_stream, iname.getPath());
+    if (!linputImage.isValid()) {
+        std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
+        return {};
+    }
+    if (linputImage.getChannels() != 3) {
+        std::cerr << "Input image must be RGB (3 channels)! This image has "
+                  << linputImage.getChannels() << " channels." << std::endl;
+        return {};
+    }
+    return linputImage;
+}
 
-        // generate pre-scaled irradiance sh to text file
-        g_sh_compute = 3;
-        g_sh_shader = true;
-        g_sh_irradiance = true;
-        if (g_sh_file == ShFile::SH_NONE) {
-            g_sh_file = ShFile::SH_TEXT;
-            g_sh_filename = sh_dir + "sh.txt";
-        } else {
-            g_sh_filename = sh_dir + g_sh_filename.getName();
-        }
-        g_sh_output = true;
+// Points the deployment options to the output folder of the given input.
+static void applyDeployOptions(const utils::Path& iname, ShFile sh_file,
+        const utils::Path& sh_filename) {
+    utils::Path sh_dir = g_deploy_dir;
 
-        // faces
-        g_extract_dir = g_deploy_dir;
-        g_extract_faces = true;
+    // KTX files are self-contained and do not need to live in a subfolder.
+    if (g_type != OutputType::KTX) {
+        sh_dir += iname.getNameWithoutExtension();
+    }
 
-        // prefilter
-        g_prefilter = true;
-        g_prefilter_dir = g_deploy_dir;
+    // generate pre-scaled irradiance sh to text file
+    g_sh_compute = 3;
+    g_sh_shader = true;
+    g_sh_irradiance = true;
+    if (sh_file == ShFile::SH_NONE) {
+        g_sh_file = ShFile::SH_TEXT;
+        g_sh_filename = sh_dir + "sh.txt";
+    } else {
+        g_sh_file = sh_file;
+        g_sh_filename = sh_dir + sh_filename.getName();
     }
+    g_sh_output = true;
 
-    // Images store the actual data
-    std::vector<Image> images;
+    // faces
+    g_extract_dir = g_deploy_dir;
+    g_extract_faces = true;
 
-    // Cubemaps are just views on Images
-    std::vector<Cubemap> levels;
+    // prefilter
+    g_prefilter = true;
+    g_prefilter_dir = g_deploy_dir;
+}
 
+// Creates the base level of the environment from the decoded input image, or from a generated
+// pattern if the input file does not exist. Returns false on failure.
+static bool createEnvironment(utils::JobSystem& js, const utils::Path& iname,
+        const LinearImage& linputImage, std::vector<Image>& images, std::vector<Cubemap>& levels) {
     if (iname.exists()) {
-        if (!g_quiet) {
-            std::cout << "Decoding image..." << std::endl;
-        }
-        std::ifstream input_stream(iname.getPath(), std::ios::binary);
-        LinearImage linputImage = ImageDecoder::decode(input_stream, iname.getPath());
         if (!linputImage.isValid()) {
-            std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
-            exit(1);
-        }
-        if (linputImage.getChannels() != 3) {
-            std::cerr << "Input image must be RGB (3 channels)! This image has "
-                      << linputImage.getChannels() << " channels." << std::endl;
-            exit(1);
+            // Error message has already been printed.
+            return false;
         }
 
         // Convert from LinearImage to the deprecated Image object which is used throughout cmgen.
@@ -587,7 +606,7 @@ int main(int argc, char* argv[]) {
             std::cerr << "  2:1, lat/long or equirectangular" << std::endl;
             std::cerr << "  3:4, vertical cross (height must be power of two)" << std::endl;
             std::cerr << "  4:3, horizontal cross (width must be power of two)" << std::endl;
-            exit(0);
+            return false;
         }
     } else {
         if (!g_quiet) {
@@ -618,8 +637,7 @@ int main(int argc, char* argv[]) {
     }
 
     // we mirror by default -- the mirror option in fact un-mirrors.
-    g_mirror = !g_mirror;
-    if (g_mirror) {
+    if (!g_mirror) {
         if (!g_quiet) {
             std::cout << "Mirroring..." << std::endl;
         }
@@ -639,7 +657,12 @@ int main(int argc, char* argv[]) {
 
     // Now generate all the mipmap levels
     generateMipmaps(js, levels, images);
+    return true;
+}
 
+// Generates all the requested outputs from the environment.
+static void processEnvironment(utils::JobSystem& js, const utils::Path& iname,
+        std::vector<Image>& images, std::vector<Cubemap>& levels) {
     if (g_sh_compute) {
         if (!g_quiet) {
             std::cout << "Spherical harmonics..." << std::endl;
@@ -700,7 +723,190 @@ int main(int argc, char* argv[]) {
             extractCubemapFaces(js, iname, cm, g_extract_dir);
         }
     }
+}
+
+// Returns true if the outputs that processEnvironment() writes for the given input are all present.
+// Output directories must not be empty.
+static bool outputsExist(const utils::Path& iname) {
+    const std::string name = iname.getNameWithoutExtension();
+    auto present = [](const utils::Path& path) {
+        return path.isDirectory() ? !path.listContents().empty() : path.exists();
+    };
+    // KTX outputs are named after their directory, the other ones go to a folder per input.
+    auto outputOf = [&name](const utils::Path& dir, const char* ktxSuffix) {
+        if (g_type == OutputType::KTX) {
+            return dir.getAbsolutePath() + (dir.getNameWithoutExtension() + ktxSuffix);
+        }
+        return dir.getAbsolutePath() + name;
+    };
+    return (g_sh_file == ShFile::SH_NONE || present(g_sh_filename)) &&
+            (!g_is_mipmap || present(g_is_mipmap_dir.getAbsolutePath() + name)) &&
+            (!g_prefilter || present(outputOf(g_prefilter_dir, "_ibl.ktx"))) &&
+            (!g_ibl_irradiance || present(g_ibl_irradiance_dir.getAbsolutePath() + name)) &&
+            (!g_extract_faces || present(outputOf(g_extract_dir, "_skybox.ktx")));
+}
+
+// Processes every input listed in the manifest with a single job system. The next input is
+// decoded by a job while the current one is being processed. Inputs that have not changed since
+// the last successful run with the same options, and whose outputs still exist, are skipped.
+static bool runBatch(utils::JobSystem& js) {
+    BatchManifest manifest(g_batch_manifest);
+    if (!manifest.isValid()) {
+        std::cerr << "Unable to read manifest: " << g_batch_manifest << std::endl;
+        return false;
+    }
+
+    struct Item {
+        utils::Path iname;
+        BatchManifest::Hash hash;
+        LinearImage image;
+        double decodeSeconds = 0;
+        utils::JobSystem::Job* job = nullptr;
+    };
+
+    // Deployment rewrites the SH options for every input.
+    const ShFile sh_file = g_sh_file;
+    const utils::Path sh_filename = g_sh_filename;
+
+    const BatchManifest::Hash optionsHash = BatchManifest::hashString(g_options_key);
+    size_t skipped = 0;
+    size_t failed = 0;
+    std::vector<Item> items;
+    for (auto const& entry : manifest.getEntries()) {
+        if (entry.size() != 1) {
+            std::cerr << "Manifest entries must be a single input file: " << entry[0] << std::endl;
+            ++failed;
+            continue;
+        }
+        Item item{ utils::Path(entry[0]) };
+        // A missing input would otherwise be replaced by a generated UV grid.
+        if (!item.iname.exists()) {
+            std::cerr << "Input file does not exist: " << item.iname << std::endl;
+            ++failed;
+            continue;
+        }
+        item.hash = BatchManifest::hashFile(item.iname, optionsHash);
+        if (g_deploy) {
+            applyDeployOptions(item.iname, sh_file, sh_filename);
+        }
+        if (manifest.isUpToDate(item.iname.getPath(), item.hash) && outputsExist(item.iname)) {
+            ++skipped;
+            continue;
+        }
+        items.push_back(std::move(item));
+    }
+
+    auto startDecoding = [&js](Item& item) {
+        item.job = utils::jobs::createJob(js, nullptr, [&item]() {
+            Clock::time_point start = Clock::now();
+            item.image = decodeInput(item.iname);
+            item.decodeSeconds = secondsSince(start);
+        });
+        js.runAndRetain(item.job);
+    };
+
+    StageTimings timings;
+    size_t processed = 0;
+    const Clock::time_point start = Clock::now();
+    if (!items.empty()) {
+        startDecoding(items[0]);
+    }
+    for (size_t i = 0; i < items.size(); i++) {
+        Item& item = items[i];
+        js.waitAndRelease(item.job);
+        if (i + 1 < items.size()) {
+            startDecoding(items[i + 1]);
+        }
+        timings.decode += item.decodeSeconds;
+        if (!g_quiet) {
+            std::cout << "[" << (i + 1) << "/" << items.size() << "] " << item.iname << std::endl;
+        }
+        if (g_deploy) {
+            applyDeployOptions(item.iname, sh_file, sh_filename);
+        }
+
+        Clock::time_point stageStart = Clock::now();
+        std::vector<Image> images;
+        std::vector<Cubemap> levels;
+        if (!createEnvironment(js, item.iname, item.image, images, levels)) {
+            ++failed;
+            item.image.reset();
+            continue;
+        }
+        item.image.reset();
+        timings.cubemap += secondsSince(stageStart);
+
+        stageStart = Clock::now();
+        processEnvironment(js, item.iname, images, levels);
+        timings.process += secondsSince(stageStart);
+        manifest.setUpToDate(item.iname.getPath(), item.hash);
+        ++processed;
+    }
+    const double total = secondsSince(start);
+
+    if (!manifest.saveStamps()) {
+        std::cerr << "Unable to write stamps for manifest: " << g_batch_manifest << std::endl;
+    }
+
+    if (!g_quiet) {
+        std::cout << "Processed " << processed
+                  << " inputs, skipped " << skipped << ", failed " << failed
+                  << " in " << std::fixed << std::setprecision(2) << total << "s." << std::endl;
+        std::cout << "    decode " << timings.decode << "s, cubemap " << timings.cubemap
+                  << "s, process " << timings.process << "s" << std::endl;
+    }
+    return failed == 0;
+}
+
+int main(int argc, char* argv[]) {
+    utils::JobSystem js;
+    js.adopt();
+
+    int option_index = handleCommandLineArgments(argc, argv);
+    int num_args = argc - option_index;
+    const bool batch = !g_batch_manifest.isEmpty();
+    if (!g_dfg && !batch && num_args < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (g_dfg) {
+        if (!g_quiet) {
+            std::cout << "Generating IBL DFG LUT..." << std::endl;
+        }
+        size_t size = g_output_size ? g_output_size : DFG_LUT_DEFAULT_SIZE;
+        iblLutDfg(js, g_dfg_filename, size, g_dfg_multiscatter, g_dfg_cloth);
+        if (!batch && num_args < 1) return 0;
+    }
+
+    if (batch) {
+        return runBatch(js) ? 0 : 1;
+    }
+
+    std::string command(argv[option_index]);
+    utils::Path iname(command);
+
+    if (g_deploy) {
+        applyDeployOptions(iname, g_sh_file, g_sh_filename);
+    }
+
+    if (!g_quiet && iname.exists()) {
+        std::cout << "Decoding image..." << std::endl;
+    }
+    LinearImage linputImage = decodeInput(iname);
+
+    // Images store the actual data
+    std::vector<Image> images;
+
+    // Cubemaps are just views on Images
+    std::vector<Cubemap> levels;
+
+    if (!createEnvironment(js, iname, linputImage, images, levels)) {
+        return 1;
+    }
+    linputImage.reset();
 
+    processEnvironment(js, iname, images, levels);
     return 0;
 }
 
@@ -25,6 +25,7 @@
 #include <istream>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 
 using namespace utils;
 
@@ -41,6 +42,7 @@ static void usage(char* name) {
             "\n"
             "Usages:\n"
             "    MATC [options] <input-file>\n"
+            "    MATC [options] --output-dir=<dir> <input-file> [<input-file> ...]\n"
             "\n"
             "Supported input formats:\n"
             "    Filament material definition (.mat)\n"
@@ -52,6 +54,11 @@ static void usage(char* name) {
             "       Print copyright and license information\n\n"
             "   --output, -o\n"
             "       Specify path to output file\n\n"
+            "   --output-dir=<dir>, -u <dir>\n"
+            "       Write each compiled material to <dir>, named after its input file with the\n"
+            "       extension .filamat (or .inc with --output-format=header). Required to compile\n"
+            "       several input files at once, which shares the shader compiler and the thread\n"
+            "       pool between all the materials.\n\n"
             "   --platform, -p\n"
             "       Shader family to generate: desktop, mobile or all (default)\n\n"
             "   --optimize-size, -S\n"
@@ -86,6 +93,10 @@ static void usage(char* name) {
             "           directionalLighting, dynamicLighting, shadowReceiver, skinning, vsm, fog,"
             "           ssr (screen-space reflections), stereo\n"
             "       This variant filter is merged with the filter from the material, if any\n\n"
+            "   --cache=<dir>, -C <dir>\n"
+            "       Cache compiled shaders in the specified directory, which is created if needed.\n"
+            "       Unchanged shaders are not compiled again on subsequent runs. The directory\n"
+            "       can be shared by concurrent invocations.\n\n"
             "   --version, -v\n"
             "       Print the material version number\n\n"
             "Internal use and debugging only:\n"
@@ -105,6 +116,11 @@ static void usage(char* name) {
             "       Print generated shaders for debugging\n\n"
             "   --save-raw-variants, -R\n"
             "       Write the raw generated GLSL for each variant to a text file in the current directory.\n\n"
+            "   --timings, -s\n"
+            "       Print the time spent in each stage of shader compilation\n\n"
+            "   --minify, -M\n"
+            "       Minify GLSL shaders at the token level: rename local variables and remove\n"
+            "       unused functions. Prints the size of the shaders before and after minification\n\n"
     );
     const std::string from("MATC");
     for (size_t pos = usage.find(from); pos != std::string::npos; pos = usage.find(from, pos)) {
@@ -181,11 +197,12 @@ static void parseDefine(std::string defineString, Config::StringReplacementMap&
 }
 
 bool CommandlineConfig::parse() {
-    static constexpr const char* OPTSTR = "hLxo:f:dm:a:l:p:D:T:P:OSEr:vV:gtwF1R";
+    static constexpr const char* OPTSTR = "hLxo:u:f:dm:a:l:p:D:T:P:OSEr:vV:gtwF1RC:sM";
     static const struct option OPTIONS[] = {
             { "help",                    no_argument, nullptr, 'h' },
             { "license",                 no_argument, nullptr, 'L' },
             { "output",            required_argument, nullptr, 'o' },
+            { "output-dir",        required_argument, nullptr, 'u' },
             { "output-format",     required_argument, nullptr, 'f' },
             { "debug",                   no_argument, nullptr, 'd' },
             { "variant-filter",    required_argument, nullptr, 'V' },
@@ -207,6 +224,9 @@ bool CommandlineConfig::parse() {
             { "raw",                     no_argument, nullptr, 'w' },
             { "no-sampler-validation",   no_argument, nullptr, 'F' },
             { "save-raw-variants",       no_argument, nullptr, 'R' },
+            { "cache",             required_argument, nullptr, 'C' },
+            { "timings",                 no_argument, nullptr, 's' },
+            { "minify",                  no_argument, nullptr, 'M' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
 
@@ -226,7 +246,10 @@ bool CommandlineConfig::parse() {
                 exit(0);
                 break;
             case 'o':
-                mOutput = new FilesystemOutput(arg.c_str());
+                mOutputPath = arg;
+                break;
+            case 'u':
+                mOutputDirectory = arg;
                 break;
             case 'f':
                 if (arg == "blob") {
@@ -332,15 +355,51 @@ bool CommandlineConfig::parse() {
             case 'R':
                 mSaveRawVariants = true;
                 break;
+            case 'C':
+                mShaderCacheDirectory = arg;
+                break;
+            case 's':
+                mPrintTimings = true;
+                break;
+            case 'M':
+                mAggressiveMinification = true;
+                break;
         }
     }
 
-    if (mArgc - optind > 1) {
-        std::cerr << "Only one input file should be specified on the command line." << std::endl;
+    if (!mOutputPath.empty() && !mOutputDirectory.empty()) {
+        std::cerr << "--output and --output-dir cannot be used together." << std::endl;
+        return false;
+    }
+    if (mArgc - optind > 1 && mOutputDirectory.empty()) {
+        std::cerr << "Several input files require an output directory (--output-dir)."
+                << std::endl;
         return false;
     }
-    if (mArgc - optind > 0) {
-        mInput = new FilesystemInput(mArgv[optind]);
+    if (!mOutputDirectory.empty()) {
+        Path const directory(mOutputDirectory);
+        if (!directory.isDirectory() && !directory.mkdirRecursive()) {
+            std::cerr << "Unable to create the output directory " << directory << std::endl;
+            return false;
+        }
+    }
+
+    const char* extension = mOutputFormat == OutputFormat::C_HEADER ? ".inc" : ".filamat";
+    std::unordered_set<std::string> outputNames;
+    for (int i = optind; i < mArgc; i++) {
+        mInputs.push_back(std::make_unique<FilesystemInput>(mArgv[i]));
+        if (!mOutputDirectory.empty()) {
+            std::string const name = Path(mArgv[i]).getNameWithoutExtension() + extension;
+            if (!outputNames.insert(name).second) {
+                std::cerr << "Several input files would be written to " << name << std::endl;
+                return false;
+            }
+            Path const output = Path(mOutputDirectory).concat(name);
+            mOutputs.push_back(std::make_unique<FilesystemOutput>(output.c_str()));
+        }
+    }
+    if (!mOutputPath.empty()) {
+        mOutputs.push_back(std::make_unique<FilesystemOutput>(mOutputPath.c_str()));
     }
 
     return true;
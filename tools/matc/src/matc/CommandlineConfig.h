@@ -19,7 +19,9 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "Config.h"
 
@@ -101,17 +103,26 @@ class CommandlineConfig : public Config {
 public:
 
     CommandlineConfig(int argc, char** argv);
-    ~CommandlineConfig() override {
-        delete mInput;
-        delete mOutput;
-    };
+    ~CommandlineConfig() override = default;
 
     Output* getOutput()  const noexcept override  {
-        return mOutput;
+        return getOutputAt(0);
     }
 
     Input* getInput() const noexcept override {
-        return mInput;
+        return getInputAt(0);
+    }
+
+    size_t getInputCount() const noexcept override {
+        return mInputs.size();
+    }
+
+    Input* getInputAt(size_t index) const noexcept override {
+        return index < mInputs.size() ? mInputs[index].get() : nullptr;
+    }
+
+    Output* getOutputAt(size_t index) const noexcept override {
+        return index < mOutputs.size() ? mOutputs[index].get() : nullptr;
     }
 
     std::string toString() const noexcept override {
@@ -129,8 +140,10 @@ private:
     int mArgc = 0;
     char** mArgv = nullptr;
 
-    FilesystemInput* mInput = nullptr;
-    FilesystemOutput* mOutput = nullptr;
+    std::string mOutputPath;
+    std::string mOutputDirectory;
+    std::vector<std::unique_ptr<FilesystemInput>> mInputs;
+    std::vector<std::unique_ptr<FilesystemOutput>> mOutputs;
 };
 
 } // namespace matc
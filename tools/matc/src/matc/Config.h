@@ -73,6 +73,14 @@ public:
     };
     virtual Input* getInput() const noexcept = 0;
 
+    // A single invocation can compile several materials, each input being written to its own
+    // output. getInput() and getOutput() return the first ones.
+    virtual size_t getInputCount() const noexcept { return getInput() ? 1 : 0; }
+    virtual Input* getInputAt(size_t index) const noexcept { return index ? nullptr : getInput(); }
+    virtual Output* getOutputAt(size_t index) const noexcept {
+        return index ? nullptr : getOutput();
+    }
+
     virtual std::string toString() const noexcept = 0;
 
     bool isDebug() const noexcept {
@@ -147,6 +155,18 @@ public:
         return mFeatureLevel;
     }
 
+    const std::string& getShaderCacheDirectory() const noexcept {
+        return mShaderCacheDirectory;
+    }
+
+    bool printTimings() const noexcept {
+        return mPrintTimings;
+    }
+
+    bool aggressiveMinification() const noexcept {
+        return mAggressiveMinification;
+    }
+
 protected:
     bool mDebug = false;
     bool mIsValid = true;
@@ -165,6 +185,9 @@ protected:
     StringReplacementMap mMaterialParameters;
     filament::UserVariantFilterMask mVariantFilter = 0;
     bool mIncludeEssl1 = true;
+    std::string mShaderCacheDirectory;
+    bool mPrintTimings = false;
+    bool mAggressiveMinification = false;
 };
 
 }
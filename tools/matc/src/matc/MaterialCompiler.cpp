@@ -16,8 +16,14 @@
 
 #include "MaterialCompiler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <utility>
 
 #include <filamat/MaterialBuilder.h>
@@ -26,6 +32,7 @@
 
 #include <utils/Log.h>
 #include <utils/JobSystem.h>
+#include <utils/Mutex.h>
 
 #include "DirIncluder.h"
 #include "MaterialLexeme.h"
@@ -288,14 +295,19 @@ bool MaterialCompiler::isValidJsonStart(const char* buffer, size_t size) const n
     return c == 'n' && (end - buffer) > 3 && strncmp(buffer, "null", 5) != 0;
 }
 
-bool MaterialCompiler::run(const Config& config) {
-    Config::Input* input = config.getInput();
+// Reads an input file and performs the template substitutions of the config. Returns null on error,
+// which is written to the given report stream.
+static std::unique_ptr<const char[]> readInput(const Config& config, Config::Input* input,
+        ssize_t* outSize, std::ostream& report) {
     ssize_t size = input->open();
     if (size <= 0) {
-        std::cerr << "Input file is empty" << std::endl;
-        return false;
+        report << "Input file is empty" << std::endl;
+        return nullptr;
     }
     std::unique_ptr<const char[]> buffer = input->read();
+    if (!buffer) {
+        return nullptr;
+    }
 
     // Perform template substitutions in two passes: the first pass determines the size of the
     // modified buffer and checks for errors. The second pass rebuilds the buffer.
@@ -311,8 +323,8 @@ bool MaterialCompiler::run(const Config& config) {
             ssize_t endCursor = cursor;
             while (true) {
                 if (endCursor == size) {
-                    std::cerr << "Unexpected end of file" << std::endl;
-                    return false;
+                    report << "Unexpected end of file" << std::endl;
+                    return nullptr;
                 }
                 if (buffer[endCursor] == '}') {
                     break;
@@ -325,8 +337,8 @@ bool MaterialCompiler::run(const Config& config) {
                 modifiedSize -= macro.size() + 3;
                 modifiedSize += iter->second.size();
             } else {
-                std::cerr << "Undefined template macro:" << macro << std::endl;
-                return false;
+                report << "Undefined template macro:" << macro << std::endl;
+                return nullptr;
             }
             modified = true;
         }
@@ -357,10 +369,24 @@ bool MaterialCompiler::run(const Config& config) {
         size = modifiedSize;
     }
 
-    utils::Path const materialFilePath = utils::Path(input->getName()).getAbsolutePath();
-    assert(materialFilePath.isFile());
+    *outSize = size;
+    return buffer;
+}
+
+bool MaterialCompiler::run(const Config& config) {
+    if (config.getInputCount() > 1) {
+        return compileMaterials(config);
+    }
+
+    Config::Input* input = config.getInput();
+    ssize_t size = 0;
+    std::unique_ptr<const char[]> const buffer = readInput(config, input, &size, std::cerr);
+    if (!buffer) {
+        return false;
+    }
 
     if (config.rawShaderMode()) {
+        utils::Path const materialFilePath = utils::Path(input->getName()).getAbsolutePath();
         const std::string extension = materialFilePath.getExtension();
         glslang::InitializeProcess();
         bool const success = compileRawShader(buffer.get(), size, config.isDebug(), config.getOutput(),
@@ -370,13 +396,96 @@ bool MaterialCompiler::run(const Config& config) {
     }
 
     MaterialBuilder::init();
+    JobSystem js;
+    js.adopt();
+
+    std::ostringstream report;
+    bool compiled;
+    bool const success = compileMaterial(config, input, config.getOutput(), buffer.get(),
+            size_t(size), js, report, &compiled);
+    (success ? std::cout : std::cerr) << report.str();
+
+    js.emancipate();
+    MaterialBuilder::shutdown();
+    return success;
+}
+
+bool MaterialCompiler::compileMaterials(const Config& config) const {
+    auto const startTime = std::chrono::steady_clock::now();
+    size_t const count = config.getInputCount();
+
+    // All the materials share the shader compiler and the job system. The variants of all the
+    // materials being built end up in the same work queue.
+    MaterialBuilder::init();
+    JobSystem js;
+    js.adopt();
+
+    Mutex reportLock;
+    std::atomic<size_t> failures(0);
+    auto compile = [&](size_t index) {
+        Config::Input* input = config.getInputAt(index);
+        std::ostringstream report;
+        bool compiled = false;
+        ssize_t size = 0;
+        std::unique_ptr<const char[]> const buffer = readInput(config, input, &size, report);
+        bool const success = buffer && compileMaterial(config, input, config.getOutputAt(index),
+                buffer.get(), size_t(size), js, report, &compiled);
+        if (!success) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::lock_guard<Mutex> const lock(reportLock);
+        std::ostream& out = success ? std::cout : std::cerr;
+        out << (success ? "Compiled " : "Failed to compile ") << input->getName() << std::endl
+                << report.str();
+        return compiled;
+    };
+
+    // glslang performs unguarded global operations on first use, so materials are built one at a
+    // time until one of them has compiled shaders. Materials whose shaders all come from the shader
+    // cache, or that fail before reaching the compiler, don't count.
+    size_t first = 0;
+    while (first < count && !compile(first++)) {
+    }
+
+    // Materials are picked by a fixed number of jobs rather than one job each: a thread waiting
+    // for the variants of its material may run another material job, and this bounds the nesting.
+    // Each material keeps a bounded number of variant jobs in flight (see
+    // MaterialBuilder::generateShaders()), so with at most 32 threads the jobs of all the
+    // materials fit in the job system.
+    std::atomic<size_t> next(first);
+    JobSystem::Job* parent = js.createJob();
+    for (size_t i = 0, n = std::min(js.getThreadCount() + 1, count - first); i < n; i++) {
+        js.run(jobs::createJob(js, parent, [&compile, &next, count] {
+            for (size_t index = next++; index < count; index = next++) {
+                compile(index);
+            }
+        }));
+    }
+    js.runAndWait(parent);
+
+    js.emancipate();
+    MaterialBuilder::shutdown();
+
+    std::chrono::duration<double> const duration = std::chrono::steady_clock::now() - startTime;
+    std::cout << "Compiled " << count - failures.load() << " of " << count << " materials in "
+            << std::fixed << std::setprecision(2) << duration.count() << " s" << std::endl;
+    return failures.load() == 0;
+}
+
+bool MaterialCompiler::compileMaterial(const Config& config, Config::Input* input,
+        Config::Output* output, const char* buffer, size_t size, JobSystem& js,
+        std::ostream& report, bool* compiled) const {
+    utils::Path const materialFilePath = utils::Path(input->getName()).getAbsolutePath();
+    assert(materialFilePath.isFile());
+    *compiled = false;
+
     MaterialBuilder builder;
     // Before attempting an expensive lex, let's find out if we were sent pure JSON.
     bool parsed;
-    if (isValidJsonStart(buffer.get(), size_t(size))) {
-        parsed = parseMaterialAsJSON(buffer.get(), size_t(size), builder);
+    if (isValidJsonStart(buffer, size)) {
+        parsed = parseMaterialAsJSON(buffer, size, builder);
     } else {
-        parsed = parseMaterial(buffer.get(), size_t(size), builder);
+        parsed = parseMaterial(buffer, size, builder);
     }
 
     if (!parsed) {
@@ -384,7 +493,7 @@ bool MaterialCompiler::run(const Config& config) {
     }
 
     if (builder.getFeatureLevel() > config.getFeatureLevel()) {
-        std::cerr << "Material feature level (" << +builder.getFeatureLevel() << ") is higher "
+        report << "Material feature level (" << +builder.getFeatureLevel() << ") is higher "
                 "than maximum allowed (" << +config.getFeatureLevel() << ")" << std::endl;
         return false;
     }
@@ -411,6 +520,8 @@ bool MaterialCompiler::run(const Config& config) {
         .printShaders(config.printShaders())
         .saveRawVariants(config.saveRawVariants())
         .generateDebugInfo(config.isDebug())
+        .aggressiveMinification(config.aggressiveMinification())
+        .shaderCacheDirectory(config.getShaderCacheDirectory().c_str())
         .variantFilter(config.getVariantFilter() | builder.getVariantFilter());
 
     for (const auto& define : config.getDefines()) {
@@ -418,24 +529,55 @@ bool MaterialCompiler::run(const Config& config) {
     }
 
     if (!processMaterialParameters(builder, config)) {
-        std::cerr << "Error while processing material parameters." << std::endl;
+        report << "Error while processing material parameters." << std::endl;
         return false;
     }
 
-    JobSystem js;
-    js.adopt();
-
     // Write builder.build() to output.
     Package const package = builder.build(js);
 
-    js.emancipate();
-    MaterialBuilder::shutdown();
+    // Without a shader cache, every shader goes through the compiler.
+    *compiled = config.getShaderCacheDirectory().empty() ||
+            builder.getShaderCacheStats().misses > 0;
+
+    if (!config.getShaderCacheDirectory().empty()) {
+        MaterialBuilder::ShaderCacheStats const stats = builder.getShaderCacheStats();
+        report << "Shader cache: " << stats.hits << " hits, " << stats.misses << " misses"
+                << std::endl;
+    }
+
+    if (config.printTimings()) {
+        // Stage times are summed over all the threads of the job system.
+        MaterialBuilder::ShaderTimings const timings = builder.getShaderTimings();
+        auto print = [&report](const char* stage, double seconds) {
+            report << "    " << std::left << std::setw(20) << stage << std::right
+                    << std::fixed << std::setprecision(3) << std::setw(10) << seconds * 1e3
+                    << " ms" << std::endl;
+        };
+        report << "Shader compilation time per stage (all threads):" << std::endl;
+        print("code generation", timings.generation);
+        print("parsing", timings.parsing);
+        print("optimization", timings.optimization);
+        print("cross-compilation", timings.crossCompilation);
+        print("minification", timings.minification);
+    }
+
+    if (config.aggressiveMinification() || config.printTimings()) {
+        MaterialBuilder::MinificationStats const stats = builder.getMinificationStats();
+        if (stats.sourceSize) {
+            report << "GLSL shaders: " << stats.sourceSize << " bytes, "
+                    << stats.minifiedSize << " bytes minified (" << std::fixed
+                    << std::setprecision(1)
+                    << 100.0 * double(stats.minifiedSize) / double(stats.sourceSize) << "%)"
+                    << std::endl;
+        }
+    }
 
     if (!package.isValid()) {
-        std::cerr << "Could not compile material " << input->getName() << std::endl;
+        report << "Could not compile material " << input->getName() << std::endl;
         return false;
     }
-    return writePackage(package, config);
+    return writePackage(package, config, output);
 }
 
 bool MaterialCompiler::checkParameters(const Config& config) {
@@ -445,15 +587,23 @@ bool MaterialCompiler::checkParameters(const Config& config) {
         return false;
     }
 
+    if (config.getInputCount() > 1 &&
+            (config.rawShaderMode() || config.getReflectionTarget() != Config::Metadata::NONE)) {
+        std::cerr << "--raw and --reflect require a single input file." << std::endl;
+        return false;
+    }
+
     // If we have reflection we don't need an output file
     if (config.getReflectionTarget() != Config::Metadata::NONE) {
         return true;
     }
 
     // Check for output format.
-    if (config.getOutput() == nullptr) {
-        std::cerr << "Missing output filename." << std::endl;
-        return false;
+    for (size_t i = 0; i < config.getInputCount(); i++) {
+        if (config.getOutputAt(i) == nullptr) {
+            std::cerr << "Missing output filename." << std::endl;
+            return false;
+        }
     }
 
     return true;
@@ -17,6 +17,7 @@
 #ifndef TNT_MATERIALCOMPILER_H
 #define TNT_MATERIALCOMPILER_H
 
+#include <ostream>
 #include <string>
 #include <unordered_map>
 
@@ -26,6 +27,9 @@
 namespace filamat {
 class MaterialBuilder;
 }
+namespace utils {
+class JobSystem;
+}
 class TestMaterialCompiler;
 
 namespace matc {
@@ -42,6 +46,17 @@ public:
 private:
     friend class ::TestMaterialCompiler;
 
+    // Compiles all the inputs of the config concurrently, writing each output as soon as it is
+    // ready.
+    bool compileMaterials(const Config& config) const;
+
+    // Compiles a single material, whose statistics and errors are printed to the given report
+    // stream. compiled is set to true if shaders went through the compiler, rather than all being
+    // read from the shader cache.
+    bool compileMaterial(const Config& config, Config::Input* input, Config::Output* output,
+            const char* buffer, size_t size, utils::JobSystem& js, std::ostream& report,
+            bool* compiled) const;
+
     bool parseMaterial(const char* buffer, size_t size,
             filamat::MaterialBuilder& builder) const noexcept;
     bool processMaterial(const MaterialLexeme&,
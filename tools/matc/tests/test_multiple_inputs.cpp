@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <matc/CommandlineConfig.h>
+#include <matc/MaterialCompiler.h>
+
+#include <getopt/getopt.h>
+
+#include <utils/Path.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using utils::Path;
+
+static const char* const validMaterial = R"(
+    material {
+        name : valid,
+        shadingModel : unlit
+    }
+
+    fragment {
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor.rgb = vec3(0.8);
+        }
+    }
+)";
+
+static const char* const invalidMaterial = R"(
+    material {
+        name : invalid,
+        shadingModel : unlit
+    }
+
+    fragment {
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor.rgb = undefinedColor;
+        }
+    }
+)";
+
+class MultipleInputs : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mRoot = Path::getTemporaryDirectory() + "test_matc_multiple_inputs";
+        mOutputs = mRoot + "outputs";
+        clear();
+        ASSERT_TRUE((mRoot + "a").mkdirRecursive());
+        ASSERT_TRUE((mRoot + "b").mkdirRecursive());
+    }
+
+    void TearDown() override {
+        clear();
+    }
+
+    Path writeInput(std::string const& name, const char* source) {
+        Path const path = mRoot + name;
+        std::ofstream(path.getPath()) << source;
+        mFiles.push_back(path);
+        return path;
+    }
+
+    // Parses the command line of matc, which must list the options before the inputs.
+    static std::unique_ptr<matc::CommandlineConfig> parse(std::vector<std::string> arguments) {
+        std::vector<char*> argv = { const_cast<char*>("matc") };
+        for (std::string& argument : arguments) {
+            argv.push_back(argument.data());
+        }
+        // Restart getopt, which keeps its state in globals.
+        optind = 0;
+        return std::make_unique<matc::CommandlineConfig>(int(argv.size()), argv.data());
+    }
+
+    Path mRoot;
+    Path mOutputs;
+
+private:
+    void clear() {
+        for (Path& file : mFiles) {
+            file.unlinkFile();
+        }
+        for (Path output : mOutputs.listContents()) {
+            output.unlinkFile();
+        }
+        mFiles.clear();
+    }
+
+    std::vector<Path> mFiles;
+};
+
+TEST_F(MultipleInputs, OutputDirectory) {
+    Path const first = writeInput("a/first.mat", validMaterial);
+    Path const second = writeInput("b/second.mat", validMaterial);
+    Path const invalid = writeInput("a/invalid.mat", invalidMaterial);
+
+    auto config = parse({ "--api=opengl", "--platform=mobile", "--output-dir=" + mOutputs.getPath(),
+            first.getPath(), second.getPath(), invalid.getPath() });
+    ASSERT_TRUE(config->isValid());
+    ASSERT_EQ(config->getInputCount(), 3);
+    EXPECT_TRUE(mOutputs.isDirectory());
+
+    std::ostringstream log;
+    std::streambuf* const cout = std::cout.rdbuf(log.rdbuf());
+    std::streambuf* const cerr = std::cerr.rdbuf(log.rdbuf());
+    matc::MaterialCompiler compiler;
+    bool const success = compiler.compile(*config);
+    std::cout.rdbuf(cout);
+    std::cerr.rdbuf(cerr);
+
+    // Outputs are named after the inputs. The invalid material fails on its own, without
+    // stopping the other ones.
+    EXPECT_FALSE(success);
+    EXPECT_TRUE((mOutputs + "first.filamat").isFile());
+    EXPECT_TRUE((mOutputs + "second.filamat").isFile());
+    EXPECT_FALSE((mOutputs + "invalid.filamat").exists());
+    EXPECT_NE(log.str().find("Failed to compile " + invalid.getPath()), std::string::npos);
+    EXPECT_NE(log.str().find("Compiled 2 of 3 materials"), std::string::npos) << log.str();
+}
+
+TEST_F(MultipleInputs, Errors) {
+    Path const first = writeInput("a/same.mat", validMaterial);
+    Path const second = writeInput("b/same.mat", validMaterial);
+
+    std::ostringstream log;
+    std::streambuf* const cerr = std::cerr.rdbuf(log.rdbuf());
+
+    // Both inputs would be written to the same output.
+    auto config = parse({ "--output-dir=" + mOutputs.getPath(), first.getPath(),
+            second.getPath() });
+    EXPECT_FALSE(config->isValid());
+    EXPECT_NE(log.str().find("Several input files would be written to same.filamat"),
+            std::string::npos);
+
+    // Several inputs require an output directory.
+    config = parse({ "--output=" + (mOutputs + "same.filamat").getPath(), first.getPath(),
+            second.getPath() });
+    EXPECT_FALSE(config->isValid());
+    EXPECT_NE(log.str().find("Several input files require an output directory"),
+            std::string::npos);
+
+    std::cerr.rdbuf(cerr);
+}
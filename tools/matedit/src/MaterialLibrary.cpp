@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaterialLibrary.h"
+#include "PackageUtils.h"
+
+#include "eiff/BlobDictionary.h"
+#include "eiff/ChunkContainer.h"
+#include "eiff/DictionaryMetalLibraryChunk.h"
+#include "eiff/DictionarySpirvChunk.h"
+#include "eiff/DictionaryTextChunk.h"
+#include "eiff/LineDictionary.h"
+#include "eiff/MaterialBinaryChunk.h"
+#include "eiff/MaterialTextChunk.h"
+#include "eiff/ShaderEntry.h"
+
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryReader.h>
+
+#include <filamat/Package.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using filamat::ChunkType;
+using filamat::Flattener;
+using filamat::Package;
+
+namespace matedit {
+
+namespace {
+
+struct InputMaterial {
+    std::string name;
+    std::vector<uint8_t> buffer;
+    std::unique_ptr<filaflat::ChunkContainer> container;
+    std::vector<filamat::TextEntry> glslEntries;
+    std::vector<filamat::TextEntry> essl1Entries;
+    std::vector<filamat::TextEntry> mslEntries;
+    std::vector<filamat::BinaryEntry> spirvEntries;
+    std::vector<filamat::BinaryEntry> metalLibraryEntries;
+};
+
+// The LibraryMaterials chunk lists the materials of a library, each stored as a regular material
+// package whose shader chunks index into the dictionaries of the library.
+class LibraryMaterialsChunk final : public filamat::Chunk {
+public:
+    explicit LibraryMaterialsChunk(std::vector<std::pair<std::string, Package>>&& materials)
+        : filamat::Chunk(ChunkType::LibraryMaterials), mMaterials(std::move(materials)) {}
+
+    ~LibraryMaterialsChunk() = default;
+
+private:
+    void flatten(Flattener& f) override {
+        f.writeUint32(uint32_t(mMaterials.size()));
+        for (auto const& [name, package] : mMaterials) {
+            f.writeString(name.c_str());
+            f.writeBlob(reinterpret_cast<const char*>(package.getData()), package.getSize());
+        }
+    }
+
+    std::vector<std::pair<std::string, Package>> mMaterials;
+};
+
+bool isShaderChunk(ChunkType type) {
+    switch (type) {
+        case ChunkType::MaterialGlsl:
+        case ChunkType::MaterialEssl1:
+        case ChunkType::MaterialMetal:
+        case ChunkType::MaterialSpirv:
+        case ChunkType::MaterialMetalLibrary:
+        case ChunkType::DictionaryText:
+        case ChunkType::DictionarySpirv:
+        case ChunkType::DictionaryMetalLibrary:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool readMaterial(utils::Path const& input, InputMaterial& material) {
+    if (!readBinary(input, material.buffer)) {
+        std::cerr << "Could not read the source material " << input << std::endl;
+        return false;
+    }
+
+    material.name = input.getNameWithoutExtension();
+    material.container = std::make_unique<filaflat::ChunkContainer>(
+            material.buffer.data(), material.buffer.size());
+
+    filaflat::ChunkContainer& container = *material.container;
+    if (!container.parse() || container.hasChunk(ChunkType::LibraryMaterials)) {
+        std::cerr << "The source material " << input << " is not a valid material" << std::endl;
+        return false;
+    }
+
+    filaflat::BlobDictionary textBlobs;
+    filaflat::BlobDictionary spirvBlobs;
+    filaflat::BlobDictionary metalLibraryBlobs;
+    filaflat::DictionaryReader reader;
+    if (container.hasChunk(ChunkType::DictionaryText) &&
+            !reader.unflatten(container, ChunkType::DictionaryText, textBlobs)) {
+        return false;
+    }
+    if (container.hasChunk(ChunkType::DictionarySpirv) &&
+            !reader.unflatten(container, ChunkType::DictionarySpirv, spirvBlobs)) {
+        return false;
+    }
+    if (container.hasChunk(ChunkType::DictionaryMetalLibrary) &&
+            !reader.unflatten(container, ChunkType::DictionaryMetalLibrary, metalLibraryBlobs)) {
+        return false;
+    }
+
+    material.glslEntries = getShaderRecords<filamat::TextEntry>(
+            container, textBlobs, ChunkType::MaterialGlsl);
+    material.essl1Entries = getShaderRecords<filamat::TextEntry>(
+            container, textBlobs, ChunkType::MaterialEssl1);
+    material.mslEntries = getShaderRecords<filamat::TextEntry>(
+            container, textBlobs, ChunkType::MaterialMetal);
+    material.spirvEntries = getShaderRecords<filamat::BinaryEntry>(
+            container, spirvBlobs, ChunkType::MaterialSpirv);
+    material.metalLibraryEntries = getShaderRecords<filamat::BinaryEntry>(
+            container, metalLibraryBlobs, ChunkType::MaterialMetalLibrary);
+    return true;
+}
+
+Package flattenPackage(filamat::ChunkContainer const& chunks) {
+    Package package(chunks.getSize());
+    Flattener f{ package.getData() };
+    chunks.flatten(f);
+    return package;
+}
+
+} // anonymous namespace
+
+int createLibrary(std::vector<utils::Path> inputs, utils::Path output) {
+    std::vector<InputMaterial> materials(inputs.size());
+    std::unordered_set<std::string> names;
+    size_t inputSize = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!readMaterial(inputs[i], materials[i])) {
+            return 1;
+        }
+        if (!names.insert(materials[i].name).second) {
+            std::cerr << "Duplicate material name '" << materials[i].name << "' in library"
+                      << std::endl;
+            return 1;
+        }
+        inputSize += materials[i].buffer.size();
+    }
+
+    // Merge the shaders of all materials into dictionaries shared by the whole library. Binary
+    // shaders are deduplicated as a whole, text shaders line by line.
+    filamat::LineDictionary textDictionary;
+    filamat::BlobDictionary spirvDictionary;
+    filamat::BlobDictionary metalLibraryDictionary;
+    for (auto& material : materials) {
+        for (auto const* entries : { &material.glslEntries, &material.essl1Entries,
+                &material.mslEntries }) {
+            for (auto const& e : *entries) {
+                textDictionary.addText(e.shader);
+            }
+        }
+        for (auto& e : material.spirvEntries) {
+            std::vector<uint8_t> const spirv = std::move(e.data);
+            e.dictionaryIndex = spirvDictionary.addBlob(spirv);
+        }
+        for (auto& e : material.metalLibraryEntries) {
+            std::vector<uint8_t> const data = std::move(e.data);
+            e.dictionaryIndex = metalLibraryDictionary.addBlob(data);
+        }
+    }
+
+    // Text shaders reference their lines with 16-bit indices.
+    if (textDictionary.getLineCount() > size_t(UINT16_MAX) + 1) {
+        std::cerr << "The library has " << textDictionary.getLineCount()
+                  << " unique shader lines, which exceeds the limit of " << UINT16_MAX + 1
+                  << ". Split the materials into several libraries." << std::endl;
+        return 1;
+    }
+
+    // Re-emit each material against the shared dictionaries. All the other chunks are kept as-is.
+    std::vector<std::pair<std::string, Package>> packages;
+    packages.reserve(materials.size());
+    for (auto& material : materials) {
+        filaflat::ChunkContainer const& container = *material.container;
+        filamat::ChunkContainer chunks;
+        for (size_t i = 0; i < container.getChunkCount(); i++) {
+            filaflat::ChunkContainer::Chunk const c = container.getChunk(i);
+            if (!isShaderChunk(c.type)) {
+                chunks.push<PassthroughChunk>(
+                        reinterpret_cast<const char*>(c.desc.start), c.desc.size, c.type);
+            }
+        }
+        if (!material.glslEntries.empty()) {
+            chunks.push<filamat::MaterialTextChunk>(std::move(material.glslEntries),
+                    textDictionary, ChunkType::MaterialGlsl);
+        }
+        if (!material.essl1Entries.empty()) {
+            chunks.push<filamat::MaterialTextChunk>(std::move(material.essl1Entries),
+                    textDictionary, ChunkType::MaterialEssl1);
+        }
+        if (!material.mslEntries.empty()) {
+            chunks.push<filamat::MaterialTextChunk>(std::move(material.mslEntries),
+                    textDictionary, ChunkType::MaterialMetal);
+        }
+        if (!material.spirvEntries.empty()) {
+            chunks.push<filamat::MaterialBinaryChunk>(
+                    std::move(material.spirvEntries), ChunkType::MaterialSpirv);
+        }
+        if (!material.metalLibraryEntries.empty()) {
+            chunks.push<filamat::MaterialBinaryChunk>(
+                    std::move(material.metalLibraryEntries), ChunkType::MaterialMetalLibrary);
+        }
+        packages.emplace_back(std::move(material.name), flattenPackage(chunks));
+    }
+
+    filamat::ChunkContainer libraryChunks;
+    if (!textDictionary.isEmpty()) {
+        libraryChunks.push<filamat::DictionaryTextChunk>(
+                std::move(textDictionary), ChunkType::DictionaryText);
+    }
+    if (!spirvDictionary.isEmpty()) {
+        // The SPIR-V was already processed when the input materials were built.
+        const bool stripInfo = false;
+        libraryChunks.push<filamat::DictionarySpirvChunk>(std::move(spirvDictionary), stripInfo);
+    }
+    if (!metalLibraryDictionary.isEmpty()) {
+        libraryChunks.push<filamat::DictionaryMetalLibraryChunk>(
+                std::move(metalLibraryDictionary));
+    }
+    libraryChunks.push<LibraryMaterialsChunk>(std::move(packages));
+
+    Package const library = flattenPackage(libraryChunks);
+    assert_invariant(library.isValid());
+
+    dumpBinary(library.getData(), library.getSize(), output);
+
+    std::cout << "Wrote " << inputs.size() << " materials to " << output << " ("
+              << library.getSize() << " bytes, " << inputSize << " bytes before merging)"
+              << std::endl;
+    return 0;
+}
+
+} // namespace matedit
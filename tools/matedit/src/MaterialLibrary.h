@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_MATEDIT_MATERIALLIBRARY_H
+#define TNT_MATEDIT_MATERIALLIBRARY_H
+
+#include <utils/Path.h>
+
+#include <vector>
+
+namespace matedit {
+
+// Bundles several compiled materials into a single library package. The shader dictionaries of
+// all inputs are merged into one, which is shared by the materials of the library. Materials are
+// named after their input file, without the extension.
+int createLibrary(std::vector<utils::Path> inputs, utils::Path output);
+
+} // namespace matedit
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_MATEDIT_PACKAGEUTILS_H
+#define TNT_MATEDIT_PACKAGEUTILS_H
+
+#include "eiff/Chunk.h"
+#include "eiff/Flattener.h"
+#include "eiff/ShaderEntry.h"
+
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/MaterialChunk.h>
+
+#include <filament/MaterialChunkType.h>
+
+#include <private/filament/Variant.h>
+
+#include <backend/DriverEnums.h>
+
+#include <utils/Path.h>
+#include <utils/debug.h>
+
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace matedit {
+
+// Copies an existing chunk of a parsed package verbatim into a new package.
+class PassthroughChunk final : public filamat::Chunk {
+public:
+    explicit PassthroughChunk(const char* data, size_t size, filamat::ChunkType type)
+        : filamat::Chunk(type), data(data), size(size) {}
+
+    ~PassthroughChunk() = default;
+
+private:
+    void flatten(filamat::Flattener& f) override { f.writeRaw(data, size); }
+
+    const char* data;
+    size_t size;
+};
+
+inline void dumpBinary(const uint8_t* data, size_t size, utils::Path filename) {
+    std::ofstream out(filename, std::ofstream::binary);
+    out.write(reinterpret_cast<const char*>(data), size);
+}
+
+inline bool readBinary(utils::Path filename, std::vector<uint8_t>& buffer) {
+    std::ifstream in(filename, std::ifstream::binary | std::ifstream::in);
+    if (!in) {
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    std::ifstream::pos_type size = in.tellg();
+    in.seekg(0);
+    buffer.resize(size);
+    if (!in.read((char*)buffer.data(), size)) {
+        return false;
+    }
+    return true;
+}
+
+// Decodes every shader of the given chunk type into entries that can be re-emitted by filamat.
+template <typename T>
+std::vector<T> getShaderRecords(const filaflat::ChunkContainer& container,
+        const filaflat::BlobDictionary& dictionary, filamat::ChunkType chunkType) {
+    if (!container.hasChunk(chunkType)) {
+        return {};
+    }
+    std::vector<T> shaderRecords;
+    filaflat::MaterialChunk materialChunk(container);
+    materialChunk.initialize(chunkType);
+    materialChunk.visitShaders(
+            [&materialChunk, &dictionary, &shaderRecords](filament::backend::ShaderModel shaderModel,
+                    filament::Variant variant, filament::backend::ShaderStage stage) {
+                filaflat::ShaderContent content;
+                UTILS_UNUSED_IN_RELEASE bool success =
+                        materialChunk.getShader(content, dictionary, shaderModel, variant, stage);
+
+                std::string source { content.data(), content.data() + content.size() - 1u };
+                assert_invariant(success);
+
+                if constexpr (std::is_same_v<T, filamat::TextEntry>) {
+                    shaderRecords.push_back({ shaderModel, variant, stage, std::move(source) });
+                }
+                if constexpr (std::is_same_v<T, filamat::BinaryEntry>) {
+                    filamat::BinaryEntry e {};
+                    e.shaderModel = shaderModel;
+                    e.variant = variant;
+                    e.stage = stage;
+                    e.dictionaryIndex = 0;
+                    e.data = std::vector<uint8_t>(content.begin(), content.end());
+                    shaderRecords.push_back(std::move(e));
+                }
+            });
+    return shaderRecords;
+}
+
+} // namespace matedit
+
+#endif // TNT_MATEDIT_PACKAGEUTILS_H
@@ -17,6 +17,7 @@
 #include <getopt/getopt.h>
 
 #include "ExternalCompile.h"
+#include "MaterialLibrary.h"
 
 #include <utils/Path.h>
 
@@ -43,6 +44,7 @@ static void printUsage(const char* name) {
         "\n"
         "Usage:\n"
         "    MATEDIT [options] -o <output file> -i <input file> external-compile -- <script> [<script args>...]\n"
+        "    MATEDIT [options] -o <output file> library <input file> [<input file>...]\n"
         "\n"
         "Options:\n"
         "   --help, -h\n"
@@ -90,8 +92,16 @@ static void printUsage(const char* name) {
         "       If script exits with a non-zero exit code, MATEDIT will terminate with error. Multiple\n"
         "       invocations of script may be launched in parallel.\n"
         "\n"
-        "Example:\n"
+        "   library\n"
+        "       Bundles the given compiled materials into a single material library. The shaders of all the\n"
+        "       materials are stored in dictionaries shared by the whole library, so that identical shaders\n"
+        "       and shader lines are stored only once. Each material is named after its input file, without\n"
+        "       the extension, and can be loaded with filament::Material::Builder::package() given the\n"
+        "       filament::MaterialLibrary built from the output file.\n"
+        "\n"
+        "Examples:\n"
         "   MATEDIT -o out.cmat -i in.cmat --type metal external-compile -- ./my_compile-script.sh --sdk iphones\n"
+        "   MATEDIT -o materials.filamatlib library lit.filamat unlit.filamat\n"
     );
 
     const std::string from("MATEDIT");
@@ -161,30 +171,53 @@ static int handleArguments(int argc, char* argv[], Config* config) {
     return optind;
 }
 
+static int createLibrary(int argc, char* argv[], int optionIndex, Config const& config) {
+    std::vector<utils::Path> inputs;
+    for (int i = optionIndex; i < argc; ++i) {
+        inputs.emplace_back(argv[i]);
+        if (!inputs.back().exists()) {
+            std::cerr << "The source material " << inputs.back() << " does not exist." << std::endl;
+            return 1;
+        }
+    }
+
+    if (inputs.empty()) {
+        std::cerr << "library requires at least one input material" << std::endl << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    return matedit::createLibrary(std::move(inputs), config.outputFile);
+}
+
 int main(int argc, char* argv[]) {
     Config config;
     int optionIndex = handleArguments(argc, argv, &config);
 
-    if (config.inputFile.isEmpty() || config.outputFile.isEmpty()) {
+    int numArgs = argc - optionIndex;
+    if (config.outputFile.isEmpty() || numArgs < 1) {
         printUsage(argv[0]);
         return 1;
     }
 
-    if (!config.inputFile.exists()) {
-        std::cerr << "The source material " << config.inputFile << " does not exist." << std::endl;
+    const std::string command = argv[optionIndex++];
+    if (command == "library") {
+        return createLibrary(argc, argv, optionIndex, config);
+    }
+
+    if (command != "external-compile") {
+        std::cerr << "Unrecognized command: '" << command
+                  << "'. Must be 'external-compile' or 'library'" << std::endl;
         return 1;
     }
 
-    int numArgs = argc - optionIndex;
-    if (numArgs < 1) {
+    if (config.inputFile.isEmpty()) {
         printUsage(argv[0]);
         return 1;
     }
 
-    const std::string command = argv[optionIndex++];
-    if (command != "external-compile") {
-        std::cerr << "Unrecognized command: '" << command << "'. Must be 'external-compile'"
-                  << std::endl;
+    if (!config.inputFile.exists()) {
+        std::cerr << "The source material " << config.inputFile << " does not exist." << std::endl;
         return 1;
     }
 
@@ -21,16 +21,22 @@
 #include <image/LinearImage.h>
 
 #include <imageio/BasisEncoder.h>
+#include <imageio/BatchManifest.h>
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 using namespace image;
 using namespace std;
@@ -58,6 +64,12 @@ static bool g_ktx2Container = false;
 static bool g_sourceIsLinear = false;
 static bool g_quietMode = false;
 static uint32_t g_mipLevelCount = 0;
+static std::string g_scratchDirectory;
+static std::string g_batchManifest;
+static BasisEncoder::Quality g_basisQuality = BasisEncoder::Quality::DEFAULT;
+
+// Worker threads shared by all KTX2 encoders, created on first use.
+static std::unique_ptr<BasisEncoder::JobPool> g_basisJobPool;
 
 static const char* USAGE = R"TXT(
 MIPGEN generates mipmaps for an image down to the 1x1 level.
@@ -71,6 +83,7 @@ If the output format is a container format like KTX, then
 
 Usage:
     MIPGEN [options] <input_file> <output_pattern>
+    MIPGEN [options] --batch=<manifest>
 
 Options:
    --help, -h
@@ -80,7 +93,7 @@ Options:
    --linear, -l
        specifies that the source image is linear (converts to floats without transformation)
    --page, -p
-       generate HTML page for review purposes (mipmap.html)
+       generate HTML page for review purposes (mipmap.html), ignored with --batch
    --quiet, -q
        suppress console output from the mipgen tool
    --grayscale, -g
@@ -96,6 +109,13 @@ Options:
    --mip-levels=N, -m N
        specifies the number of mip levels to generate
        if 0 (default), all levels are generated
+   --batch=MANIFEST, -b MANIFEST
+       process each "<input_file> <output_pattern>" line of MANIFEST with the
+       same options, skipping lines whose input file, output and options have
+       not changed since the last run (as recorded in MANIFEST.stamps)
+   --scratch=DIR, -T DIR
+       back large images with temporary files in DIR rather than RAM,
+       useful for textures that do not fit in memory
    --compression=COMPRESSION, -c COMPRESSION
        format specific compression:
            KTX, PNG, Radiance: Ignored
@@ -103,6 +123,8 @@ Options:
            Photoshop: 16 (default), 32
            OpenEXR: RAW, RLE, ZIPS, ZIP, PIZ (default)
            DDS: 8, 16 (default), 32
+   --quality=[fastest|fast|default|high|highest], -Q [quality]
+       speed / quality trade-off of KTX2 compression (defaults to default)
 
 Examples:
     MIPGEN -g --kernel=hermite grassland.png mip_%03d.png
@@ -151,7 +173,7 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:";
+    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:T:b:Q:";
     static const struct option OPTIONS[] = {
             { "help",                 no_argument, 0, 'h' },
             { "license",              no_argument, 0, 'L' },
@@ -165,6 +187,9 @@ static int handleArguments(int argc, char* argv[]) {
             { "add-alpha",            no_argument, 0, 'a' },
             { "quiet",                no_argument, 0, 'q' },
             { "mip-levels",     required_argument, 0, 'm' },
+            { "scratch",        required_argument, 0, 'T' },
+            { "batch",          required_argument, 0, 'b' },
+            { "quality",        required_argument, 0, 'Q' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -259,41 +284,90 @@ static int handleArguments(int argc, char* argv[]) {
                     // keep default value
                 }
                 break;
+            case 'T':
+                g_scratchDirectory = arg;
+                break;
+            case 'b':
+                g_batchManifest = arg;
+                break;
+            case 'Q':
+                if (arg == "fastest") {
+                    g_basisQuality = BasisEncoder::Quality::FASTEST;
+                } else if (arg == "fast") {
+                    g_basisQuality = BasisEncoder::Quality::FAST;
+                } else if (arg == "default") {
+                    g_basisQuality = BasisEncoder::Quality::DEFAULT;
+                } else if (arg == "high") {
+                    g_basisQuality = BasisEncoder::Quality::HIGH;
+                } else if (arg == "highest") {
+                    g_basisQuality = BasisEncoder::Quality::HIGHEST;
+                } else {
+                    cerr << "Unrecognized quality: " << arg << endl;
+                    exit(1);
+                }
+                break;
         }
     }
 
     return optind;
 }
 
-int main(int argc, char* argv[]) {
-    int optionIndex = handleArguments(argc, argv);
-    int numArgs = argc - optionIndex;
-    if (numArgs < 2) {
-        printUsage(argv[0]);
-        return 1;
-    }
-    Path inputPath(argv[optionIndex++]);
-    std::string outputPattern(argv[optionIndex]);
-    if (Path(outputPattern).getExtension() == "ktx") {
-        g_ktx1Container = true;
-        g_formatSpecified = true;
-    } else if (Path(outputPattern).getExtension() == "ktx2") {
-        g_ktx2Container = true;
-        g_formatSpecified = true;
+// Describes where and how the miplevels of a single image are written.
+struct OutputSpec {
+    std::string pattern;
+    ImageEncoder::Format format;
+    bool ktx1Container;
+    bool ktx2Container;
+};
+
+// Wall clock time spent in each stage, in seconds.
+struct StageTimings {
+    double decode = 0;
+    double mipmaps = 0;
+    double encode = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static OutputSpec resolveOutput(const std::string& outputPattern) {
+    OutputSpec spec{ outputPattern, g_format, g_ktx1Container, g_ktx2Container };
+    const std::string extension = Path(outputPattern).getExtension();
+    if (extension == "ktx") {
+        spec.ktx1Container = true;
+    } else if (extension == "ktx2") {
+        spec.ktx2Container = true;
     } else if (!g_formatSpecified) {
-        g_format = ImageEncoder::chooseFormat(outputPattern, g_sourceIsLinear);
+        spec.format = ImageEncoder::chooseFormat(outputPattern, g_sourceIsLinear);
     }
+    return spec;
+}
 
-    if (!g_quietMode) {
-        puts("Reading image...");
+// Returns the path of the first file written for the given output, or an empty string if the
+// output pattern is invalid.
+static std::string getFirstOutputPath(const OutputSpec& spec) {
+    if (spec.ktx1Container || spec.ktx2Container) {
+        return spec.pattern;
+    }
+    char path[256];
+    int result = snprintf(path, sizeof(path), spec.pattern.c_str(), 1);
+    if (result < 0 || result >= sizeof(path)) {
+        return {};
     }
+    return path;
+}
 
+// Decodes the source image and applies the channel options, returns an invalid image on failure.
+static LinearImage loadSourceImage(const Path& inputPath) {
     ifstream inputStream(inputPath.getPath(), ios::binary);
     LinearImage sourceImage = ImageDecoder::decode(inputStream, inputPath.getPath(),
             g_sourceIsLinear ? ImageDecoder::ColorSpace::LINEAR : ImageDecoder::ColorSpace::SRGB);
     if (!sourceImage.isValid()) {
         cerr << "Unable to open image: " << inputPath.getPath() << endl;
-        return 1;
+        return {};
     }
     if (g_stripAlpha && sourceImage.getChannels() == 4) {
         auto r = extractChannel(sourceImage, 0);
@@ -316,209 +390,479 @@ int main(int argc, char* argv[]) {
     if (g_filter == Filter::GAUSSIAN_NORMALS) {
         sourceImage = colorsToVectors(sourceImage);
     }
+    return sourceImage;
+}
 
+static bool writeKtx1(const LinearImage& sourceImage, const vector<LinearImage>& miplevels,
+        const OutputSpec& spec) {
     if (!g_quietMode) {
-        puts("Generating miplevels...");
+        puts("Writing KTX file to disk...");
     }
 
-    uint32_t count = getMipmapCount(sourceImage);
-    count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
-    vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
-
-    if (g_ktx1Container) {
-        if (!g_quietMode) {
-            puts("Writing KTX file to disk...");
-        }
-
-        // The libimage API does not include the original image in the mip array,
-        // which might make sense when generating individual files, but for a KTX
-        // bundle, we want to include level 0, so add 1 to the KTX level count.
-        Ktx1Bundle container(1 + miplevels.size(), 1, false);
-        auto& info = container.info();
-        info = {
-            .endianness = Ktx1Bundle::ENDIAN_DEFAULT,
-            .glType = Ktx1Bundle::UNSIGNED_BYTE,
-            .glTypeSize = 1,
-            .pixelWidth = sourceImage.getWidth(),
-            .pixelHeight = sourceImage.getHeight(),
-            .pixelDepth = 0,
-        };
-        size_t componentCount = sourceImage.getChannels();
-
-        // Try to choose an internal format that has the same transformation function as the
-        // source format. This varible may be adjusted later, after the destination format has
-        // been resolved.
-        bool destIsLinear = g_sourceIsLinear;
-
-        if (componentCount == 1) {
-            info.glFormat = info.glBaseInternalFormat = Ktx1Bundle::RED;
-            info.glInternalFormat = Ktx1Bundle::R8;
-            destIsLinear = true;
-        } else if (componentCount == 3) {
-            info.glFormat = info.glBaseInternalFormat = Ktx1Bundle::RGB;
-            info.glInternalFormat = destIsLinear ? Ktx1Bundle::RGB8 : Ktx1Bundle::SRGB8;
-        } else if (componentCount == 4) {
-            info.glFormat = info.glBaseInternalFormat = Ktx1Bundle::RGBA;
-            info.glInternalFormat = destIsLinear ? Ktx1Bundle::RGBA8 : Ktx1Bundle::SRGB8_ALPHA8;
-        } else {
-            cerr << "Bad component count." << endl;
-            return 1;
-        }
-        if (g_ktxCompression != NONE) {
-            cerr << "Compression not supported with KTX1." << endl;
-            return 1;
+    // The libimage API does not include the original image in the mip array,
+    // which might make sense when generating individual files, but for a KTX
+    // bundle, we want to include level 0, so add 1 to the KTX level count.
+    Ktx1Bundle container(1 + miplevels.size(), 1, false);
+    auto& info = container.info();
+    info = {
+        .endianness = Ktx1Bundle::ENDIAN_DEFAULT,
+        .glType = Ktx1Bundle::UNSIGNED_BYTE,
+        .glTypeSize = 1,
+        .pixelWidth = sourceImage.getWidth(),
+        .pixelHeight = sourceImage.getHeight(),
+        .pixelDepth = 0,
+    };
+    size_t componentCount = sourceImage.getChannels();
+
+    // Try to choose an internal format that has the same transformation function as the
+    // source format. This varible may be adjusted later, after the destination format has
+    // been resolved.
+    bool destIsLinear = g_sourceIsLinear;
+
+    if (componentCount == 1) {
+        info.glFormat = info.glBaseInternalFormat = Ktx1Bundle::RED;
+        info.glInternalFormat = Ktx1Bundle::R8;
+        destIsLinear = true;
+    } else if (componentCount == 3) {
+        info.glFormat = info.glBaseInternalFormat = Ktx1Bundle::RGB;
+        info.glInternalFormat = destIsLinear ? Ktx1Bundle::RGB8 : Ktx1Bundle::SRGB8;
+    } else if (componentCount == 4) {
+        info.glFormat = info.glBaseInternalFormat = Ktx1Bundle::RGBA;
+        info.glInternalFormat = destIsLinear ? Ktx1Bundle::RGBA8 : Ktx1Bundle::SRGB8_ALPHA8;
+    } else {
+        cerr << "Bad component count." << endl;
+        return false;
+    }
+    if (g_ktxCompression != NONE) {
+        cerr << "Compression not supported with KTX1." << endl;
+        return false;
+    }
+    uint32_t mip = 0;
+    auto addLevel = [&](LinearImage image) {
+        if (g_filter == Filter::GAUSSIAN_NORMALS) {
+            image = vectorsToColors(image);
         }
-        uint32_t mip = 0;
-        auto addLevel = [&](LinearImage image) {
-            if (g_filter == Filter::GAUSSIAN_NORMALS) {
-                image = vectorsToColors(image);
+        std::unique_ptr<uint8_t[]> data;
+        if (g_grayscale && destIsLinear) {
+            data = fromLinearToGrayscale<uint8_t>(image);
+        } else if (g_grayscale) {
+            data = fromLinearTosRGB<uint8_t, 1>(image);
+        } else if (destIsLinear) {
+            if (componentCount == 3) {
+                data = fromLinearToRGB<uint8_t, 3>(image);
+            } else {
+                data = fromLinearToRGB<uint8_t, 4>(image);
             }
-            std::unique_ptr<uint8_t[]> data;
-            if (g_grayscale && destIsLinear) {
-                data = fromLinearToGrayscale<uint8_t>(image);
-            } else if (g_grayscale) {
-                data = fromLinearTosRGB<uint8_t, 1>(image);
-            } else if (destIsLinear) {
-                if (componentCount == 3) {
-                    data = fromLinearToRGB<uint8_t, 3>(image);
-                } else {
-                    data = fromLinearToRGB<uint8_t, 4>(image);
-                }
+        } else {
+            if (componentCount == 3) {
+                data = fromLinearTosRGB<uint8_t, 3>(image);
             } else {
-                if (componentCount == 3) {
-                    data = fromLinearTosRGB<uint8_t, 3>(image);
-                } else {
-                    data = fromLinearTosRGB<uint8_t, 4>(image);
-                }
+                data = fromLinearTosRGB<uint8_t, 4>(image);
             }
-            container.setBlob({mip++, 0, 0}, data.get(), image.getWidth() * image.getHeight() *
-                    container.info().glTypeSize * componentCount);
-        };
-        addLevel(sourceImage);
-        for (auto image : miplevels) {
-            addLevel(image);
         }
-        vector<uint8_t> fileContents(container.getSerializedLength());
-        container.serialize(fileContents.data(), fileContents.size());
-        Path(outputPattern).getParent().mkdirRecursive();
-        ofstream outputStream(outputPattern, ios::out | ios::binary);
-        outputStream.write((const char*) fileContents.data(), fileContents.size());
-        outputStream.close();
-        if (!g_quietMode) {
-            puts("Done.");
-        }
-        return 0;
+        container.setBlob({mip++, 0, 0}, data.get(), image.getWidth() * image.getHeight() *
+                container.info().glTypeSize * componentCount);
+    };
+    addLevel(sourceImage);
+    for (auto image : miplevels) {
+        addLevel(image);
+    }
+    vector<uint8_t> fileContents(container.getSerializedLength());
+    container.serialize(fileContents.data(), fileContents.size());
+    Path(spec.pattern).getParent().mkdirRecursive();
+    ofstream outputStream(spec.pattern, ios::out | ios::binary);
+    outputStream.write((const char*) fileContents.data(), fileContents.size());
+    outputStream.close();
+    if (!g_quietMode) {
+        puts("Done.");
     }
+    return true;
+}
 
-    if (g_ktx2Container) {
-        if (!g_quietMode) {
-            puts("Writing KTX2 file to disk...");
-        }
+static bool writeKtx2(const LinearImage& sourceImage, const vector<LinearImage>& miplevels,
+        const OutputSpec& spec) {
+    if (!g_quietMode) {
+        puts("Writing KTX2 file to disk...");
+    }
 
-        BasisEncoder::Builder builder(miplevels.size() + 1, 1);
-        using IntermediateFormat = BasisEncoder::IntermediateFormat;
-
-        size_t mipIndex = 0;
-        builder
-            .intermediateFormat((g_ktxCompression == UASTC || g_ktxCompression == UASTC_NORMALS) ?
-                    IntermediateFormat::UASTC : IntermediateFormat::ETC1S)
-            .grayscale(g_grayscale)
-            .linear(g_sourceIsLinear)
-            .quiet(g_quietMode)
-            .normals(g_ktxCompression == ETC1S_NORMALS || g_ktxCompression == UASTC_NORMALS)
-            .miplevel(mipIndex++, 0, sourceImage);
-
-        for (auto image : miplevels) {
-            builder.miplevel(mipIndex++, 0, image);
-        }
+    if (!g_basisJobPool) {
+        g_basisJobPool = std::make_unique<BasisEncoder::JobPool>();
+    }
 
-        BasisEncoder* encoder = builder.build();
-        if (!encoder) {
-            puts("Error while creating BasisU encoder.");
-            return 1;
-        }
+    BasisEncoder::Builder builder(miplevels.size() + 1, 1);
+    using IntermediateFormat = BasisEncoder::IntermediateFormat;
+
+    size_t mipIndex = 0;
+    builder
+        .intermediateFormat((g_ktxCompression == UASTC || g_ktxCompression == UASTC_NORMALS) ?
+                IntermediateFormat::UASTC : IntermediateFormat::ETC1S)
+        .grayscale(g_grayscale)
+        .linear(g_sourceIsLinear)
+        .quiet(g_quietMode)
+        .jobPool(g_basisJobPool.get())
+        .quality(g_basisQuality)
+        .normals(g_ktxCompression == ETC1S_NORMALS || g_ktxCompression == UASTC_NORMALS)
+        .miplevel(mipIndex++, 0, sourceImage);
 
-        bool success = encoder->encode();
-        if (!success) {
-            // Error message has already been printed.
-            return 1;
-        }
+    for (auto image : miplevels) {
+        builder.miplevel(mipIndex++, 0, image);
+    }
 
-        Path(outputPattern).getParent().mkdirRecursive();
-        ofstream outputStream(outputPattern, ios::out | ios::binary);
-        outputStream.write((const char*) encoder->getKtx2Data(), encoder->getKtx2ByteCount());
-        outputStream.close();
-        if (!g_quietMode) {
-            printf("Wrote %zu bytes to %s.\n", encoder->getKtx2ByteCount(), outputPattern.c_str());
-        }
-        delete encoder;
-        return 0;
+    std::unique_ptr<BasisEncoder> encoder(builder.build());
+    if (!encoder) {
+        puts("Error while creating BasisU encoder.");
+        return false;
+    }
+
+    bool success = encoder->encode();
+    if (!success) {
+        // Error message has already been printed.
+        return false;
     }
 
+    Path(spec.pattern).getParent().mkdirRecursive();
+    ofstream outputStream(spec.pattern, ios::out | ios::binary);
+    outputStream.write((const char*) encoder->getKtx2Data(), encoder->getKtx2ByteCount());
+    outputStream.close();
+    if (!g_quietMode) {
+        const BasisEncoder::Stats stats = encoder->getStats();
+        printf("Wrote %zu bytes to %s (convert %.1f ms, compress %.1f ms).\n",
+                encoder->getKtx2ByteCount(), spec.pattern.c_str(),
+                double(stats.conversionNanoseconds) / 1e6,
+                double(stats.compressionNanoseconds) / 1e6);
+    }
+    return true;
+}
+
+// Encodes each miplevel to its own file, with one job per level.
+static bool writeImageFiles(JobSystem& js, const vector<LinearImage>& miplevels,
+        const OutputSpec& spec) {
     if (!g_quietMode) {
         puts("Writing image files to disk...");
     }
 
+    enum class Status { OK, OPEN_FAILED, ENCODE_FAILED, WRITE_FAILED };
+    vector<std::string> paths(miplevels.size());
+    vector<Status> status(miplevels.size(), Status::OK);
+
     char path[256];
     uint32_t mip = 1; // start at 1 because 0 is the original image
-    for (auto image : miplevels) {
-        int result = snprintf(path, sizeof(path), outputPattern.c_str(), mip++);
+    for (auto& p : paths) {
+        int result = snprintf(path, sizeof(path), spec.pattern.c_str(), mip++);
         if (result < 0 || result >= sizeof(path)) {
             cerr << "Output pattern is too long." << endl;
-            return 1;
+            return false;
         }
-        Path(path).getParent().mkdirRecursive();
-        ofstream outputStream(path, ios::binary | ios::trunc);
-        if (!outputStream) {
-            cerr << "The output file cannot be opened: " << path << endl;
-        } else {
+        p = path;
+        Path(p).getParent().mkdirRecursive();
+    }
+
+    JobSystem::Job* parent = js.createJob();
+    for (size_t i = 0; i < miplevels.size(); i++) {
+        js.run(jobs::createJob(js, parent, [&, i]() {
+            ofstream outputStream(paths[i], ios::binary | ios::trunc);
+            if (!outputStream) {
+                status[i] = Status::OPEN_FAILED;
+                return;
+            }
+            LinearImage image = miplevels[i];
             if (g_filter == Filter::GAUSSIAN_NORMALS) {
                 image = vectorsToColors(image);
             }
-            if (!ImageEncoder::encode(outputStream, g_format, image, g_compressionString, path)) {
-                cerr << "An error occurred while encoding the image." << endl;
-                return 1;
+            if (!ImageEncoder::encode(outputStream, spec.format, image, g_compressionString,
+                    paths[i])) {
+                status[i] = Status::ENCODE_FAILED;
+                return;
             }
             outputStream.close();
             if (!outputStream) {
-                cerr << "An error occurred while writing the output file: " << path << endl;
-                return 1;
+                status[i] = Status::WRITE_FAILED;
             }
-        }
+        }));
     }
+    js.runAndWait(parent);
 
-    if (g_createGallery) {
-        if (!g_quietMode) {
-            puts("Generating mipmaps.html...");
+    bool success = true;
+    for (size_t i = 0; i < miplevels.size(); i++) {
+        switch (status[i]) {
+            case Status::OK:
+                break;
+            case Status::OPEN_FAILED:
+                cerr << "The output file cannot be opened: " << paths[i] << endl;
+                success = false;
+                break;
+            case Status::ENCODE_FAILED:
+                cerr << "An error occurred while encoding the image." << endl;
+                success = false;
+                break;
+            case Status::WRITE_FAILED:
+                cerr << "An error occurred while writing the output file: " << paths[i] << endl;
+                success = false;
+                break;
         }
+    }
+    return success;
+}
 
-        char tag[256];
-        mip = 1;
-        const char* pattern = R"(<image src="%s" width="%dpx" height="%dpx">)";
-        const uint32_t width = sourceImage.getWidth();
-        const uint32_t height = sourceImage.getHeight();
-        ofstream html("mipmaps.html", ios::trunc);
-        html << HTML_PREFIX;
-        int result = snprintf(tag, sizeof(tag), pattern, inputPath.c_str(), width, height);
+static bool writeGallery(const Path& inputPath, const LinearImage& sourceImage,
+        const vector<LinearImage>& miplevels, const OutputSpec& spec) {
+    if (!g_quietMode) {
+        puts("Generating mipmaps.html...");
+    }
+
+    char path[256];
+    char tag[256];
+    uint32_t mip = 1;
+    const char* pattern = R"(<image src="%s" width="%dpx" height="%dpx">)";
+    const uint32_t width = sourceImage.getWidth();
+    const uint32_t height = sourceImage.getHeight();
+    ofstream html("mipmaps.html", ios::trunc);
+    html << HTML_PREFIX;
+    int result = snprintf(tag, sizeof(tag), pattern, inputPath.c_str(), width, height);
+    if (result < 0 || result >= sizeof(tag)) {
+        cerr << "Output pattern is too long." << endl;
+        return false;
+    }
+    html << tag << std::endl;
+    for (size_t i = 0; i < miplevels.size(); i++) {
+        snprintf(path, sizeof(path), spec.pattern.c_str(), mip++);
+        result = snprintf(tag, sizeof(tag), pattern, path, width, height);
         if (result < 0 || result >= sizeof(tag)) {
             cerr << "Output pattern is too long." << endl;
-            return 1;
+            return false;
         }
         html << tag << std::endl;
-        for (auto image: miplevels) {
-            snprintf(path, sizeof(path), outputPattern.c_str(), mip++);
-            result = snprintf(tag, sizeof(tag), pattern, path, width, height);
-            if (result < 0 || result >= sizeof(tag)) {
-                cerr << "Output pattern is too long." << endl;
-                return 1;
-            }
-            html << tag << std::endl;
+    }
+    html << HTML_SUFFIX;
+    return true;
+}
+
+// Generates the miplevels of the given source image.
+static vector<LinearImage> generateMiplevels(JobSystem& js, const LinearImage& sourceImage) {
+    if (!g_quietMode) {
+        puts("Generating miplevels...");
+    }
+    uint32_t count = getMipmapCount(sourceImage);
+    count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
+    vector<LinearImage> miplevels(count);
+    generateMipmaps(js, sourceImage, g_filter, miplevels.data(), count);
+    return miplevels;
+}
+
+// Encodes the miplevels of the given source image and writes them out.
+static bool writeOutputs(JobSystem& js, const Path& inputPath, const LinearImage& sourceImage,
+        const vector<LinearImage>& miplevels, const OutputSpec& spec) {
+    bool success;
+    if (spec.ktx1Container) {
+        success = writeKtx1(sourceImage, miplevels, spec);
+    } else if (spec.ktx2Container) {
+        success = writeKtx2(sourceImage, miplevels, spec);
+    } else {
+        success = writeImageFiles(js, miplevels, spec);
+        // Every image would overwrite the same page, so there is no gallery in batch mode.
+        if (success && g_createGallery && g_batchManifest.empty()) {
+            success = writeGallery(inputPath, sourceImage, miplevels, spec);
+        }
+        if (success && !g_quietMode) {
+            puts("Done.");
+        }
+    }
+    return success;
+}
+
+// Generates the miplevels of the given source image and writes them out.
+static bool processImage(JobSystem& js, const Path& inputPath, const LinearImage& sourceImage,
+        const OutputSpec& spec, StageTimings* timings) {
+    Clock::time_point start = Clock::now();
+    const vector<LinearImage> miplevels = generateMiplevels(js, sourceImage);
+    timings->mipmaps += secondsSince(start);
+
+    start = Clock::now();
+    const bool success = writeOutputs(js, inputPath, sourceImage, miplevels, spec);
+    timings->encode += secondsSince(start);
+    return success;
+}
+
+// Returns a string that identifies all options that affect the output of mipgen.
+static std::string getOptionsKey() {
+    std::ostringstream key;
+    key << int(g_format) << g_formatSpecified << int(g_ktxCompression) << g_compressionString
+        << int(g_filter) << g_addAlpha << g_stripAlpha << g_grayscale << g_ktx1Container
+        << g_ktx2Container << g_sourceIsLinear << g_mipLevelCount << g_createGallery
+        << int(g_basisQuality);
+    return key.str();
+}
+
+// Processes every "<input_file> <output_pattern>" line of the manifest with a single job system.
+// While the miplevels of an image are generated, the next image is decoded and the previous one
+// is encoded by jobs. Items whose input file, output pattern and options have not changed since the
+// last successful run, and whose first output still exists, are skipped.
+static bool runBatch() {
+    BatchManifest manifest(g_batchManifest);
+    if (!manifest.isValid()) {
+        cerr << "Unable to read manifest: " << g_batchManifest << endl;
+        return false;
+    }
+    if (g_createGallery) {
+        cerr << "Warning: --page is ignored in batch mode." << endl;
+    }
+
+    struct Item {
+        Path inputPath;
+        OutputSpec spec;
+        BatchManifest::Hash hash;
+        LinearImage image;
+        vector<LinearImage> miplevels;
+        double decodeSeconds = 0;
+        double encodeSeconds = 0;
+        bool encoded = false;
+        JobSystem::Job* job = nullptr; // decodes the image, then encodes its miplevels
+    };
+
+    const BatchManifest::Hash optionsHash = BatchManifest::hashString(getOptionsKey());
+    size_t skipped = 0;
+    size_t failed = 0;
+    vector<Item> items;
+    for (auto const& entry : manifest.getEntries()) {
+        if (entry.size() != 2) {
+            cerr << "Manifest entries must be \"<input_file> <output_pattern>\": "
+                 << entry[0] << endl;
+            ++failed;
+            continue;
+        }
+        Item item{ Path(entry[0]), resolveOutput(entry[1]) };
+        item.hash = BatchManifest::hashFile(item.inputPath, optionsHash);
+        const std::string firstOutput = getFirstOutputPath(item.spec);
+        if (manifest.isUpToDate(item.spec.pattern, item.hash) && !firstOutput.empty() &&
+                Path(firstOutput).exists()) {
+            ++skipped;
+            continue;
+        }
+        items.push_back(std::move(item));
+    }
+
+    JobSystem js;
+    js.adopt();
+
+    auto startDecoding = [&js](Item& item) {
+        item.job = jobs::createJob(js, nullptr, [&item]() {
+            Clock::time_point start = Clock::now();
+            item.image = loadSourceImage(item.inputPath);
+            item.decodeSeconds = secondsSince(start);
+        });
+        js.runAndRetain(item.job);
+    };
+
+    auto startEncoding = [&js](Item& item) {
+        item.job = jobs::createJob(js, nullptr, [&js, &item]() {
+            Clock::time_point start = Clock::now();
+            item.encoded = writeOutputs(js, item.inputPath, item.image, item.miplevels,
+                    item.spec);
+            item.encodeSeconds = secondsSince(start);
+        });
+        js.runAndRetain(item.job);
+    };
+
+    StageTimings timings;
+    size_t processed = 0;
+    auto finishEncoding = [&](Item& item) {
+        js.waitAndRelease(item.job);
+        item.job = nullptr;
+        timings.encode += item.encodeSeconds;
+        if (item.encoded) {
+            manifest.setUpToDate(item.spec.pattern, item.hash);
+            ++processed;
+        } else {
+            ++failed;
+        }
+        item.image.reset();
+        item.miplevels.clear();
+    };
+
+    const Clock::time_point start = Clock::now();
+    if (!items.empty()) {
+        startDecoding(items[0]);
+    }
+    Item* encoding = nullptr;
+    for (size_t i = 0; i < items.size(); i++) {
+        Item& item = items[i];
+        js.waitAndRelease(item.job);
+        item.job = nullptr;
+        if (i + 1 < items.size()) {
+            startDecoding(items[i + 1]);
+        }
+        timings.decode += item.decodeSeconds;
+        if (!g_quietMode) {
+            printf("[%zu/%zu] %s\n", i + 1, items.size(), item.inputPath.c_str());
         }
-        html << HTML_SUFFIX;
+        if (!item.image.isValid()) {
+            ++failed;
+            continue;
+        }
+
+        Clock::time_point stageStart = Clock::now();
+        item.miplevels = generateMiplevels(js, item.image);
+        timings.mipmaps += secondsSince(stageStart);
+
+        // At most one item is being encoded while the next one is processed.
+        if (encoding) {
+            finishEncoding(*encoding);
+        }
+        startEncoding(item);
+        encoding = &item;
+    }
+    if (encoding) {
+        finishEncoding(*encoding);
+    }
+    const double total = secondsSince(start);
+
+    js.emancipate();
+
+    if (!manifest.saveStamps()) {
+        cerr << "Unable to write stamps for manifest: " << g_batchManifest << endl;
     }
 
     if (!g_quietMode) {
-        puts("Done.");
+        printf("Processed %zu images, skipped %zu, failed %zu in %.2fs.\n",
+                processed, skipped, failed, total);
+        printf("    decode %.2fs, mipmaps %.2fs, encode %.2fs\n",
+                timings.decode, timings.mipmaps, timings.encode);
+    }
+    return failed == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int optionIndex = handleArguments(argc, argv);
+    int numArgs = argc - optionIndex;
+
+    if (!g_scratchDirectory.empty()) {
+        LinearImage::setScratchDirectory(g_scratchDirectory.c_str());
+    }
+
+    if (!g_batchManifest.empty()) {
+        return runBatch() ? 0 : 1;
+    }
+
+    if (numArgs < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    Path inputPath(argv[optionIndex++]);
+    const OutputSpec spec = resolveOutput(argv[optionIndex]);
+
+    if (!g_quietMode) {
+        puts("Reading image...");
     }
+
+    LinearImage sourceImage = loadSourceImage(inputPath);
+    if (!sourceImage.isValid()) {
+        return 1;
+    }
+
+    JobSystem js;
+    js.adopt();
+    StageTimings timings;
+    const bool success = processImage(js, inputPath, sourceImage, spec, &timings);
+    js.emancipate();
+    return success ? 0 : 1;
 }
@@ -79,7 +79,8 @@ Examples:
     RESGEN -cp textures jungle.png beach.png
     > Generated files: textures.h, textures.S, textures.apple.S, textures.bin, textures.c
     > Generated symbols: TEXTURES_JUNGLE_DATA, TEXTURES_JUNGLE_SIZE,
-                         TEXTURES_BEACH_DATA, TEXTURES_BEACH_SIZE
+                         TEXTURES_BEACH_DATA, TEXTURES_BEACH_SIZE,
+                         TEXTURES_PACKAGE, TEXTURES_PACKAGE_SIZE
 )TXT";
 
 static const char* APPLE_ASM_TEMPLATE = R"ASM(
@@ -355,6 +356,29 @@ int main(int argc, char* argv[]) {
         offset += content.size();
     }
 
+    // Write the size of the whole package.
+    headerStream
+            << "    extern int " << package << "_SIZE;\n";
+
+    dataAsmStream
+            << package << "_SIZE:\n"
+            << "    .int " << offset << "\n";
+
+    asmStream
+            << "    .global " << package << "_SIZE;\n";
+
+    appleDataAsmStream
+            << "_" << package << "_SIZE:\n"
+            << "    .int " << offset << "\n";
+
+    appleAsmStream
+            << "    .global _" << package << "_SIZE;\n";
+
+    if (g_generateC) {
+        xxdDefinitions
+                << "int " << package << "_SIZE = " << offset << ";\n";
+    }
+
     headerStream << "}\n" << headerMacros.str();
     headerStream << "\n#endif\n";
 